@@ -1298,30 +1298,39 @@ void extract_code_using_cuobjdump(){
    std::string app_binary = get_app_binary(); 
 
 	char fname[1024];
-	snprintf(fname,1024,"_cuobjdump_complete_output_XXXXXX");
-	int fd=mkstemp(fname);
-	close(fd);
-	// Running cuobjdump using dynamic link to current process
-	snprintf(command,1000,"md5sum %s ", app_binary.c_str());
-	printf("Running md5sum using \"%s\"\n", command);
-	system(command);
-	// Running cuobjdump using dynamic link to current process
-	snprintf(command,1000,"$CUDA_INSTALL_PATH/bin/cuobjdump -ptx -elf -sass %s > %s", app_binary.c_str(), fname);
-	printf("Running cuobjdump using \"%s\"\n", command);
 	bool parse_output = true; 
-	int result = system(command);
-	if(result) {
-		if (context->get_device()->get_gpgpu()->get_config().experimental_lib_support() && (result == 65280)) {  
-			// Some CUDA application may exclusively use kernels provided by CUDA
-			// libraries (e.g. CUBLAS).  Skipping cuobjdump extraction from the
-			// executable for this case. 
-			// 65280 is the return code from cuobjdump denoting the specific error (tested on CUDA 4.0/4.1/4.2)
-			printf("WARNING: Failed to execute: %s\n", command); 
-			printf("         Executable binary does not contain any GPU kernel.\n"); 
-			parse_output = false; 
+	std::string cached = ptx_cache_path_for_file("cuobjdump", app_binary.c_str(), getenv("CUDA_INSTALL_PATH"));
+	if (ptx_cache_hit(cached)) {
+		// same binary content seen before (-gpgpu_ptx_cache_dir)
+		printf("Using cached cuobjdump output \"%s\"\n", cached.c_str());
+		snprintf(fname,1024,"%s",cached.c_str());
+	} else {
+		snprintf(fname,1024,"_cuobjdump_complete_output_XXXXXX");
+		int fd=mkstemp(fname);
+		close(fd);
+		// Running cuobjdump using dynamic link to current process
+		snprintf(command,1000,"md5sum %s ", app_binary.c_str());
+		printf("Running md5sum using \"%s\"\n", command);
+		system(command);
+		// Running cuobjdump using dynamic link to current process
+		snprintf(command,1000,"$CUDA_INSTALL_PATH/bin/cuobjdump -ptx -elf -sass %s > %s", app_binary.c_str(), fname);
+		printf("Running cuobjdump using \"%s\"\n", command);
+		int result = system(command);
+		if(result) {
+			if (context->get_device()->get_gpgpu()->get_config().experimental_lib_support() && (result == 65280)) {  
+				// Some CUDA application may exclusively use kernels provided by CUDA
+				// libraries (e.g. CUBLAS).  Skipping cuobjdump extraction from the
+				// executable for this case. 
+				// 65280 is the return code from cuobjdump denoting the specific error (tested on CUDA 4.0/4.1/4.2)
+				printf("WARNING: Failed to execute: %s\n", command); 
+				printf("         Executable binary does not contain any GPU kernel.\n"); 
+				parse_output = false; 
+			} else {
+				printf("ERROR: Failed to execute: %s\n", command); 
+				exit(1);
+			}
 		} else {
-			printf("ERROR: Failed to execute: %s\n", command); 
-			exit(1);
+			ptx_cache_store(cached, fname);
 		}
 	}
 
@@ -35,6 +35,7 @@
 #include "gpgpu-sim/gpu-sim.h"
 #include "option_parser.h"
 #include <algorithm>
+#include <pthread.h>
 #include "stdio.h"
 
 unsigned mem_access_t::sm_next_access_uid = 0;   
@@ -83,6 +84,9 @@ void gpgpu_functional_sim_config::reg_options(class OptionParser * opp)
    option_parser_register(opp, "-gpgpu_ptx_inst_debug_thread_uid", OPT_INT32, &g_ptx_inst_debug_thread_uid, 
                "Thread UID for executed instructions' debug output", 
                "1");
+   option_parser_register(opp, "-gpgpu_ptx_warp_exec", OPT_BOOL, &m_ptx_warp_exec, 
+               "Execute simple ALU instructions for a whole warp at once (functionally identical to per-thread execution)", 
+               "1");
 }
 
 void gpgpu_functional_sim_config::ptx_set_tex_cache_linesize(unsigned linesize)
@@ -93,12 +97,16 @@ void gpgpu_functional_sim_config::ptx_set_tex_cache_linesize(unsigned linesize)
 gpgpu_t::gpgpu_t( const gpgpu_functional_sim_config &config )
     : m_function_model_config(config)
 {
-   m_global_mem = new memory_space_impl<8192>("global",64*1024);
-   m_tex_mem = new memory_space_impl<8192>("tex",64*1024);
-   m_surf_mem = new memory_space_impl<8192>("surf",64*1024);
+   m_global_mem = new memory_space_impl<8192>("global");
+   m_tex_mem = new memory_space_impl<8192>("tex");
+   m_surf_mem = new memory_space_impl<8192>("surf");
 
    m_dev_malloc=GLOBAL_HEAP_START; 
 
+   m_record_readbacks = false;
+   m_replay_readbacks = false;
+   m_readback_kernel = 0;
+
    if(m_function_model_config.get_ptx_inst_debug_to_file() != 0) 
       ptx_inst_debug_file = fopen(m_function_model_config.get_ptx_inst_debug_file(), "w");
 }
@@ -153,8 +161,14 @@ void warp_inst_t::do_atomic(bool forceDo) {
     do_atomic( m_warp_active_mask,forceDo );
 }
 
+// atomics of warps simulated by different host threads (-gpgpu_sim_threads) 
+// must not interleave their read-modify-write of memory
+static pthread_mutex_t g_atomic_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 void warp_inst_t::do_atomic( const active_mask_t& access_mask,bool forceDo ) {
     assert( m_isatomic && (!m_empty||forceDo) );
+    if( g_ptx_sim_multithreaded ) 
+        pthread_mutex_lock(&g_atomic_mutex);
     for( unsigned i=0; i < m_config->warp_size; i++ )
     {
         if( access_mask.test(i) )
@@ -164,6 +178,29 @@ void warp_inst_t::do_atomic( const active_mask_t& access_mask,bool forceDo ) {
                 cb.function(cb.instruction, cb.thread);
         }
     }
+    if( g_ptx_sim_multithreaded ) 
+        pthread_mutex_unlock(&g_atomic_mutex);
+}
+
+void inst_t::set_reg_mask()
+{
+    int regs[MAX_INST_REGS] = { (int)out[0], (int)out[1], (int)out[2], (int)out[3], 
+                                (int)in[0], (int)in[1], (int)in[2], (int)in[3], pred, ar1, ar2 };
+    n_reg_words = 0;
+    for( unsigned i=0; i < MAX_INST_REGS; i++ ) {
+        if( regs[i] <= 0 ) 
+            continue;
+        unsigned word = regs[i] / 64;
+        unsigned w = 0;
+        while( w < n_reg_words && reg_word[w] != word ) 
+            w++;
+        if( w == n_reg_words ) {
+            reg_word[w] = word;
+            reg_bits[w] = 0;
+            n_reg_words++;
+        }
+        reg_bits[w] |= 1ULL << (regs[i] % 64);
+    }
 }
 
 void warp_inst_t::generate_mem_accesses()
@@ -350,56 +387,8 @@ void warp_inst_t::memory_coalescing_arch_13( bool is_write, mem_access_type acce
     }
     unsigned subwarp_size = m_config->warp_size / warp_parts;
 
-    for( unsigned subwarp=0; subwarp <  warp_parts; subwarp++ ) {
-        std::map<new_addr_type,transaction_info> subwarp_transactions;
-
-        // step 1: find all transactions generated by this subwarp
-        for( unsigned thread=subwarp*subwarp_size; thread<subwarp_size*(subwarp+1); thread++ ) {
-            if( !active(thread) )
-                continue;
-
-            unsigned data_size_coales = data_size;
-            unsigned num_accesses = 1;
-
-            if( space.get_type() == local_space || space.get_type() == param_space_local ) {
-               // Local memory accesses >4B were split into 4B chunks
-               if(data_size >= 4) {
-                  data_size_coales = 4;
-                  num_accesses = data_size/4;
-               }
-               // Otherwise keep the same data_size for sub-4B access to local memory
-            }
-
-
-            assert(num_accesses <= MAX_ACCESSES_PER_INSN_PER_THREAD);
-
-            for(unsigned access=0; access<num_accesses; access++) {
-                new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[access];
-                unsigned block_address = line_size_based_tag_func(addr,segment_size);
-                unsigned chunk = (addr&127)/32; // which 32-byte chunk within in a 128-byte chunk does this thread access?
-                transaction_info &info = subwarp_transactions[block_address];
-
-                // can only write to one segment
-                assert(block_address == line_size_based_tag_func(addr+data_size_coales-1,segment_size));
-
-                info.chunks.set(chunk);
-                info.active.set(thread);
-                unsigned idx = (addr&127);
-                for( unsigned i=0; i < data_size_coales; i++ )
-                    info.bytes.set(idx+i);
-            }
-        }
-
-        // step 2: reduce each transaction size, if possible
-        std::map< new_addr_type, transaction_info >::iterator t;
-        for( t=subwarp_transactions.begin(); t !=subwarp_transactions.end(); t++ ) {
-            new_addr_type addr = t->first;
-            const transaction_info &info = t->second;
-
-            memory_coalescing_arch_13_reduce_and_send(is_write, access_type, info, addr, segment_size);
-
-        }
-    }
+    for( unsigned subwarp=0; subwarp <  warp_parts; subwarp++ )
+        memory_coalescing_arch_13_subwarp(is_write, access_type, subwarp*subwarp_size, subwarp_size, segment_size, false);
 }
 
 void warp_inst_t::memory_coalescing_arch_13_atomic( bool is_write, mem_access_type access_type )
@@ -417,64 +406,129 @@ void warp_inst_t::memory_coalescing_arch_13_atomic( bool is_write, mem_access_ty
    }
    unsigned subwarp_size = m_config->warp_size / warp_parts;
 
-   for( unsigned subwarp=0; subwarp <  warp_parts; subwarp++ ) {
-       std::map<new_addr_type,std::list<transaction_info> > subwarp_transactions; // each block addr maps to a list of transactions
-
-       // step 1: find all transactions generated by this subwarp
-       for( unsigned thread=subwarp*subwarp_size; thread<subwarp_size*(subwarp+1); thread++ ) {
-           if( !active(thread) )
-               continue;
-
-           new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[0];
-           unsigned block_address = line_size_based_tag_func(addr,segment_size);
-           unsigned chunk = (addr&127)/32; // which 32-byte chunk within in a 128-byte chunk does this thread access?
-
-           // can only write to one segment
-           assert(block_address == line_size_based_tag_func(addr+data_size-1,segment_size));
-
-           // Find a transaction that does not conflict with this thread's accesses
-           bool new_transaction = true;
-           std::list<transaction_info>::iterator it;
-           transaction_info* info;
-           for(it=subwarp_transactions[block_address].begin(); it!=subwarp_transactions[block_address].end(); it++) {
-              unsigned idx = (addr&127);
-              if(not it->test_bytes(idx,idx+data_size-1)) {
-                 new_transaction = false;
-                 info = &(*it);
-                 break;
-              }
-           }
-           if(new_transaction) {
-              // Need a new transaction
-              subwarp_transactions[block_address].push_back(transaction_info());
-              info = &subwarp_transactions[block_address].back();
-           }
-           assert(info);
-
-           info->chunks.set(chunk);
-           info->active.set(thread);
-           unsigned idx = (addr&127);
-           for( unsigned i=0; i < data_size; i++ ) {
-               assert(!info->bytes.test(idx+i));
-               info->bytes.set(idx+i);
-           }
-       }
+   for( unsigned subwarp=0; subwarp <  warp_parts; subwarp++ )
+       memory_coalescing_arch_13_subwarp(is_write, access_type, subwarp*subwarp_size, subwarp_size, segment_size, true);
+}
 
-       // step 2: reduce each transaction size, if possible
-       std::map< new_addr_type, std::list<transaction_info> >::iterator t_list;
-       for( t_list=subwarp_transactions.begin(); t_list !=subwarp_transactions.end(); t_list++ ) {
-           // For each block addr
-           new_addr_type addr = t_list->first;
-           const std::list<transaction_info>& transaction_list = t_list->second;
-
-           std::list<transaction_info>::const_iterator t;
-           for(t=transaction_list.begin(); t!=transaction_list.end(); t++) {
-               // For each transaction
-               const transaction_info &info = *t;
-               memory_coalescing_arch_13_reduce_and_send(is_write, access_type, info, addr, segment_size);
-           }
+// A transaction being formed by the coalescer.  Plain words rather than
+// bitsets so the table below can live on the stack without being cleared.
+struct coalescer_transaction {
+    new_addr_type addr;
+    unsigned long long bytes[2]; // byte mask within the 128-byte chunk
+    unsigned long long active;   // threads in this transaction
+    unsigned chunks;             // 32-byte chunks accessed
+};
+
+// set bits [idx, idx+size) of a 128-bit mask held in two words (size <= 64)
+static inline void coalescer_byte_range( unsigned idx, unsigned size, unsigned long long mask[2] )
+{
+    unsigned long long ones = (size >= 64) ? ~0ULL : ((1ULL << size) - 1);
+    mask[0] = mask[1] = 0;
+    if( idx < 64 ) {
+        mask[0] = ones << idx;
+        if( idx + size > 64 )
+            mask[1] = ones >> (64 - idx);
+    } else {
+        mask[1] = ones << (idx - 64);
+    }
+}
+
+/**
+ * Finds all transactions generated by one subwarp and sends them, in order of
+ * segment address, to memory_coalescing_arch_13_reduce_and_send.  Regular
+ * accesses merge every thread that touches a segment into one transaction.
+ * For atomics a thread joins the first transaction for its segment that does
+ * not already access any of its bytes, otherwise it starts a new one.
+ */
+void warp_inst_t::memory_coalescing_arch_13_subwarp( bool is_write, mem_access_type access_type,
+                                                     unsigned first_thread, unsigned subwarp_size,
+                                                     unsigned segment_size, bool atomic )
+{
+    assert( MAX_WARP_SIZE <= 64 );
+    coalescer_transaction trans[MAX_WARP_SIZE*MAX_ACCESSES_PER_INSN_PER_THREAD];
+    unsigned n_trans = 0;
+    unsigned last = 0;
+
+    unsigned data_size_coales = data_size;
+    unsigned num_accesses = 1;
+    if( !atomic && (space.get_type() == local_space || space.get_type() == param_space_local) ) {
+       // Local memory accesses >4B were split into 4B chunks
+       if(data_size >= 4) {
+          data_size_coales = 4;
+          num_accesses = data_size/4;
        }
-   }
+       // Otherwise keep the same data_size for sub-4B access to local memory
+    }
+    assert(num_accesses <= MAX_ACCESSES_PER_INSN_PER_THREAD);
+
+    // step 1: find all transactions generated by this subwarp
+    for( unsigned thread=first_thread; thread < first_thread+subwarp_size; thread++ ) {
+        if( !active(thread) )
+            continue;
+
+        for(unsigned access=0; access<num_accesses; access++) {
+            new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[access];
+            unsigned block_address = line_size_based_tag_func(addr,segment_size);
+            unsigned idx = (addr&127);
+
+            // can only write to one segment
+            assert(block_address == line_size_based_tag_func(addr+data_size_coales-1,segment_size));
+
+            unsigned long long bytes[2];
+            coalescer_byte_range(idx, data_size_coales, bytes);
+
+            unsigned t;
+            if( atomic ) {
+                for( t=0; t < n_trans; t++ ) {
+                    if( trans[t].addr == block_address && 
+                        !((trans[t].bytes[0] & bytes[0]) | (trans[t].bytes[1] & bytes[1])) )
+                        break;
+                }
+            } else if( n_trans && trans[last].addr == block_address ) {
+                t = last; // neighbouring threads usually share a segment
+            } else {
+                for( t=0; t < n_trans && trans[t].addr != block_address; t++ ) 
+                    ;
+            }
+            if( t == n_trans ) {
+                trans[t].addr = block_address;
+                trans[t].bytes[0] = trans[t].bytes[1] = 0;
+                trans[t].active = 0;
+                trans[t].chunks = 0;
+                n_trans++;
+            }
+            last = t;
+
+            trans[t].chunks |= 1 << (idx/32); // which 32-byte chunk within in a 128-byte chunk does this thread access?
+            trans[t].active |= 1ULL << thread;
+            trans[t].bytes[0] |= bytes[0];
+            trans[t].bytes[1] |= bytes[1];
+        }
+    }
+
+    // step 2: order transactions by segment address (stable, so atomic
+    // transactions to the same segment keep their creation order)
+    unsigned short order[MAX_WARP_SIZE*MAX_ACCESSES_PER_INSN_PER_THREAD];
+    for( unsigned i=0; i < n_trans; i++ ) {
+        unsigned j = i;
+        while( j > 0 && trans[order[j-1]].addr > trans[i].addr ) {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    // step 3: reduce each transaction size, if possible
+    for( unsigned i=0; i < n_trans; i++ ) {
+        const coalescer_transaction &t = trans[order[i]];
+        transaction_info info;
+        info.chunks = std::bitset<4>(t.chunks);
+        info.active = active_mask_t(t.active);
+        info.bytes = mem_access_byte_mask_t(t.bytes[1]);
+        info.bytes <<= 64;
+        info.bytes |= mem_access_byte_mask_t(t.bytes[0]);
+        memory_coalescing_arch_13_reduce_and_send(is_write, access_type, info, t.addr, segment_size);
+    }
 }
 
 void warp_inst_t::memory_coalescing_arch_13_reduce_and_send( bool is_write, mem_access_type access_type, const transaction_info &info, new_addr_type addr, unsigned segment_size )
@@ -550,7 +604,7 @@ kernel_info_t::kernel_info_t( dim3 gridDim, dim3 blockDim, class function_info *
     m_next_tid=m_next_cta;
     m_num_cores_running=0;
     m_uid = m_next_uid++;
-    m_param_mem = new memory_space_impl<8192>("param",64*1024);
+    m_param_mem = new memory_space_impl<8192>("param");
 }
 
 kernel_info_t::~kernel_info_t()
@@ -855,6 +909,16 @@ void simt_stack::update( simt_mask_t &thread_done, addr_vector_t &next_pc, addre
 
 void core_t::execute_warp_inst_t(warp_inst_t &inst, unsigned warpId)
 {
+    if(warpId==(unsigned (-1)))
+        warpId = inst.warp_id();
+    active_mask_t active = inst.get_active_mask();
+    if( ptx_exec_warp_inst(inst, &m_thread[m_warp_size*warpId], m_warp_size) ) {
+        for ( unsigned t=0; t < m_warp_size; t++ ) {
+            if( active.test(t) ) 
+                checkExecutionStatusAndUpdate(inst,t,m_warp_size*warpId+t);
+        }
+        return;
+    }
     for ( unsigned t=0; t < m_warp_size; t++ ) {
         if( inst.active(t) ) {
             if(warpId==(unsigned (-1)))
@@ -877,6 +941,13 @@ void core_t::updateSIMTStack(unsigned warpId, warp_inst_t * inst)
 {
     simt_mask_t thread_done;
     addr_vector_t next_pc;
+    getSIMTStackUpdate(warpId,inst,thread_done,next_pc);
+    m_simt_stack[warpId]->update(thread_done,next_pc,inst->reconvergence_pc, inst->op, warpId);
+}
+
+//! Collect the per-thread exit status and next pc of a warp after it executed inst
+void core_t::getSIMTStackUpdate(unsigned warpId, warp_inst_t * inst, simt_mask_t &thread_done, addr_vector_t &next_pc)
+{
     unsigned wtid = warpId * m_warp_size;
     for (unsigned i = 0; i < m_warp_size; i++) {
         if( ptx_thread_done(wtid+i) ) {
@@ -888,7 +959,6 @@ void core_t::updateSIMTStack(unsigned warpId, warp_inst_t * inst)
             next_pc.push_back( m_thread[wtid+i]->get_pc() );
         }
     }
-    m_simt_stack[warpId]->update(thread_done,next_pc,inst->reconvergence_pc, inst->op, warpId);
 }
 
 //! Get the warp to be executed using the data taken form the SIMT stack
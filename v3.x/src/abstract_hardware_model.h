@@ -420,6 +420,7 @@ public:
     const char* get_ptx_inst_debug_file() const  { return g_ptx_inst_debug_file; }
     int         get_ptx_inst_debug_thread_uid() const { return g_ptx_inst_debug_thread_uid; }
     unsigned    get_texcache_linesize() const { return m_texcache_linesize; }
+    bool        warp_exec() const { return m_ptx_warp_exec; }
 
 private:
     // PTX options
@@ -433,17 +434,36 @@ private:
     int   g_ptx_inst_debug_thread_uid;
 
     unsigned m_texcache_linesize;
+
+    int m_ptx_warp_exec;
 };
 
 class gpgpu_t {
 public:
     gpgpu_t( const gpgpu_functional_sim_config &config );
+    virtual ~gpgpu_t() {}
     void* gpu_malloc( size_t size );
     void* gpu_mallocarray( size_t count );
     void  gpu_memset( size_t dst_start_addr, int c, size_t count );
     void  memcpy_to_gpu( size_t dst_start_addr, const void *src, size_t count );
     void  memcpy_from_gpu( void *dst, size_t src_start_addr, size_t count );
     void  memcpy_gpu_to_gpu( size_t dst, size_t src, size_t count );
+    // functional state saved at kernel boundaries: device memory contents and allocations
+    void  checkpoint( FILE *fp ) const;
+    void  restore( FILE *fp );
+    // device-to-host copies (memcpy_from_gpu, also used by copies from symbols)
+    // can be recorded together with the uid of the last launched kernel, and 
+    // later returned again instead of reading device memory that does not 
+    // hold the results of skipped kernels (see -gpgpu_resume_kernel)
+    void  record_readbacks( bool enable ) { m_record_readbacks = enable; }
+    void  replay_readbacks( bool enable ) { m_replay_readbacks = enable; }
+    void  set_readback_kernel( unsigned uid ) { m_readback_kernel = uid; }
+    void  save_readbacks( FILE *fp ) const;
+    void  load_readbacks( FILE *fp, bool replay );
+    size_t num_replay_readbacks() const { return m_replay_readback_list.size(); }
+    // returns false if dst has to be read from device memory
+    virtual bool replay_readback( void *dst, size_t src_start_addr, size_t count );
+    virtual void record_readback( const void *data, size_t src_start_addr, size_t count );
     
     class memory_space *get_global_memory() { return m_global_mem; }
     class memory_space *get_tex_memory() { return m_tex_mem; }
@@ -491,6 +511,17 @@ protected:
     class memory_space *m_surf_mem;
     
     unsigned long long m_dev_malloc;
+
+    struct readback_t {
+       unsigned m_kernel_uid; // last kernel launched before the copy
+       size_t m_addr;
+       std::vector<unsigned char> m_data;
+    };
+    bool m_record_readbacks;
+    bool m_replay_readbacks;
+    unsigned m_readback_kernel;
+    std::list<readback_t> m_record_readback_list;
+    std::list<readback_t> m_replay_readback_list; // still to be returned, in order
     
     std::map<std::string, const struct textureReference*> m_NameToTextureRef;
     std::map<const struct textureReference*,const struct cudaArray*> m_TextureRefToCudaArray;
@@ -657,7 +688,7 @@ public:
 private:
    void init() 
    {
-      m_uid=++sm_next_access_uid;
+      m_uid=__sync_add_and_fetch(&sm_next_access_uid,1);
       m_addr=0;
       m_req_size=0;
    }
@@ -689,6 +720,8 @@ public:
 
 // the maximum number of destination, source, or address uarch operands in a instruction
 #define MAX_REG_OPERANDS 8
+// the maximum number of registers read or written by an instruction (out, in, pred, ar1, ar2)
+#define MAX_INST_REGS 11
 
 struct dram_callback_t {
    dram_callback_t() { function=NULL; instruction=NULL; thread=NULL; }
@@ -723,6 +756,7 @@ public:
             arch_reg.src[i] = -1;
             arch_reg.dst[i] = -1;
         }
+        n_reg_words=0;
         isize=0;
     }
     bool valid() const { return m_decoded; }
@@ -762,6 +796,12 @@ public:
         int src[MAX_REG_OPERANDS];
     } arch_reg;
     //int arch_reg[MAX_REG_OPERANDS]; // register number for bank conflict evaluation
+    // out, in, pred, ar1 and ar2 as the nonzero 64-bit words of a register 
+    // bitmask (register r is bit r%64 of word r/64), for the scoreboard
+    unsigned n_reg_words;
+    unsigned reg_word[MAX_INST_REGS];
+    unsigned long long reg_bits[MAX_INST_REGS];
+    void set_reg_mask(); // call once the register operands are decoded
     unsigned latency; // operation latency 
     unsigned initiation_interval;
 
@@ -816,7 +856,7 @@ public:
     {
         m_warp_active_mask = mask;
         m_warp_issued_mask = mask; 
-        m_uid = ++sm_next_uid;
+        m_uid = __sync_add_and_fetch(&sm_next_uid,1);
         m_warp_id = warp_id;
         m_dynamic_warp_id = dynamic_warp_id;
         issue_cycle = cycle;
@@ -864,6 +904,7 @@ public:
     void generate_mem_accesses();
     void memory_coalescing_arch_13( bool is_write, mem_access_type access_type );
     void memory_coalescing_arch_13_atomic( bool is_write, mem_access_type access_type );
+    void memory_coalescing_arch_13_subwarp( bool is_write, mem_access_type access_type, unsigned first_thread, unsigned subwarp_size, unsigned segment_size, bool atomic );
     void memory_coalescing_arch_13_reduce_and_send( bool is_write, mem_access_type access_type, const transaction_info &info, new_addr_type addr, unsigned segment_size );
 
     void add_callback( unsigned lane_id, 
@@ -1011,6 +1052,7 @@ class core_t {
         void execute_warp_inst_t(warp_inst_t &inst, unsigned warpId =(unsigned)-1);
         bool  ptx_thread_done( unsigned hw_thread_id ) const ;
         void updateSIMTStack(unsigned warpId, warp_inst_t * inst);
+        void getSIMTStackUpdate(unsigned warpId, warp_inst_t * inst, simt_mask_t &thread_done, addr_vector_t &next_pc);
         void initilizeSIMTStack(unsigned warp_count, unsigned warps_size);
         void deleteSIMTStack();
         warp_inst_t getExecuteWarp(unsigned warpId);
@@ -0,0 +1,192 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Inderpreet Singh, Timothy Rogers,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Drives an L1D (write-through, "l1_cache") or an L2 (write-back, 
+// "l2_cache") data cache with a mix of streaming, strided and hot-set 
+// accesses, a quarter of them writes, and a lower level that returns reads 
+// after a fixed latency.  Reports the hit, miss and reservation fail counts, 
+// the number of write and read requests sent, the heap allocations per 
+// access and the time per access.  The counts depend only on the cache 
+// model, so they can be compared between versions of gpu-cache.cc.
+//
+//    cache_bench [-l2 1] [-n_access <n>] [-l1d_config <cfg>] [-l2_config <cfg>]
+//                [-gpgpu_mem_address_mask <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <deque>
+#include "../gpgpu-sim/gpu-cache.h"
+#include "../gpgpu-sim/gpu-sim.h"
+#include "../option_parser.h"
+
+// normally defined by the rest of gpgpu-sim, none of which the caches use
+unsigned long long gpu_sim_cycle = 0;
+unsigned long long gpu_tot_sim_cycle = 0;
+unsigned mem_access_t::sm_next_access_uid = 0;
+unsigned LOGB2( unsigned v ) { unsigned r = 0; while( v >>= 1 ) r++; return r; }
+const char *mem_access_type_str( enum mem_access_type access_type ) { return ""; }
+void shader_cache_access_log( int logger_type, int type, int miss ) {}
+void warp_inst_t::do_atomic( const active_mask_t &access_mask, bool forceDo ) { abort(); }
+void warp_inst_t::print( FILE *fout ) const {}
+
+// every allocation made by the cache model goes through here; neither is 
+// inlined, so gcc does not pair malloc() and free() with new and delete 
+// expressions
+static unsigned long long g_n_heap_alloc = 0;
+__attribute__((noinline)) void *operator new( size_t n ) 
+{ 
+   g_n_heap_alloc++; 
+   void *p = malloc(n); 
+   if( !p ) 
+      abort();
+   return p; 
+}
+__attribute__((noinline)) void operator delete( void *p ) throw() { free(p); }
+
+// lower level: accepts every request; the driver returns the reads
+class bench_memport : public mem_fetch_interface {
+public:
+   virtual bool full( unsigned size, bool write ) const { return false; }
+   virtual void push( mem_fetch *mf ) { m_sent.push_back(mf); }
+   std::deque<mem_fetch*> m_sent;
+};
+
+class bench_allocator : public mem_fetch_allocator {
+public:
+   bench_allocator( const memory_config *config ) : m_config(config) {}
+   virtual mem_fetch *alloc( new_addr_type addr, mem_access_type type, unsigned size, bool wr ) const
+   {
+      mem_access_t access( type, addr, size, wr );
+      return new mem_fetch( access, NULL, wr?WRITE_PACKET_SIZE:READ_PACKET_SIZE, -1, 0, 0, m_config );
+   }
+   virtual mem_fetch *alloc( const class warp_inst_t &inst, const mem_access_t &access ) const { abort(); }
+private:
+   const memory_config *m_config;
+};
+
+#define RETURN_LATENCY 100
+
+int main( int argc, char **argv )
+{
+   bool l2 = false;
+   unsigned n_access = 0;
+   memory_config mcfg;
+   l2_cache_config l2cfg;
+   cache_config l1cfg;
+
+   option_parser_t opp = option_parser_create();
+   option_parser_register(opp, "-l2", OPT_BOOL, &l2, "drive the L2 configuration instead of the L1D", "0");
+   option_parser_register(opp, "-n_access", OPT_UINT32, &n_access, "number of accesses", "3000000");
+   option_parser_register(opp, "-l1d_config", OPT_CSTR, &l1cfg.m_config_string, 
+                          "L1D configuration (as -gpgpu_cache:dl1)", "32:128:4,L:L:m:N,A:32:8,8");
+   option_parser_register(opp, "-l2_config", OPT_CSTR, &l2cfg.m_config_string, 
+                          "L2 configuration (as -gpgpu_cache:dl2)", "64:128:8,L:B:m:W,A:32:4,4:0,32");
+   mcfg.m_address_mapping.addrdec_setoption(opp);
+   // GTX480 address mapping unless overridden on the command line
+   option_parser_delimited_string(opp, "-gpgpu_mem_address_mask 1", " ");
+   option_parser_cmdline(opp, argc, (const char**)argv);
+   option_parser_print(opp, stdout);
+
+   // GTX480: 6 memory channels with 2 sub partitions each
+   mcfg.m_address_mapping.init(6, 2);
+   mcfg.icnt_flit_size = 32;
+
+   bench_memport port;
+   bench_allocator allocator(&mcfg);
+   data_cache *cache;
+   if( l2 ) {
+      l2cfg.init(&mcfg.m_address_mapping);
+      cache = new l2_cache("L2", l2cfg, -1, -1, &port, &allocator, IN_PARTITION_L2_MISS_QUEUE);
+   } else {
+      l1cfg.init(l1cfg.m_config_string, FuncCachePreferNone);
+      cache = new l1_cache("L1D", l1cfg, 0, 0, &port, &allocator, IN_L1D_MISS_QUEUE);
+   }
+
+   unsigned seed = 12345;
+   unsigned long long outcome[NUM_CACHE_REQUEST_STATUS] = {0};
+   unsigned long long writes_sent = 0, reads_sent = 0;
+   std::deque<std::pair<unsigned,mem_fetch*> > returns;
+   unsigned long long n_heap_alloc_start = g_n_heap_alloc;
+   clock_t start = clock();
+   unsigned issued = 0;
+   for( unsigned t = 0; issued < n_access; t++ ) {
+      gpu_sim_cycle = t;
+      cache->cycle();
+      while( !port.m_sent.empty() ) {
+         mem_fetch *mf = port.m_sent.front(); 
+         port.m_sent.pop_front();
+         if( mf->get_is_write() ) 
+            delete mf; // writes and write-backs need no reply
+         else 
+            returns.push_back(std::make_pair(t + RETURN_LATENCY, mf));
+      }
+      while( !returns.empty() && returns.front().first <= t && cache->fill_port_free() ) {
+         cache->fill(returns.front().second, t);
+         returns.pop_front();
+      }
+      while( cache->access_ready() ) 
+         delete cache->next_access();
+
+      // two accesses per cycle: streaming, strided and hot-set
+      for( unsigned k = 0; k < 2; k++ ) {
+         unsigned r = rand_r(&seed);
+         new_addr_type addr;
+         switch( r % 3 ) {
+         case 0: addr = (new_addr_type)issued * 32; break;
+         case 1: addr = (new_addr_type)(issued % 4096) * 4096; break;
+         default: addr = (new_addr_type)(rand_r(&seed) % 512) * 128; break;
+         }
+         bool wr = ((r >> 8) % 4 == 0);
+         mem_access_t access( wr? GLOBAL_ACC_W : GLOBAL_ACC_R, addr, 32, wr );
+         mem_fetch *mf = new mem_fetch( access, NULL, wr?WRITE_PACKET_SIZE:READ_PACKET_SIZE, -1, 0, 0, &mcfg );
+         cache_event_list events;
+         enum cache_request_status status = cache->access( addr, mf, t, events );
+         outcome[status]++;
+         writes_sent += was_write_sent(events);
+         reads_sent += was_read_sent(events);
+         // the cache keeps the request on a miss, and the L1D also on a 
+         // write hit, which it sends on to the lower level
+         if( status == RESERVATION_FAIL || (status == HIT && (l2 || !wr)) ) 
+            delete mf;
+         issued++;
+      }
+   }
+   double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+   unsigned long long n_heap_alloc = g_n_heap_alloc - n_heap_alloc_start;
+
+   printf("%s: %u accesses: hit %llu hit_reserved %llu miss %llu reservation_fail %llu\n",
+          l2?"L2":"L1D", issued, outcome[HIT], outcome[HIT_RESERVED], outcome[MISS], 
+          outcome[RESERVATION_FAIL]);
+   printf("%s: writes sent %llu, reads sent %llu\n", l2?"L2":"L1D", writes_sent, reads_sent);
+   printf("%s: %llu heap allocations (%.3f per access), %.1f ns per access\n", l2?"L2":"L1D", 
+          n_heap_alloc, (double)n_heap_alloc/issued, secs*1e9/issued);
+   delete cache;
+   option_parser_destroy(opp);
+   return 0;
+}
@@ -0,0 +1,285 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Inderpreet Singh, Timothy Rogers,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Checks warp_inst_t::memory_coalescing_arch_13 and _atomic against the 
+// std::map based coalescer they replaced, on random warps: every access in 
+// m_accessq (type, address, size, write flag, thread mask and byte mask) and 
+// their order must be identical.  Also reports the time per instruction of 
+// both.
+//
+//    coalescer_test [trials]     (default 300000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <map>
+#include <list>
+#include "../abstract_hardware_model.h"
+#include "../option_parser.h"
+#include "../cuda-sim/ptx_sim.h"
+
+address_type line_size_based_tag_func( new_addr_type address, new_addr_type line_size );
+
+// normally defined by gpgpu-sim, cuda-sim and the option parser, none of 
+// which the coalescer uses (memory spaces come from cuda-sim/memory.cc)
+unsigned long long gpu_sim_cycle = 0;
+unsigned long long gpu_tot_sim_cycle = 0;
+bool g_ptx_sim_multithreaded = false;
+address_type get_return_pc( void *thd ) { abort(); }
+const warp_inst_t *ptx_fetch_inst( address_type pc ) { abort(); }
+void ptx_print_insn( address_type pc, FILE *fp ) { abort(); }
+void ptx_file_line_stats_add_latency( unsigned pc, unsigned latency ) {}
+void ptx_file_line_stats_add_warp_divergence( unsigned pc, unsigned n_way_divergence ) {}
+void ptx_file_line_stats_add_uncoalesced_gmem( unsigned pc, unsigned n_access ) {}
+void ptx_file_line_stats_add_smem_bank_conflict( unsigned pc, unsigned n_way_bkconflict ) {}
+void option_parser_register( option_parser_t opp, const char *name, enum option_dtype type, 
+                             void *variable, const char *desc, const char *defaultvalue ) {}
+void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id ) { abort(); }
+void hit_watchpoint( unsigned watchpoint_num, ptx_thread_info *thd, const ptx_instruction *pI ) { abort(); }
+bool ptx_exec_warp_inst( warp_inst_t &inst, class ptx_thread_info **thread, unsigned warp_size ) { abort(); }
+
+class test_core_config : public core_config {
+public:
+   test_core_config( unsigned mem_warp_parts ) 
+   {
+      warp_size = 32;
+      gpgpu_coalesce_arch = 13;
+      this->mem_warp_parts = mem_warp_parts;
+      m_valid = true;
+   }
+   virtual void init() {}
+};
+
+class coalescer_test_inst : public warp_inst_t {
+public:
+   coalescer_test_inst( const core_config *config, unsigned size, memory_space_t sp ) 
+      : warp_inst_t(config) 
+   { 
+      data_size = size; 
+      space = sp; 
+   }
+
+   // the coalescer as it was before memory_coalescing_arch_13_subwarp
+   void reference_coalescing_arch_13( bool is_write, mem_access_type access_type )
+   {
+      unsigned segment_size = 0;
+      unsigned warp_parts = m_config->mem_warp_parts;
+      switch( data_size ) {
+      case 1: segment_size = 32; break;
+      case 2: segment_size = 64; break;
+      case 4: case 8: case 16: segment_size = 128; break;
+      }
+      unsigned subwarp_size = m_config->warp_size / warp_parts;
+
+      for( unsigned subwarp=0; subwarp <  warp_parts; subwarp++ ) {
+         std::map<new_addr_type,transaction_info> subwarp_transactions;
+
+         for( unsigned thread=subwarp*subwarp_size; thread<subwarp_size*(subwarp+1); thread++ ) {
+            if( !active(thread) )
+               continue;
+            unsigned data_size_coales = data_size;
+            unsigned num_accesses = 1;
+            if( space.get_type() == local_space || space.get_type() == param_space_local ) {
+               if(data_size >= 4) {
+                  data_size_coales = 4;
+                  num_accesses = data_size/4;
+               }
+            }
+            for(unsigned access=0; access<num_accesses; access++) {
+               new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[access];
+               unsigned block_address = line_size_based_tag_func(addr,segment_size);
+               unsigned chunk = (addr&127)/32;
+               transaction_info &info = subwarp_transactions[block_address];
+               info.chunks.set(chunk);
+               info.active.set(thread);
+               unsigned idx = (addr&127);
+               for( unsigned i=0; i < data_size_coales; i++ )
+                  info.bytes.set(idx+i);
+            }
+         }
+         std::map< new_addr_type, transaction_info >::iterator t;
+         for( t=subwarp_transactions.begin(); t !=subwarp_transactions.end(); t++ ) 
+            memory_coalescing_arch_13_reduce_and_send(is_write, access_type, t->second, t->first, segment_size);
+      }
+   }
+
+   void reference_coalescing_arch_13_atomic( bool is_write, mem_access_type access_type )
+   {
+      unsigned segment_size = 0;
+      unsigned warp_parts = 2;
+      switch( data_size ) {
+      case 1: segment_size = 32; break;
+      case 2: segment_size = 64; break;
+      case 4: case 8: case 16: segment_size = 128; break;
+      }
+      unsigned subwarp_size = m_config->warp_size / warp_parts;
+
+      for( unsigned subwarp=0; subwarp <  warp_parts; subwarp++ ) {
+         std::map<new_addr_type,std::list<transaction_info> > subwarp_transactions;
+
+         for( unsigned thread=subwarp*subwarp_size; thread<subwarp_size*(subwarp+1); thread++ ) {
+            if( !active(thread) )
+               continue;
+            new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[0];
+            unsigned block_address = line_size_based_tag_func(addr,segment_size);
+            unsigned chunk = (addr&127)/32;
+            unsigned idx = (addr&127);
+            transaction_info* info = NULL;
+            std::list<transaction_info>::iterator it;
+            for(it=subwarp_transactions[block_address].begin(); it!=subwarp_transactions[block_address].end(); it++) {
+               if( !it->test_bytes(idx,idx+data_size-1) ) {
+                  info = &(*it);
+                  break;
+               }
+            }
+            if( info == NULL ) {
+               subwarp_transactions[block_address].push_back(transaction_info());
+               info = &subwarp_transactions[block_address].back();
+            }
+            info->chunks.set(chunk);
+            info->active.set(thread);
+            for( unsigned i=0; i < data_size; i++ ) 
+               info->bytes.set(idx+i);
+         }
+         std::map< new_addr_type, std::list<transaction_info> >::iterator t_list;
+         for( t_list=subwarp_transactions.begin(); t_list !=subwarp_transactions.end(); t_list++ ) {
+            std::list<transaction_info>::const_iterator t;
+            for(t=t_list->second.begin(); t!=t_list->second.end(); t++) 
+               memory_coalescing_arch_13_reduce_and_send(is_write, access_type, *t, t_list->first, segment_size);
+         }
+      }
+   }
+
+   void coalesce( bool reference, bool atomic, bool is_write )
+   {
+      m_accessq.clear();
+      if( reference ) {
+         if( atomic ) reference_coalescing_arch_13_atomic(is_write,GLOBAL_ACC_R);
+         else reference_coalescing_arch_13(is_write,GLOBAL_ACC_R);
+      } else {
+         if( atomic ) memory_coalescing_arch_13_atomic(is_write,GLOBAL_ACC_R);
+         else memory_coalescing_arch_13(is_write,GLOBAL_ACC_R);
+      }
+   }
+
+   const std::list<mem_access_t> &accessq() const { return m_accessq; }
+};
+
+static bool same_access( const mem_access_t &a, const mem_access_t &b )
+{
+   return a.get_type() == b.get_type() && a.get_addr() == b.get_addr() && 
+          a.get_size() == b.get_size() && a.is_write() == b.is_write() && 
+          a.get_warp_mask() == b.get_warp_mask() && a.get_byte_mask() == b.get_byte_mask();
+}
+
+static double wall_time()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC,&t);
+   return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+int main( int argc, char **argv )
+{
+   unsigned n_trials = (argc > 1)? atoi(argv[1]) : 300000;
+   const unsigned warp_parts[] = { 1, 2, 4 };
+   const unsigned sizes[] = { 1, 2, 4, 8, 16 };
+   test_core_config *configs[3];
+   for( unsigned i=0; i < 3; i++ ) 
+      configs[i] = new test_core_config(warp_parts[i]);
+
+   srand(7);
+   unsigned long long n_accesses = 0;
+   double t_reference = 0, t_new = 0;
+   for( unsigned trial=0; trial < n_trials; trial++ ) {
+      const core_config *config = configs[rand() % 3];
+      unsigned size = sizes[rand() % 5];
+      bool atomic = (rand() % 3) == 0;
+      enum _memory_space_t spaces[] = { global_space, local_space, param_space_local };
+      enum _memory_space_t sp = atomic? global_space : spaces[rand() % 3];
+      bool is_write = !atomic && (rand() % 2);
+
+      coalescer_test_inst inst(config,size,sp);
+      active_mask_t active;
+      for( unsigned t=0; t < config->warp_size; t++ ) 
+         if( rand() % 4 ) 
+            active.set(t);
+      inst.set_active(active);
+
+      // local accesses of more than 4 bytes are split into 4 byte accesses
+      unsigned stride = size;
+      unsigned num_addrs = 1;
+      if( !atomic && sp != global_space && size >= 4 ) {
+         stride = 4;
+         num_addrs = size / 4;
+      }
+      // unit stride, scattered within 8KB, all threads on one word, or scattered widely
+      int pattern = rand() % 4;
+      new_addr_type base = (new_addr_type)(rand() % 4096) * 128 + 0x10000000ULL * (rand() % 3);
+      for( unsigned t=0; t < config->warp_size; t++ ) {
+         new_addr_type addrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
+         for( unsigned a=0; a < num_addrs; a++ ) {
+            new_addr_type addr;
+            switch( pattern ) {
+            case 0: addr = base + (t*num_addrs + a) * stride; break;
+            case 1: addr = base + (rand() % 64) * stride; break;
+            case 2: addr = base; break;
+            default: addr = base + (new_addr_type)(rand() % 100000) * stride; break;
+            }
+            addrs[a] = addr - addr % stride;
+         }
+         inst.set_addr(t,addrs,num_addrs);
+      }
+
+      double start = wall_time();
+      inst.coalesce(true,atomic,is_write);
+      double mid = wall_time();
+      std::list<mem_access_t> expected = inst.accessq();
+      double mid2 = wall_time();
+      inst.coalesce(false,atomic,is_write);
+      double end = wall_time();
+      t_reference += mid - start;
+      t_new += end - mid2;
+
+      const std::list<mem_access_t> &actual = inst.accessq();
+      bool same = expected.size() == actual.size();
+      std::list<mem_access_t>::const_iterator e = expected.begin(), a = actual.begin();
+      for( ; same && e != expected.end(); ++e, ++a ) 
+         same = same_access(*e,*a);
+      if( !same ) {
+         printf("ERROR ** trial %u (%s, %u bytes, %u warp parts): %zu accesses, expected %zu\n", 
+                trial, atomic? "atomic" : "regular", size, config->mem_warp_parts, actual.size(), expected.size() );
+         return 1;
+      }
+      n_accesses += actual.size();
+   }
+   printf("memory_coalescing_arch_13 matches the map based coalescer over %u random warps (%llu accesses)\n", 
+          n_trials, n_accesses );
+   printf("per instruction: map based %.2f us, current %.2f us\n", 
+          t_reference / n_trials * 1e6, t_new / n_trials * 1e6 );
+   return 0;
+}
@@ -0,0 +1,246 @@
+// Copyright (c) 2009-2011, Wilson W.L. Fung, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Checks fifo_pipeline (gpgpu-sim/delayqueue.h) against the linked-list 
+// implementation it replaced and measures push/pop throughput of both.
+//
+//    fifo_pipeline_bench [pairs]     (default 20M push/pop pairs per queue)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include "../gpgpu-sim/delayqueue.h"
+
+// the previous fifo_pipeline: one heap node per slot
+template <class T>
+struct list_fifo_node {
+   T *m_data;
+   list_fifo_node *m_next;
+};
+
+template <class T> 
+class list_fifo_pipeline {
+public:
+   list_fifo_pipeline( unsigned int minlen, unsigned int maxlen ) 
+   {
+      assert(maxlen);
+      m_min_len = minlen;
+      m_max_len = maxlen;
+      m_length = 0;
+      m_n_element = 0;
+      m_head = NULL;
+      m_tail = NULL;
+      for (unsigned i=0;i<m_min_len;i++) 
+         push(NULL);
+   }
+
+   ~list_fifo_pipeline() 
+   {
+      while (m_head) {
+         m_tail = m_head;
+         m_head = m_head->m_next;
+         delete m_tail;
+      }
+   }
+
+   void push(T* data ) 
+   {
+      assert(m_length < m_max_len);
+      if (m_head) {
+         if (m_tail->m_data || m_length < m_min_len) {
+            m_tail->m_next = new list_fifo_node<T>();
+            m_tail = m_tail->m_next;
+            m_length++;
+            m_n_element++;
+         }
+      } else {
+         m_head = m_tail = new list_fifo_node<T>();
+         m_length++;
+         m_n_element++;
+      }
+      m_tail->m_next = NULL;
+      m_tail->m_data = data;
+   }
+
+   T* pop() 
+   {
+      list_fifo_node<T>* next;
+      T* data;
+      if (m_head) {
+        next = m_head->m_next;
+        data = m_head->m_data;
+        if ( m_head == m_tail ) {
+           assert( next == NULL );
+           m_tail = NULL;     
+        }
+        delete m_head;
+        m_head = next;
+        m_length--;
+        if (m_length == 0) {
+           assert( m_head == NULL );
+           m_tail = m_head;
+        }
+        m_n_element--; 
+         if (m_min_len && m_length < m_min_len) {
+            push(NULL);
+            m_n_element--; // uncount NULL elements inserted to create delays
+         }
+      } else {
+         data = NULL;
+      }
+      return data;
+   }
+
+   T* top() const { return m_head ? m_head->m_data : NULL; }
+
+   void set_min_length(unsigned int new_min_len) 
+   {
+      if (new_min_len == m_min_len) return;
+   
+      if (new_min_len > m_min_len) {
+         m_min_len = new_min_len;
+         while (m_length < m_min_len) {
+            push(NULL);
+            m_n_element--; // uncount NULL elements inserted to create delays
+         }
+      } else {
+         assert(m_head);
+         m_min_len = new_min_len;
+         while ((m_length > m_min_len) && (m_tail->m_data == 0)) {
+            list_fifo_node<T> *iter;
+            iter = m_head;
+            while (iter && (iter->m_next != m_tail))
+               iter = iter->m_next;
+            if (!iter) {
+               assert(m_head->m_data == 0);
+               pop();
+            } else {
+               assert(iter->m_next == m_tail);
+               delete m_tail;
+               m_tail = iter;
+               m_tail->m_next = 0;
+               m_length--;
+            }
+         }
+      }
+   }
+
+   bool full() const { return (m_max_len && m_length >= m_max_len); }
+   bool empty() const { return m_head == NULL; }
+   unsigned get_n_element() const { return m_n_element; }
+   unsigned get_length() const { return m_length; }
+
+private:
+   unsigned int m_min_len;
+   unsigned int m_max_len;
+   unsigned int m_length;
+   unsigned int m_n_element;
+
+   list_fifo_node<T> *m_head;
+   list_fifo_node<T> *m_tail;
+};
+
+static double wall_time()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC,&t);
+   return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// random pushes, pops and min-length changes applied to both queues
+static void check_equivalence( unsigned n_trials )
+{
+   int values[8];
+   srand(1);
+   for( unsigned trial=0; trial < n_trials; trial++ ) {
+      unsigned min_len = rand() % 4;
+      unsigned max_len = min_len + 1 + rand() % 8;
+      list_fifo_pipeline<int> ref(min_len,max_len);
+      fifo_pipeline<int> q("q",min_len,max_len);
+      for( unsigned op=0; op < 500; op++ ) {
+         unsigned r = rand() % 10;
+         if( r < 4 ) {
+            if( !ref.full() ) {
+               int *data = (rand() % 3)? &values[rand() % 8] : NULL;
+               ref.push(data);
+               q.push(data);
+            }
+         } else if( r < 8 ) {
+            int *a = ref.pop();
+            int *b = q.pop();
+            if( a != b ) {
+               printf("ERROR ** trial %u op %u: pop returned %p, expected %p\n", trial, op, b, a);
+               exit(1);
+            }
+         } else if( r == 8 && ref.get_length() ) {
+            unsigned m = rand() % max_len;
+            ref.set_min_length(m);
+            q.set_min_length(m);
+         }
+         if( ref.top() != q.top() || ref.get_length() != q.get_length() || 
+             ref.get_n_element() != q.get_n_element() || ref.empty() != q.empty() || 
+             ref.full() != q.full() ) {
+            printf("ERROR ** trial %u op %u: queue state differs from the linked-list version\n", trial, op);
+            exit(1);
+         }
+      }
+   }
+   printf("fifo_pipeline matches the linked-list version over %u random trials\n", n_trials);
+}
+
+// one push (when not full) and one pop per iteration, in million pairs per second
+template <class Q> static double push_pop_rate( Q &q, unsigned n_pairs )
+{
+   int x;
+   unsigned long long sum = 0;
+   double start = wall_time();
+   for( unsigned i=0; i < n_pairs; i++ ) {
+      if( !q.full() ) 
+         q.push(&x);
+      sum += (unsigned long long)q.pop();
+   }
+   double elapsed = wall_time() - start;
+   if( sum == 1 ) 
+      printf("\n"); // keeps the loop from being optimized away
+   return n_pairs / elapsed / 1e6;
+}
+
+int main( int argc, char **argv )
+{
+   unsigned n_pairs = (argc > 1)? atoi(argv[1]) : 20000000;
+   check_equivalence(2000);
+   for( unsigned min_len=0; min_len <= 12; min_len += 12 ) {
+      list_fifo_pipeline<int> ref(min_len,min_len+8);
+      fifo_pipeline<int> q("q",min_len,min_len+8);
+      double ref_rate = push_pop_rate(ref,n_pairs);
+      double rate = push_pop_rate(q,n_pairs);
+      printf("min length %2u: linked list %7.1f Mpairs/s, circular buffer %7.1f Mpairs/s\n", 
+             min_len, ref_rate, rate);
+   }
+   return 0;
+}
@@ -0,0 +1,94 @@
+#!/bin/bash
+# Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda,
+# Timothy G. Rogers
+# The University of British Columbia
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# Redistributions of source code must retain the above copyright notice, this
+# list of conditions and the following disclaimer.
+# Redistributions in binary form must reproduce the above copyright notice, this
+# list of conditions and the following disclaimer in the documentation and/or
+# other materials provided with the distribution.
+# Neither the name of The University of British Columbia nor the names of its
+# contributors may be used to endorse or promote products derived from this
+# software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Runs a CUDA application under GPGPU-Sim with -gpgpu_sim_threads 1 and with 
+# N threads and compares the cycle and instruction counts of every kernel and 
+# the application's own output (the lines matching -m).  Both runs must 
+# succeed and match.  With -f both runs use functional simulation 
+# (PTX_SIM_MODE_FUNC=1), where N is the number of CTAs executed at once.  
+# Needs the environment set up by setup_environment.
+#
+#    sim_threads_check.sh [-f] [-t N] [-c config_dir] [-m regex] app [args...]
+#
+# defaults: N = 4, config_dir = $GPGPUSIM_ROOT/configs/GTX480, 
+# regex = '^tex_fetch:' (the output of tex_fetch, built by "make bench")
+
+THREADS=4
+CONFIG_DIR=$GPGPUSIM_ROOT/configs/GTX480
+APP_OUTPUT='^tex_fetch:'
+FUNCTIONAL=0
+while getopts "ft:c:m:" opt; do
+   case $opt in
+   f) FUNCTIONAL=1 ;;
+   t) THREADS=$OPTARG ;;
+   c) CONFIG_DIR=$OPTARG ;;
+   m) APP_OUTPUT=$OPTARG ;;
+   *) echo "usage: $0 [-f] [-t N] [-c config_dir] [-m regex] app [args...]"; exit 2 ;;
+   esac
+done
+shift $((OPTIND-1))
+if [ $# -lt 1 ]; then
+   echo "usage: $0 [-f] [-t N] [-c config_dir] [-m regex] app [args...]"
+   exit 2
+fi
+APP=$(cd $(dirname $1) && pwd)/$(basename $1)
+shift
+if [ ! -f $CONFIG_DIR/gpgpusim.config ]; then
+   echo "ERROR ** no gpgpusim.config in $CONFIG_DIR"
+   exit 2
+fi
+
+WORK_DIR=$(mktemp -d)
+trap "rm -rf $WORK_DIR" EXIT
+STATS='^(gpu_sim_cycle|gpu_sim_insn|gpu_tot_sim_cycle|gpu_tot_sim_insn) ='
+
+for t in 1 $THREADS; do
+   mkdir -p $WORK_DIR/$t
+   cp $CONFIG_DIR/* $WORK_DIR/$t/
+   echo "-gpgpu_sim_threads $t" >> $WORK_DIR/$t/gpgpusim.config
+   ( cd $WORK_DIR/$t && PTX_SIM_MODE_FUNC=$FUNCTIONAL $APP "$@" > run.log 2>&1 )
+   status=$?
+   if [ $status -ne 0 ]; then
+      echo "FAILED: $(basename $APP) exited with status $status with -gpgpu_sim_threads $t"
+      tail -20 $WORK_DIR/$t/run.log
+      exit 1
+   fi
+   grep -E "$STATS|$APP_OUTPUT" $WORK_DIR/$t/run.log > $WORK_DIR/$t.out
+done
+
+if [ ! -s $WORK_DIR/1.out ]; then
+   echo "FAILED: no statistics or application output found"
+   exit 1
+fi
+if ! diff $WORK_DIR/1.out $WORK_DIR/$THREADS.out; then
+   echo "FAILED: -gpgpu_sim_threads 1 and $THREADS differ"
+   exit 1
+fi
+echo "PASSED: $(basename $APP) matches with -gpgpu_sim_threads 1 and $THREADS ($(grep -cE "$STATS" $WORK_DIR/1.out) statistics lines)"
+exit 0
@@ -0,0 +1,134 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Inderpreet Singh, Timothy Rogers,
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Texture fetches whose coordinates differ in every thread, in enough CTAs 
+// to keep all SIMT core clusters busy: a 1D fetch from linear memory 
+// (integer coordinates) and a 2D fetch from a cudaArray (float coordinates, 
+// point sampling).  The results are checked against the host and summarized 
+// in a checksum, so sim_threads_check.sh can compare runs with different 
+// -gpgpu_sim_threads.
+//
+//    tex_fetch [n_blocks]     (default 120)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cuda_runtime.h>
+
+#define THREADS_PER_BLOCK 128
+#define LINEAR_SIZE 65536
+#define ARRAY_WIDTH 256
+#define ARRAY_HEIGHT 64
+
+texture<int, 1, cudaReadModeElementType> tex_linear;
+texture<float, 2, cudaReadModeElementType> tex_array;
+
+static __host__ __device__ unsigned linear_index( unsigned tid ) { return (tid * 7919u) % LINEAR_SIZE; }
+static __host__ __device__ unsigned array_x( unsigned tid ) { return (tid * 13u) % ARRAY_WIDTH; }
+static __host__ __device__ unsigned array_y( unsigned tid ) { return (tid * 7u + tid / ARRAY_WIDTH) % ARRAY_HEIGHT; }
+
+__global__ void fetch_kernel( int *out_linear, float *out_array )
+{
+   unsigned tid = blockIdx.x * blockDim.x + threadIdx.x;
+   out_linear[tid] = tex1Dfetch(tex_linear, linear_index(tid));
+   out_array[tid] = tex2D(tex_array, array_x(tid) + 0.5f, array_y(tid) + 0.5f);
+}
+
+#define CHECK( call ) \
+   do { \
+      cudaError_t err = call; \
+      if( err != cudaSuccess ) { \
+         printf("tex_fetch: %s failed: %s\n", #call, cudaGetErrorString(err)); \
+         exit(1); \
+      } \
+   } while(0)
+
+int main( int argc, char **argv )
+{
+   unsigned n_blocks = (argc > 1)? atoi(argv[1]) : 120;
+   unsigned n_threads = n_blocks * THREADS_PER_BLOCK;
+
+   int *h_linear = (int*)malloc(LINEAR_SIZE * sizeof(int));
+   for( unsigned i=0; i < LINEAR_SIZE; i++ ) 
+      h_linear[i] = 3 * i + 1;
+   float *h_array = (float*)malloc(ARRAY_WIDTH * ARRAY_HEIGHT * sizeof(float));
+   for( unsigned y=0; y < ARRAY_HEIGHT; y++ ) 
+      for( unsigned x=0; x < ARRAY_WIDTH; x++ ) 
+         h_array[y * ARRAY_WIDTH + x] = y * 1000.0f + x;
+
+   int *d_linear;
+   CHECK( cudaMalloc((void**)&d_linear, LINEAR_SIZE * sizeof(int)) );
+   CHECK( cudaMemcpy(d_linear, h_linear, LINEAR_SIZE * sizeof(int), cudaMemcpyHostToDevice) );
+   CHECK( cudaBindTexture(NULL, tex_linear, d_linear, LINEAR_SIZE * sizeof(int)) );
+
+   cudaChannelFormatDesc desc = cudaCreateChannelDesc<float>();
+   cudaArray *d_array;
+   CHECK( cudaMallocArray(&d_array, &desc, ARRAY_WIDTH, ARRAY_HEIGHT) );
+   CHECK( cudaMemcpyToArray(d_array, 0, 0, h_array, ARRAY_WIDTH * ARRAY_HEIGHT * sizeof(float), cudaMemcpyHostToDevice) );
+   tex_array.addressMode[0] = cudaAddressModeClamp;
+   tex_array.addressMode[1] = cudaAddressModeClamp;
+   tex_array.filterMode = cudaFilterModePoint;
+   tex_array.normalized = false;
+   CHECK( cudaBindTextureToArray(tex_array, d_array, desc) );
+
+   int *d_out_linear;
+   float *d_out_array;
+   CHECK( cudaMalloc((void**)&d_out_linear, n_threads * sizeof(int)) );
+   CHECK( cudaMalloc((void**)&d_out_array, n_threads * sizeof(float)) );
+   fetch_kernel<<<n_blocks, THREADS_PER_BLOCK>>>(d_out_linear, d_out_array);
+   CHECK( cudaThreadSynchronize() );
+
+   int *out_linear = (int*)malloc(n_threads * sizeof(int));
+   float *out_array = (float*)malloc(n_threads * sizeof(float));
+   CHECK( cudaMemcpy(out_linear, d_out_linear, n_threads * sizeof(int), cudaMemcpyDeviceToHost) );
+   CHECK( cudaMemcpy(out_array, d_out_array, n_threads * sizeof(float), cudaMemcpyDeviceToHost) );
+
+   unsigned linear_errors = 0, array_errors = 0, checksum = 0;
+   for( unsigned tid=0; tid < n_threads; tid++ ) {
+      if( out_linear[tid] != h_linear[linear_index(tid)] ) 
+         linear_errors++;
+      if( out_array[tid] != h_array[array_y(tid) * ARRAY_WIDTH + array_x(tid)] ) 
+         array_errors++;
+      checksum = checksum * 31 + (unsigned)out_linear[tid];
+      checksum = checksum * 31 + (unsigned)out_array[tid];
+   }
+   printf("tex_fetch: %u threads, checksum %08x\n", n_threads, checksum);
+   printf("tex_fetch: 1D fetch mismatches %u, 2D fetch mismatches %u\n", linear_errors, array_errors);
+   printf("tex_fetch: %s\n", (linear_errors || array_errors)? "FAILED" : "PASSED");
+
+   cudaUnbindTexture(tex_linear);
+   cudaUnbindTexture(tex_array);
+   cudaFree(d_linear);
+   cudaFree(d_out_linear);
+   cudaFree(d_out_array);
+   cudaFreeArray(d_array);
+   free(h_linear);
+   free(h_array);
+   free(out_linear);
+   free(out_array);
+   return (linear_errors || array_errors)? 1 : 0;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Helpers for the binary checkpoint written at kernel boundaries 
+// (-gpgpu_checkpoint_kernel) and read back by -gpgpu_resume_kernel.  Values 
+// are stored in host byte order: a checkpoint is only meant to be restored by 
+// the same simulator build running the same configuration.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+inline void checkpoint_write_bytes( FILE *fp, const void *data, size_t size )
+{
+   if( size && fwrite(data,size,1,fp) != 1 ) {
+      printf("GPGPU-Sim: ERROR ** failed writing checkpoint file\n");
+      abort();
+   }
+}
+
+inline void checkpoint_read_bytes( FILE *fp, void *data, size_t size )
+{
+   if( size && fread(data,size,1,fp) != 1 ) {
+      printf("GPGPU-Sim: ERROR ** checkpoint file is truncated or unreadable\n");
+      abort();
+   }
+}
+
+template<class T> void checkpoint_write( FILE *fp, const T &value ) 
+{ 
+   checkpoint_write_bytes(fp,&value,sizeof(T)); 
+}
+
+template<class T> void checkpoint_read( FILE *fp, T &value ) 
+{ 
+   checkpoint_read_bytes(fp,&value,sizeof(T)); 
+}
+
+// Each structure starts with a section tag and its size (e.g. number of cache 
+// lines) so that restoring into a different configuration fails loudly 
+inline void checkpoint_write_section( FILE *fp, const char tag[4], unsigned size )
+{
+   checkpoint_write_bytes(fp,tag,4);
+   checkpoint_write(fp,size);
+}
+
+inline void checkpoint_read_section( FILE *fp, const char tag[4], unsigned size )
+{
+   char t[4];
+   unsigned s;
+   checkpoint_read_bytes(fp,t,4);
+   checkpoint_read(fp,s);
+   if( t[0]!=tag[0] || t[1]!=tag[1] || t[2]!=tag[2] || t[3]!=tag[3] || s != size ) {
+      printf("GPGPU-Sim: ERROR ** checkpoint does not match the simulated configuration "
+             "(expected section \'%.4s\' of size %u, found \'%.4s\' of size %u)\n", tag, size, t, s);
+      abort();
+   }
+}
+
+#endif
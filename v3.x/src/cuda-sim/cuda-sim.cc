@@ -38,6 +38,8 @@
 #include "../statwrapper.h"
 #include <set>
 #include <map>
+#include <algorithm>
+#include <pthread.h>
 #include "../abstract_hardware_model.h"
 #include "memory.h"
 #include "ptx-stats.h"
@@ -48,6 +50,7 @@
 #include "../gpgpusim_entrypoint.h"
 #include "decuda_pred_table/decuda_pred_table.h"
 #include "../stream_manager.h"
+#include "../gpgpu-sim/sim_thread_pool.h"
 
 int gpgpu_ptx_instruction_classification;
 void ** g_inst_classification_stat = NULL;
@@ -59,6 +62,12 @@ addr_t g_debug_pc = 0xBEEF1518;
 // Output debug information to file options
 
 unsigned g_ptx_sim_num_insn = 0;
+// set when shader cores are simulated by several host threads (-gpgpu_sim_threads):
+// instruction counts are then accumulated per thread and folded into 
+// g_ptx_sim_num_insn by ptx_sim_flush_thread_insn_count()
+bool g_ptx_sim_multithreaded = false;
+static __thread unsigned t_ptx_sim_num_insn = 0;
+static pthread_mutex_t g_inst_classification_mutex = PTHREAD_MUTEX_INITIALIZER;
 unsigned gpgpu_param_num_shaders = 0;
 
 char *opcode_latency_int, *opcode_latency_fp, *opcode_latency_dp;
@@ -248,28 +257,41 @@ void function_info::ptx_assemble()
 
    create_basic_blocks();
    connect_basic_blocks();
-   bool modified = false; 
-   do {
-      find_dominators();
-      find_idominators();
-      modified = connect_break_targets(); 
-   } while (modified == true);
-
-   if ( g_debug_execution>=50 ) {
-      print_basic_blocks();
-      print_basic_block_links();
-      print_basic_block_dot();
-   }
-   if ( g_debug_execution>=2 ) {
-      print_dominators();
-   }
-   find_postdominators();
-   find_ipostdominators();
-   if ( g_debug_execution>=50 ) {
-      print_postdominators();
-      print_ipostdominators();
+   // the (post)dominator analysis is superlinear in the number of basic blocks
+   // (on a chain of if/else and loop blocks at -O3: 0.34 s for 500 blocks, 
+   // 2.2 s for 1000, 15.7 s for 2000, 129 s for 4000, against 0.3-7.6 ms to 
+   // load the cached result); the debug output needs the full dominator sets, 
+   // which are not cached
+   std::string cfg_cache;
+   if ( g_debug_execution < 2 ) 
+      cfg_cache = ptx_cache_path_in_module("cfg1",m_name);
+   if ( !load_cfg_cache(cfg_cache) ) {
+      bool modified = false; 
+      do {
+         find_dominators();
+         find_idominators();
+         modified = connect_break_targets(); 
+      } while (modified == true);
+
+      if ( g_debug_execution>=50 ) {
+         print_basic_blocks();
+         print_basic_block_links();
+         print_basic_block_dot();
+      }
+      if ( g_debug_execution>=2 ) {
+         print_dominators();
+      }
+      find_postdominators();
+      find_ipostdominators();
+      if ( g_debug_execution>=50 ) {
+         print_postdominators();
+         print_ipostdominators();
+      }
+      save_cfg_cache(cfg_cache);
    }
 
+   alloc_reg_slots();
+
    printf("GPGPU-Sim PTX: pre-decoding instructions for \'%s\'...\n", m_name.c_str() );
    for ( unsigned ii=0; ii < n; ii += m_instr_mem[ii]->inst_size() ) { // handle branch instructions
       ptx_instruction *pI = m_instr_mem[ii];
@@ -281,6 +303,20 @@ void function_info::ptx_assemble()
    m_assembled = true;
 }
 
+void function_info::alloc_reg_slots()
+{
+   // give every architected register declared in this function a dense index 
+   // into the per-thread register file; a call frame is then just an offset 
+   assert( m_symtab != NULL );
+   unsigned n=0;
+   symbol_table::iterator r;
+   for ( r=m_symtab->reg_iterator_begin(); r != m_symtab->reg_iterator_end(); ++r ) {
+      symbol *reg = *r;
+      reg->set_reg_slot(n++);
+   }
+   m_num_reg_slots = n;
+}
+
 addr_t shared_to_generic( unsigned smid, addr_t addr )
 {
    assert( addr < SHARED_MEM_SIZE_MAX );
@@ -381,9 +417,7 @@ void gpgpu_t::memcpy_to_gpu( size_t dst_start_addr, const void *src, size_t coun
       printf("GPGPU-Sim PTX: copying %zu bytes from CPU[0x%Lx] to GPU[0x%Lx] ... ", count, (unsigned long long) src, (unsigned long long) dst_start_addr );
       fflush(stdout);
    }
-   char *src_data = (char*)src;
-   for (unsigned n=0; n < count; n ++ ) 
-      m_global_mem->write(dst_start_addr+n,1, src_data+n,NULL,NULL);
+   m_global_mem->write(dst_start_addr,count,src,NULL,NULL);
    if(g_debug_execution >= 3) {
       printf( " done.\n");
       fflush(stdout);
@@ -396,9 +430,9 @@ void gpgpu_t::memcpy_from_gpu( void *dst, size_t src_start_addr, size_t count )
       printf("GPGPU-Sim PTX: copying %zu bytes from GPU[0x%Lx] to CPU[0x%Lx] ...", count, (unsigned long long) src_start_addr, (unsigned long long) dst );
       fflush(stdout);
    }
-   unsigned char *dst_data = (unsigned char*)dst;
-   for (unsigned n=0; n < count; n ++ ) 
-      m_global_mem->read(src_start_addr+n,1,dst_data+n);
+   if( !replay_readback(dst,src_start_addr,count) ) 
+      m_global_mem->read(src_start_addr,count,dst);
+   record_readback(dst,src_start_addr,count);
    if(g_debug_execution >= 3) {
       printf( " done.\n");
       fflush(stdout);
@@ -412,10 +446,11 @@ void gpgpu_t::memcpy_gpu_to_gpu( size_t dst, size_t src, size_t count )
           (unsigned long long) src, (unsigned long long) dst );
       fflush(stdout);
    }
-   for (unsigned n=0; n < count; n ++ ) {
-      unsigned char tmp;
-      m_global_mem->read(src+n,1,&tmp); 
-      m_global_mem->write(dst+n,1, &tmp,NULL,NULL);
+   unsigned char tmp[MEM_BLOCK_SIZE];
+   for (size_t n=0; n < count; n += MEM_BLOCK_SIZE ) {
+      size_t nbytes = std::min((size_t)MEM_BLOCK_SIZE, count - n);
+      m_global_mem->read(src+n,nbytes,tmp); 
+      m_global_mem->write(dst+n,nbytes,tmp,NULL,NULL);
    }
    if(g_debug_execution >= 3) {
       printf( " done.\n");
@@ -430,15 +465,106 @@ void gpgpu_t::gpu_memset( size_t dst_start_addr, int c, size_t count )
           count, (unsigned char) c, (unsigned long long) dst_start_addr );
       fflush(stdout);
    }
-   unsigned char c_value = (unsigned char)c;
-   for (unsigned n=0; n < count; n ++ ) 
-      m_global_mem->write(dst_start_addr+n,1,&c_value,NULL,NULL);
+   unsigned char c_value[MEM_BLOCK_SIZE];
+   memset(c_value,c,MEM_BLOCK_SIZE);
+   for (size_t n=0; n < count; n += MEM_BLOCK_SIZE ) {
+      size_t nbytes = std::min((size_t)MEM_BLOCK_SIZE, count - n);
+      m_global_mem->write(dst_start_addr+n,nbytes,c_value,NULL,NULL);
+   }
    if(g_debug_execution >= 3) {
       printf( " done.\n");
       fflush(stdout);
    }
 }
 
+void gpgpu_t::checkpoint( FILE *fp ) const
+{
+   checkpoint_write_section(fp,"GMEM",0);
+   checkpoint_write(fp,m_dev_malloc);
+   m_global_mem->checkpoint(fp);
+   m_tex_mem->checkpoint(fp);
+   m_surf_mem->checkpoint(fp);
+}
+
+void gpgpu_t::restore( FILE *fp )
+{
+   unsigned long long dev_malloc;
+   checkpoint_read_section(fp,"GMEM",0);
+   checkpoint_read(fp,dev_malloc);
+   if( dev_malloc != m_dev_malloc ) {
+      // the application holds pointers into the restored memory image
+      printf("GPGPU-Sim PTX: ERROR ** application allocated 0x%llx bytes of device memory before resuming, "
+             "checkpointed run allocated 0x%llx\n", m_dev_malloc - GLOBAL_HEAP_START, dev_malloc - GLOBAL_HEAP_START );
+      abort();
+   }
+   m_global_mem->restore(fp);
+   m_tex_mem->restore(fp);
+   m_surf_mem->restore(fp);
+}
+
+bool gpgpu_t::replay_readback( void *dst, size_t src_start_addr, size_t count )
+{
+   if( !m_replay_readbacks ) 
+      return false;
+   if( m_replay_readback_list.empty() || m_replay_readback_list.front().m_kernel_uid != m_readback_kernel ||
+       m_replay_readback_list.front().m_addr != src_start_addr || m_replay_readback_list.front().m_data.size() != count ) {
+      printf("GPGPU-Sim PTX: ERROR ** device-to-host copy of %zu bytes from 0x%llx after kernel %u "
+             "does not match the copies recorded by the checkpointed run\n", 
+             count, (unsigned long long) src_start_addr, m_readback_kernel );
+      abort();
+   }
+   if( count ) 
+      memcpy(dst,&m_replay_readback_list.front().m_data[0],count);
+   m_replay_readback_list.pop_front();
+   return true;
+}
+
+void gpgpu_t::record_readback( const void *data, size_t src_start_addr, size_t count )
+{
+   if( !m_record_readbacks ) 
+      return;
+   m_record_readback_list.push_back(readback_t());
+   readback_t &r = m_record_readback_list.back();
+   r.m_kernel_uid = m_readback_kernel;
+   r.m_addr = src_start_addr;
+   r.m_data.assign((const unsigned char*)data,(const unsigned char*)data+count);
+}
+
+void gpgpu_t::save_readbacks( FILE *fp ) const
+{
+   checkpoint_write_section(fp,"RDBK",m_record_readback_list.size());
+   std::list<readback_t>::const_iterator r;
+   for( r=m_record_readback_list.begin(); r != m_record_readback_list.end(); r++ ) {
+      checkpoint_write(fp,r->m_kernel_uid);
+      checkpoint_write(fp,r->m_addr);
+      checkpoint_write(fp,r->m_data.size());
+      checkpoint_write_bytes(fp,r->m_data.empty()? NULL : &r->m_data[0],r->m_data.size());
+   }
+}
+
+void gpgpu_t::load_readbacks( FILE *fp, bool replay )
+{
+   char tag[4];
+   unsigned n;
+   checkpoint_read_bytes(fp,tag,4);
+   checkpoint_read(fp,n);
+   if( tag[0]!='R' || tag[1]!='D' || tag[2]!='B' || tag[3]!='K' ) {
+      printf("GPGPU-Sim PTX: ERROR ** checkpoint has no device-to-host copy section (found \'%.4s\')\n", tag);
+      abort();
+   }
+   for( unsigned i=0; i < n; i++ ) {
+      readback_t r;
+      size_t size;
+      checkpoint_read(fp,r.m_kernel_uid);
+      checkpoint_read(fp,r.m_addr);
+      checkpoint_read(fp,size);
+      r.m_data.resize(size);
+      checkpoint_read_bytes(fp,size? &r.m_data[0] : NULL,size);
+      if( replay ) 
+         m_replay_readback_list.push_back(r);
+   }
+}
+
 void ptx_print_insn( address_type pc, FILE *fp )
 {
    std::map<unsigned,function_info*>::iterator f = g_pc_to_finfo.find(pc);
@@ -783,6 +909,25 @@ static unsigned datatype2size( unsigned data_type )
    return data_size; 
 }
 
+// per-opcode properties, indexed by opcode_t
+static const ptx_exec_fn_t g_opcode_exec_fn[NUM_OPCODES] = {
+#define OP_DEF(OP,FUNC,STR,DST,CLASSIFICATION) FUNC,
+#include "opcodes.def"
+#undef OP_DEF
+};
+
+static const bool g_opcode_has_dst[NUM_OPCODES] = {
+#define OP_DEF(OP,FUNC,STR,DST,CLASSIFICATION) (DST!=0),
+#include "opcodes.def"
+#undef OP_DEF
+};
+
+static const int g_opcode_classification[NUM_OPCODES] = {
+#define OP_DEF(OP,FUNC,STR,DST,CLASSIFICATION) CLASSIFICATION,
+#include "opcodes.def"
+#undef OP_DEF
+};
+
 void ptx_instruction::pre_decode()
 {
    pc = m_PC;
@@ -809,13 +954,13 @@ void ptx_instruction::pre_decode()
 
    bool has_dst = false ;
 
-   switch ( get_opcode() ) {
-#define OP_DEF(OP,FUNC,STR,DST,CLASSIFICATION) case OP: has_dst = (DST!=0); break;
-#include "opcodes.def"
-#undef OP_DEF
-   default:
+   if( (unsigned)get_opcode() < NUM_OPCODES ) {
+      // bind the handler once so execution does not go through the opcode switch
+      has_dst = g_opcode_has_dst[get_opcode()];
+      m_exec_fn = g_opcode_exec_fn[get_opcode()];
+      m_op_classification = g_opcode_classification[get_opcode()];
+   } else {
       printf( "Execution error: Invalid opcode (0x%x)\n", get_opcode() );
-      break;
    }
 
    switch( m_cache_option ) {
@@ -937,9 +1082,132 @@ void ptx_instruction::pre_decode()
    // get reconvergence pc
    reconvergence_pc = get_converge_point(pc);
 
+   for( unsigned n=0; n < m_operands.size(); n++ ) 
+      m_operands[n].resolve_fast_path();
+
+   set_reg_mask();
+   set_warp_simd_op();
+
    m_decoded=true;
 }
 
+static bool warp_simd_operand( const operand_info &op, bool is_dst )
+{
+   // only plain registers and (for sources) immediates, no ptxplus modifiers
+   if( op.is_vector() || op.get_double_operand_type() != 0 || op.get_operand_lohi() != 0 || 
+       op.get_addr_space() != undefined_space || op.get_operand_neg() ) 
+      return false;
+   if( op.is_reg() ) 
+      return op.get_symbol()->has_reg_slot();
+   return !is_dst && op.is_literal();
+}
+
+void ptx_instruction::set_warp_simd_op()
+{
+   m_warp_simd_op = WARP_SIMD_NONE;
+   if( m_exit || m_scalar_type.empty() ) 
+      return;
+
+   unsigned num_src;
+   switch( m_opcode ) {
+   case MOV_OP: case CVT_OP: 
+      num_src = 1; 
+      break;
+   case ADD_OP: case SUB_OP: case AND_OP: case OR_OP: case XOR_OP: 
+   case SHL_OP: case SHR_OP: case MUL_OP: case SETP_OP: 
+      num_src = 2; 
+      break;
+   case SELP_OP: 
+      num_src = 3; 
+      break;
+   default: 
+      return;
+   }
+   if( m_operands.size() != num_src+1 ) 
+      return;
+   for( unsigned n=0; n < m_operands.size(); n++ ) {
+      if( !warp_simd_operand(m_operands[n], n==0) ) 
+         return;
+   }
+
+   // must produce exactly the same register contents as the *_impl functions
+   int type = get_type();
+   bool is_u32 = (type == U32_TYPE) || (type == S32_TYPE) || (type == B32_TYPE);
+   bool is_u64 = (type == U64_TYPE) || (type == S64_TYPE) || (type == B64_TYPE);
+   switch( m_opcode ) {
+   case MOV_OP: 
+      if( type != PRED_TYPE && type != BB64_TYPE && type != BB128_TYPE && type != FF64_TYPE ) 
+         m_warp_simd_op = WARP_SIMD_MOV; 
+      break;
+   case ADD_OP: 
+      if( type == U32_TYPE || type == S32_TYPE ) m_warp_simd_op = WARP_SIMD_ADD32;
+      else if( type == U64_TYPE || type == S64_TYPE ) m_warp_simd_op = WARP_SIMD_ADD64;
+      else if( type == F32_TYPE && m_rounding_mode == RN_OPTION ) m_warp_simd_op = WARP_SIMD_ADD_F32;
+      break;
+   case SUB_OP: 
+      if( is_u32 ) m_warp_simd_op = WARP_SIMD_SUB32;
+      else if( is_u64 ) m_warp_simd_op = WARP_SIMD_SUB64;
+      else if( type == F32_TYPE ) m_warp_simd_op = WARP_SIMD_SUB_F32;
+      break;
+   case AND_OP: if( is_u32 || is_u64 ) m_warp_simd_op = WARP_SIMD_AND; break;
+   case OR_OP:  if( is_u32 || is_u64 ) m_warp_simd_op = WARP_SIMD_OR;  break;
+   case XOR_OP: if( is_u32 || is_u64 ) m_warp_simd_op = WARP_SIMD_XOR; break;
+   case SHL_OP: 
+      if( type == U32_TYPE || type == B32_TYPE ) m_warp_simd_op = WARP_SIMD_SHL32; 
+      break;
+   case SHR_OP: 
+      if( type == U32_TYPE || type == B32_TYPE ) m_warp_simd_op = WARP_SIMD_SHR32; 
+      else if( type == S32_TYPE ) m_warp_simd_op = WARP_SIMD_SRA32; 
+      break;
+   case MUL_OP: 
+      if( type == U32_TYPE && m_wide ) m_warp_simd_op = WARP_SIMD_MUL_WIDE_U32;
+      else if( type == S32_TYPE && m_wide ) m_warp_simd_op = WARP_SIMD_MUL_WIDE_S32;
+      else if( (type == U32_TYPE || type == S32_TYPE) && m_lo ) m_warp_simd_op = WARP_SIMD_MUL_LO32;
+      else if( type == F32_TYPE && m_rounding_mode == RN_OPTION && !m_saturation_mode ) m_warp_simd_op = WARP_SIMD_MUL_F32;
+      break;
+   case SETP_OP: {
+      // no boolOp/c operand (already excluded by the operand count) 
+      bool is_unsigned = (type == U32_TYPE) || (type == U64_TYPE);
+      switch( m_compare_op ) {
+      case EQ_OPTION: case NE_OPTION: case LT_OPTION: case LE_OPTION: case GT_OPTION: case GE_OPTION: 
+         break;
+      case LO_OPTION: case LS_OPTION: case HI_OPTION: case HS_OPTION: 
+         if( !is_unsigned ) return;
+         break;
+      default: 
+         return;
+      }
+      if( type == S32_TYPE ) m_warp_simd_op = WARP_SIMD_SETP_S32;
+      else if( type == U32_TYPE ) m_warp_simd_op = WARP_SIMD_SETP_U32;
+      else if( type == S64_TYPE ) m_warp_simd_op = WARP_SIMD_SETP_S64;
+      else if( type == U64_TYPE ) m_warp_simd_op = WARP_SIMD_SETP_U64;
+      else if( type == F32_TYPE ) m_warp_simd_op = WARP_SIMD_SETP_F32;
+      break;
+   }
+   case SELP_OP: 
+      if( type != PRED_TYPE && type != BB64_TYPE && type != BB128_TYPE && type != FF64_TYPE ) 
+         m_warp_simd_op = WARP_SIMD_SELP; 
+      break;
+   case CVT_OP: {
+      // integer conversions between 32 and 64 bits only (see g_cvt_fn)
+      int from = get_type2();
+      bool to_32 = (type == U32_TYPE) || (type == S32_TYPE);
+      bool to_64 = (type == U64_TYPE) || (type == S64_TYPE);
+      if( m_neg || (!to_32 && !to_64) ) 
+         break;
+      if( from == U32_TYPE || from == S32_TYPE ) {
+         if( to_32 ) m_warp_simd_op = WARP_SIMD_MOV; 
+         else m_warp_simd_op = (from == S32_TYPE)? WARP_SIMD_CVT_SEXT32 : WARP_SIMD_CVT_CHOP32; 
+      } else if( from == U64_TYPE || from == S64_TYPE ) {
+         m_warp_simd_op = to_32? WARP_SIMD_CVT_CHOP32 : WARP_SIMD_MOV; 
+      }
+      break;
+   }
+   default: 
+      break;
+   }
+}
+
 void function_info::add_param_name_type_size( unsigned index, std::string name, int type, size_t size, bool ptr, memory_space_t space )
 {
    unsigned parsed_index;
@@ -1175,7 +1443,10 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
       assert(0);
    }
    
-   if ( g_debug_execution >= 6 || m_gpu->get_config().get_ptx_inst_debug_to_file()) {
+   const gpgpu_functional_sim_config &config = m_gpu->get_config();
+   const bool debug = (g_debug_execution >= 5) || config.get_ptx_inst_debug_to_file();
+
+   if ( debug && (g_debug_execution >= 6 || config.get_ptx_inst_debug_to_file()) ) {
       if ( (g_debug_thread_uid==0) || (get_uid() == (unsigned)g_debug_thread_uid) ) {
         
           clear_modifiedregs();
@@ -1184,15 +1455,8 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
    }
    
    
-   if( pI->has_pred() ) {
-      const operand_info &pred = pI->get_pred();
-      ptx_reg_t pred_value = get_operand_value(pred, pred, PRED_TYPE, this, 0);
-      if(pI->get_pred_mod() == -1) {
-            skip = (pred_value.pred & 0x0001) ^ pI->get_pred_neg(); //ptxplus inverts the zero flag
-      } else {
-            skip = !pred_lookup(pI->get_pred_mod(), pred_value.pred & 0x000F);
-      }
-   }
+   if( pI->has_pred() ) 
+      skip = pred_skip(pI);
    
    if( skip ) {
       inst.set_not_active(lane_id);
@@ -1204,11 +1468,11 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
          *((warp_inst_t*)pJ) = inst; // copy active mask information
          pI = pJ;
       }
-      switch ( pI->get_opcode() ) {
-#define OP_DEF(OP,FUNC,STR,DST,CLASSIFICATION) case OP: FUNC(pI,this); op_classification = CLASSIFICATION; break;
-#include "opcodes.def"
-#undef OP_DEF
-      default: printf( "Execution error: Invalid opcode (0x%x)\n", pI->get_opcode() ); break;
+      if( pI->exec_fn() ) {
+         pI->exec_fn()(pI,this);
+         op_classification = pI->op_classification();
+      } else {
+         printf( "Execution error: Invalid opcode (0x%x)\n", pI->get_opcode() );
       }
       delete pJ;
       pI = pI_saved;
@@ -1218,12 +1482,8 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
          exit_impl(pI,this);
    }
    
-
-
-   const gpgpu_functional_sim_config &config = m_gpu->get_config();
-   
    // Output instruction information to file and stdout
-   if( config.get_ptx_inst_debug_to_file() != 0 && 
+   if( debug && config.get_ptx_inst_debug_to_file() != 0 && 
         (config.get_ptx_inst_debug_thread_uid() == 0 || config.get_ptx_inst_debug_thread_uid() == get_uid()) ) {
       fprintf(m_gpu->get_ptx_inst_debug_file(),
              "[thd=%u] : (%s:%u - %s)\n",
@@ -1233,7 +1493,7 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
       fflush(m_gpu->get_ptx_inst_debug_file());
    }
 
-   if ( ptx_debug_exec_dump_cond<5>(get_uid(), pc) ) {
+   if ( debug && ptx_debug_exec_dump_cond<5>(get_uid(), pc) ) {
       dim3 ctaid = get_ctaid();
       dim3 tid = get_tid();
       printf("%u [thd=%u][i=%u] : ctaid=(%u,%u,%u) tid=(%u,%u,%u) icount=%u [pc=%u] (%s:%u - %s)  [0x%llx]\n", 
@@ -1250,12 +1510,11 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
    memory_space_t insn_space = undefined_space;
    _memory_op_t insn_memory_op = no_memory_op;
    unsigned insn_data_size = 0;
-   if ( (pI->has_memory_read()  || pI->has_memory_write()) ) {
+   if ( pI->memory_op != no_memory_op ) { // set up by pre_decode
       insn_memaddr = last_eaddr();
       insn_space = last_space();
-      unsigned to_type = pI->get_type();
-      insn_data_size = datatype2size(to_type);
-      insn_memory_op = pI->has_memory_read() ? memory_load : memory_store;
+      insn_data_size = pI->data_size;
+      insn_memory_op = pI->memory_op;
    }
    
    if ( pI->get_opcode() == ATOM_OP ) {
@@ -1273,28 +1532,62 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
    }
 
    // Output register information to file and stdout
-   if( config.get_ptx_inst_debug_to_file()!=0 && 
+   if( debug && config.get_ptx_inst_debug_to_file()!=0 && 
        (config.get_ptx_inst_debug_thread_uid()==0||config.get_ptx_inst_debug_thread_uid()==get_uid()) ) {
       dump_modifiedregs(m_gpu->get_ptx_inst_debug_file());
       dump_regs(m_gpu->get_ptx_inst_debug_file());
    }
 
-   if ( g_debug_execution >= 6 ) {
+   if ( debug && g_debug_execution >= 6 ) {
       if ( ptx_debug_exec_dump_cond<6>(get_uid(), pc) )
          dump_modifiedregs(stdout);
-   }
-   if ( g_debug_execution >= 10 ) {
-      if ( ptx_debug_exec_dump_cond<10>(get_uid(), pc) )
+      if ( g_debug_execution >= 10 && ptx_debug_exec_dump_cond<10>(get_uid(), pc) )
          dump_regs(stdout);
    }
+   retire_inst(pI, op_classification);
+   
+   // "Return values"
+   if(!skip) {
+      inst.space = insn_space;
+      inst.set_addr(lane_id, insn_memaddr);
+      inst.data_size = insn_data_size; // simpleAtomicIntrinsics
+      assert( inst.memory_op == insn_memory_op );
+   } 
+
+   } catch ( int x  ) {
+      printf("GPGPU-Sim PTX: ERROR (%d) executing intruction (%s:%u)\n", x, pI->source_file(), pI->source_line() );
+      printf("GPGPU-Sim PTX:       '%s'\n", pI->get_source() );
+      abort();
+   }
+      
+}
+
+bool ptx_thread_info::pred_skip( const ptx_instruction *pI )
+{
+   const operand_info &pred = pI->get_pred();
+   ptx_reg_t pred_value = get_operand_value(pred, pred, PRED_TYPE, this, 0);
+   if(pI->get_pred_mod() == -1) {
+      return (pred_value.pred & 0x0001) ^ pI->get_pred_neg(); //ptxplus inverts the zero flag
+   } else {
+      return !pred_lookup(pI->get_pred_mod(), pred_value.pred & 0x000F);
+   }
+}
+
+void ptx_thread_info::retire_inst( const ptx_instruction *pI, int op_classification )
+{
    update_pc();
-   g_ptx_sim_num_insn++;
+   if( g_ptx_sim_multithreaded ) 
+      t_ptx_sim_num_insn++;
+   else 
+      g_ptx_sim_num_insn++;
    
    //not using it with functional simulation mode
    if(!(this->m_functionalSimulationMode))
        ptx_file_line_stats_add_exec_count(pI);
    
    if ( gpgpu_ptx_instruction_classification ) {
+      if( g_ptx_sim_multithreaded ) 
+         pthread_mutex_lock(&g_inst_classification_mutex);
       init_inst_classification_stat();
       unsigned space_type=0;
       switch ( pI->get_space().get_type() ) {
@@ -1314,29 +1607,246 @@ void ptx_thread_info::ptx_exec_inst( warp_inst_t &inst, unsigned lane_id)
       StatAddSample( g_inst_classification_stat[g_ptx_kernel_count],  op_classification);
       if (space_type) StatAddSample( g_inst_classification_stat[g_ptx_kernel_count], ( int )space_type);
       StatAddSample( g_inst_op_classification_stat[g_ptx_kernel_count], (int)  pI->get_opcode() );
+      if( g_ptx_sim_multithreaded ) 
+         pthread_mutex_unlock(&g_inst_classification_mutex);
    }
-   if ( (g_ptx_sim_num_insn % 100000) == 0 ) {
+   if ( !g_ptx_sim_multithreaded && (g_ptx_sim_num_insn % 100000) == 0 ) {
       dim3 ctaid = get_ctaid();
       dim3 tid = get_tid();
       printf("GPGPU-Sim PTX: %u instructions simulated : ctaid=(%u,%u,%u) tid=(%u,%u,%u)\n",
              g_ptx_sim_num_insn, ctaid.x,ctaid.y,ctaid.z,tid.x,tid.y,tid.z );
       fflush(stdout);
    }
-   
-   // "Return values"
-   if(!skip) {
-      inst.space = insn_space;
-      inst.set_addr(lane_id, insn_memaddr);
-      inst.data_size = insn_data_size; // simpleAtomicIntrinsics
-      assert( inst.memory_op == insn_memory_op );
-   } 
+}
 
-   } catch ( int x  ) {
-      printf("GPGPU-Sim PTX: ERROR (%d) executing intruction (%s:%u)\n", x, pI->source_file(), pI->source_line() );
-      printf("GPGPU-Sim PTX:       '%s'\n", pI->get_source() );
+void ptx_sim_set_multithreaded( bool multithreaded )
+{
+   g_ptx_sim_multithreaded = multithreaded;
+   ptx_file_line_stats_set_multithreaded(multithreaded);
+}
+
+void ptx_sim_flush_thread_insn_count()
+{
+   if( t_ptx_sim_num_insn ) {
+      __sync_fetch_and_add(&g_ptx_sim_num_insn, t_ptx_sim_num_insn);
+      t_ptx_sim_num_insn = 0;
+   }
+}
+
+static inline float warp_simd_f32( unsigned long long v ) 
+{ 
+   ptx_reg_t r; 
+   r.u64 = v; 
+   return r.f32; 
+}
+
+static inline unsigned long long warp_simd_f32_bits( float f ) 
+{ 
+   ptx_reg_t r; 
+   r.f32 = f; 
+   return r.u64; 
+}
+
+template<class T> static inline T warp_simd_as( unsigned long long v ) { return (T)v; }
+template<> inline float warp_simd_as<float>( unsigned long long v ) { return warp_simd_f32(v); }
+
+// setp over all lanes: d is the ptxplus zero flag written by setp_impl (1 when
+// the comparison is false); CmpOp's NaN checks only matter for f32 ne
+template<class T> 
+static void warp_simd_setp( unsigned cmpop, const unsigned long long *a, const unsigned long long *b, unsigned n, unsigned long long *d )
+{
+   switch( cmpop ) {
+   case EQ_OPTION: 
+      for( unsigned i=0; i < n; i++ ) d[i] = !(warp_simd_as<T>(a[i]) == warp_simd_as<T>(b[i])); 
+      break;
+   case NE_OPTION: 
+      for( unsigned i=0; i < n; i++ ) {
+         T x = warp_simd_as<T>(a[i]), y = warp_simd_as<T>(b[i]);
+         d[i] = !((x != y) && (x == x) && (y == y)); 
+      }
+      break;
+   case LT_OPTION: case LO_OPTION: 
+      for( unsigned i=0; i < n; i++ ) d[i] = !(warp_simd_as<T>(a[i]) < warp_simd_as<T>(b[i])); 
+      break;
+   case LE_OPTION: case LS_OPTION: 
+      for( unsigned i=0; i < n; i++ ) d[i] = !(warp_simd_as<T>(a[i]) <= warp_simd_as<T>(b[i])); 
+      break;
+   case GT_OPTION: case HI_OPTION: 
+      for( unsigned i=0; i < n; i++ ) d[i] = !(warp_simd_as<T>(a[i]) > warp_simd_as<T>(b[i])); 
+      break;
+   case GE_OPTION: case HS_OPTION: 
+      for( unsigned i=0; i < n; i++ ) d[i] = !(warp_simd_as<T>(a[i]) >= warp_simd_as<T>(b[i])); 
+      break;
+   default: 
       abort();
    }
-      
+}
+
+static void warp_simd_gather( const operand_info &op, ptx_thread_info **thread, const unsigned *lane, unsigned n, unsigned long long *v )
+{
+   if( op.is_literal() ) {
+      unsigned long long imm = op.get_literal_value().u64;
+      for( unsigned i=0; i < n; i++ ) 
+         v[i] = imm;
+   } else {
+      const symbol *reg = op.get_symbol();
+      for( unsigned i=0; i < n; i++ ) 
+         v[i] = thread[lane[i]]->get_reg(reg).u64;
+   }
+}
+
+// Executes a warp instruction for all of its active threads at once: the
+// instruction is decoded a single time, source registers are gathered into 
+// per-lane arrays, and the operation runs as one loop over the lanes (which
+// the compiler vectorizes).  Returns false without side effects if the 
+// instruction has to go through ptx_thread_info::ptx_exec_inst instead.
+bool ptx_exec_warp_inst( warp_inst_t &inst, ptx_thread_info **thread, unsigned warp_size )
+{
+   const ptx_instruction *pI = function_info::pc_to_instruction(inst.pc);
+   if( pI == NULL || pI->warp_simd_op() == WARP_SIMD_NONE ) 
+      return false;
+   if( g_debug_execution >= 5 ) 
+      return false; // per-thread debug dumps
+
+   unsigned active[MAX_WARP_SIZE], num_active=0;
+   for( unsigned t=0; t < warp_size; t++ ) {
+      if( inst.active(t) ) 
+         active[num_active++] = t;
+   }
+   if( num_active == 0 ) 
+      return false;
+   const gpgpu_functional_sim_config &config = thread[active[0]]->get_config();
+   if( !config.warp_exec() || config.get_ptx_inst_debug_to_file() ) 
+      return false;
+
+   // per-thread front end: same bookkeeping as ptx_exec_inst
+   unsigned lane[MAX_WARP_SIZE], n=0;
+   bool skip[MAX_WARP_SIZE];
+   for( unsigned i=0; i < num_active; i++ ) {
+      ptx_thread_info *thd = thread[active[i]];
+      addr_t pc = thd->next_instr();
+      assert( pc == inst.pc ); // make sure timing model and functional model are in sync
+      thd->set_npc( pc + pI->inst_size() );
+      thd->clearRPC();
+      thd->m_last_set_operand_value.u64 = 0;
+      if( thd->is_done() ) {
+         printf("attempted to execute instruction on a thread that is already done.\n");
+         assert(0);
+      }
+      skip[i] = pI->has_pred() && thd->pred_skip(pI);
+      if( skip[i] ) 
+         inst.set_not_active(active[i]);
+      else 
+         lane[n++] = active[i];
+   }
+
+   unsigned long long a[MAX_WARP_SIZE], b[MAX_WARP_SIZE], c[MAX_WARP_SIZE], d[MAX_WARP_SIZE];
+   warp_simd_gather(pI->src1(), thread, lane, n, a);
+   if( pI->get_num_operands() > 2 ) 
+      warp_simd_gather(pI->src2(), thread, lane, n, b);
+   if( pI->get_num_operands() > 3 ) 
+      warp_simd_gather(pI->src3(), thread, lane, n, c);
+
+   switch( pI->warp_simd_op() ) {
+   case WARP_SIMD_MOV: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i]; 
+      break;
+   case WARP_SIMD_ADD32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = (a[i] & 0xFFFFFFFF) + (b[i] & 0xFFFFFFFF); 
+      break;
+   case WARP_SIMD_ADD64: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i] + b[i]; 
+      break;
+   case WARP_SIMD_SUB32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = (a[i] & 0xFFFFFFFF) - (b[i] & 0xFFFFFFFF) + 0x100000000ULL; 
+      break;
+   case WARP_SIMD_SUB64: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i] - b[i]; 
+      break;
+   case WARP_SIMD_AND: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i] & b[i]; 
+      break;
+   case WARP_SIMD_OR: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i] | b[i]; 
+      break;
+   case WARP_SIMD_XOR: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i] ^ b[i]; 
+      break;
+   case WARP_SIMD_SHL32: 
+      for( unsigned i=0; i < n; i++ ) {
+         unsigned sh = (unsigned)b[i];
+         d[i] = (sh >= 32)? 0 : (unsigned)((unsigned)a[i] << sh); 
+      }
+      break;
+   case WARP_SIMD_SHR32: 
+      for( unsigned i=0; i < n; i++ ) {
+         unsigned sh = (unsigned)b[i];
+         d[i] = (sh >= 32)? 0 : ((unsigned)a[i] >> sh); 
+      }
+      break;
+   case WARP_SIMD_SRA32: 
+      for( unsigned i=0; i < n; i++ ) {
+         unsigned sh = (unsigned)b[i];
+         int x = (int)(unsigned)a[i];
+         d[i] = (long long)((sh >= 32)? ((x < 0)? -1 : 0) : (x >> sh)); 
+      }
+      break;
+   case WARP_SIMD_MUL_LO32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = (unsigned)((unsigned)a[i] * (unsigned)b[i]); 
+      break;
+   case WARP_SIMD_MUL_WIDE_U32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = (unsigned long long)(unsigned)a[i] * (unsigned)b[i]; 
+      break;
+   case WARP_SIMD_MUL_WIDE_S32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = (long long)(int)(unsigned)a[i] * (int)(unsigned)b[i]; 
+      break;
+   case WARP_SIMD_ADD_F32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = warp_simd_f32_bits( warp_simd_f32(a[i]) + warp_simd_f32(b[i]) ); 
+      break;
+   case WARP_SIMD_SUB_F32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = warp_simd_f32_bits( warp_simd_f32(a[i]) - warp_simd_f32(b[i]) ); 
+      break;
+   case WARP_SIMD_MUL_F32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = warp_simd_f32_bits( warp_simd_f32(a[i]) * warp_simd_f32(b[i]) ); 
+      break;
+   case WARP_SIMD_SETP_S32: warp_simd_setp<int>(pI->get_cmpop(), a, b, n, d); break;
+   case WARP_SIMD_SETP_U32: warp_simd_setp<unsigned>(pI->get_cmpop(), a, b, n, d); break;
+   case WARP_SIMD_SETP_S64: warp_simd_setp<long long>(pI->get_cmpop(), a, b, n, d); break;
+   case WARP_SIMD_SETP_U64: warp_simd_setp<unsigned long long>(pI->get_cmpop(), a, b, n, d); break;
+   case WARP_SIMD_SETP_F32: warp_simd_setp<float>(pI->get_cmpop(), a, b, n, d); break;
+   case WARP_SIMD_SELP: 
+      // the predicate's low bit is the ptxplus zero flag, see selp_impl
+      for( unsigned i=0; i < n; i++ ) d[i] = (c[i] & 1)? b[i] : a[i]; 
+      break;
+   case WARP_SIMD_CVT_CHOP32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = a[i] & 0xFFFFFFFF; 
+      break;
+   case WARP_SIMD_CVT_SEXT32: 
+      for( unsigned i=0; i < n; i++ ) d[i] = (long long)(int)(unsigned)a[i]; 
+      break;
+   default: 
+      abort();
+   }
+
+   const symbol *dst = pI->dst().get_symbol();
+   for( unsigned i=0; i < n; i++ ) {
+      ptx_reg_t data;
+      data.u64 = d[i];
+      thread[lane[i]]->set_reg(dst,data);
+   }
+
+   // per-thread back end, in lane order like the per-thread path
+   int op_classification = pI->op_classification();
+   for( unsigned i=0; i < num_active; i++ ) {
+      thread[active[i]]->retire_inst( pI, skip[i]? 0 : op_classification );
+      if( !skip[i] ) {
+         inst.space = undefined_space;
+         inst.set_addr(active[i], 0xFEEBDAED);
+         inst.data_size = 0;
+         assert( inst.memory_op == no_memory_op );
+      }
+   }
+   return true;
 }
 
 void set_param_gpgpu_num_shaders(int num_shaders)
@@ -1426,7 +1936,7 @@ unsigned ptx_sim_init_thread( kernel_info_t &kernel,
       }
       char buf[512];
       snprintf(buf,512,"shared_%u", sid);
-      shared_mem = new memory_space_impl<16*1024>(buf,4);
+      shared_mem = new memory_space_impl<16*1024>(buf);
       shared_memory_lookup[sm_idx] = shared_mem;
       cta_info = new ptx_cta_info(sm_idx);
       ptx_cta_lookup[sm_idx] = cta_info;
@@ -1456,7 +1966,7 @@ unsigned ptx_sim_init_thread( kernel_info_t &kernel,
       } else {
          char buf[512];
          snprintf(buf,512,"local_%u_%u", sid, new_tid);
-         local_mem = new memory_space_impl<32>(buf,32);
+         local_mem = new memory_space_impl<32>(buf);
          local_mem_lookup[new_tid] = local_mem;
       }
       thd->set_info(kernel.entry());
@@ -1614,9 +2124,13 @@ void gpgpu_ptx_sim_memcpy_symbol(const char *hostVar, const void *src, size_t co
    }
    printf("GPGPU-Sim PTX: gpgpu_ptx_sim_memcpy_symbol: copying %s memory %zu bytes %s symbol %s+%zu @0x%x ...\n", 
           mem_name, count, (to?" to ":"from"), sym_name.c_str(), offset, dst );
-   for ( unsigned n=0; n < count; n++ ) {
-      if( to ) mem->write(dst+n,1,((char*)src)+n,NULL,NULL); 
-      else mem->read(dst+n,1,((char*)src)+n); 
+   if( to ) {
+      for ( unsigned n=0; n < count; n++ ) 
+         mem->write(dst+n,1,((char*)src)+n,NULL,NULL); 
+   } else {
+      // const and global symbols both live in global memory; going through 
+      // memcpy_from_gpu lets -gpgpu_resume_kernel replay the copy
+      gpu->memcpy_from_gpu((void*)src,dst,count);
    }
    fflush(stdout);
 }
@@ -1689,6 +2203,39 @@ ptx_cta_info *g_func_cta_info = NULL;
 
 #define MAX(a,b) (((a)>(b))?(a):(b))
 
+// CTA creation and teardown use kernel and thread allocation state shared by
+// all simulation threads; CTAs execute concurrently in between 
+static pthread_mutex_t g_func_cta_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void functional_cta_worker( void *arg, unsigned worker_id )
+{
+    kernel_info_t *kernel = (kernel_info_t*) arg;
+    extern gpgpu_sim *g_the_gpu;
+    while( 1 ) {
+        pthread_mutex_lock(&g_func_cta_mutex);
+        if( kernel->no_more_ctas_to_run() ) {
+            pthread_mutex_unlock(&g_func_cta_mutex);
+            break;
+        }
+        //the worker id selects this thread's shared and local memory
+        functionalCoreSim *cta = new functionalCoreSim(
+            kernel,
+            g_the_gpu,
+            g_the_gpu->getShaderCoreConfig()->warp_size,
+            worker_id
+        );
+        cta->initializeCTA();
+        pthread_mutex_unlock(&g_func_cta_mutex);
+
+        cta->executeCTA();
+
+        pthread_mutex_lock(&g_func_cta_mutex);
+        delete cta;
+        pthread_mutex_unlock(&g_func_cta_mutex);
+    }
+    ptx_sim_flush_thread_insn_count();
+}
+
 /*!
 This function simulates the CUDA code functionally, it takes a kernel_info_t parameter 
 which holds the data for the CUDA kernel to be executed
@@ -1700,14 +2247,20 @@ void gpgpu_cuda_ptx_sim_main_func( kernel_info_t &kernel, bool openCL )
      //using a shader core object for book keeping, it is not needed but as most function built for performance simulation need it we use it here
     extern gpgpu_sim *g_the_gpu;
 
-    //we excute the kernel one CTA (Block) at the time, as synchronization functions work block wise
-    while(!kernel.no_more_ctas_to_run()){
-        functionalCoreSim cta(
-            &kernel,
-            g_the_gpu,
-            g_the_gpu->getShaderCoreConfig()->warp_size
-        );
-        cta.execute();
+    sim_thread_pool *pool = g_the_gpu->get_thread_pool();
+    if( pool ) {
+        //each simulation thread executes one CTA at a time (-gpgpu_sim_threads)
+        pool->run( functional_cta_worker, &kernel, pool->num_threads() );
+    } else {
+        //we excute the kernel one CTA (Block) at the time, as synchronization functions work block wise
+        while(!kernel.no_more_ctas_to_run()){
+            functionalCoreSim cta(
+                &kernel,
+                g_the_gpu,
+                g_the_gpu->getShaderCoreConfig()->warp_size
+            );
+            cta.execute();
+        }
     }
     
    //registering this kernel as done      
@@ -1718,6 +2271,7 @@ void gpgpu_cuda_ptx_sim_main_func( kernel_info_t &kernel, bool openCL )
    g_stream_manager->register_finished_kernel(kernel.get_uid());
 
    //******PRINTING*******
+   ptx_sim_flush_thread_insn_count();
    printf( "GPGPU-Sim: Done functional simulation (%u instructions simulated).\n", g_ptx_sim_num_insn );
    if ( gpgpu_ptx_instruction_classification ) {
       StatDisp( g_inst_classification_stat[g_ptx_kernel_count]);
@@ -1758,7 +2312,7 @@ void functionalCoreSim::initializeCTA()
     
     //get threads for a cta
     for(unsigned i=0; i<m_kernel->threads_per_cta();i++) {
-        ptx_sim_init_thread(*m_kernel,&m_thread[i],0,i,m_kernel->threads_per_cta()-i,m_kernel->threads_per_cta(),this,0,i/m_warp_size,(gpgpu_t*)m_gpu, true);
+        ptx_sim_init_thread(*m_kernel,&m_thread[i],m_sid,m_tid_base+i,m_kernel->threads_per_cta()-i,m_kernel->threads_per_cta(),this,0,i/m_warp_size,(gpgpu_t*)m_gpu, true);
         assert(m_thread[i]!=NULL && !m_thread[i]->is_done());
         ctaLiveThreads++;
     }
@@ -1785,7 +2339,11 @@ void  functionalCoreSim::createWarp(unsigned warpId)
 void functionalCoreSim::execute()
  {
     initializeCTA();
-    
+    executeCTA();
+ }
+
+void functionalCoreSim::executeCTA()
+ {
     //start executing the CTA
     while(true){
         bool someOneLive= false;
@@ -1806,6 +2364,9 @@ void functionalCoreSim::executeWarp(unsigned i, bool &allAtBarrier, bool & someO
     if(!m_warpAtBarrier[i] && m_liveThreadCount[i]!=0){
         warp_inst_t inst =getExecuteWarp(i);
         execute_warp_inst_t(inst,i);
+        m_n_insn += inst.active_count();
+        if(m_warm_caches && inst.space.is_global() && (inst.is_load() || inst.is_store())) 
+            m_gpu->warm_caches(inst,m_sid);
         if(inst.isatomic()) inst.do_atomic(true);
         if(inst.op==BARRIER_OP || inst.op==MEMORY_BARRIER_OP ) m_warpAtBarrier[i]=true;
         updateSIMTStack( i, &inst );
@@ -73,6 +73,10 @@ unsigned ptx_sim_init_thread( kernel_info_t &kernel,
                               gpgpu_t *gpu,
                               bool functionalSimulationMode = false);
 const warp_inst_t *ptx_fetch_inst( address_type pc );
+bool ptx_exec_warp_inst( warp_inst_t &inst, class ptx_thread_info **thread, unsigned warp_size );
+extern bool g_ptx_sim_multithreaded;
+void ptx_sim_set_multithreaded( bool multithreaded );
+void ptx_sim_flush_thread_insn_count();
 const struct gpgpu_ptx_sim_kernel_info* ptx_sim_kernel_info(const class function_info *kernel);
 void ptx_print_insn( address_type pc, FILE *fp );
 std::string ptx_get_insn_str( address_type pc );
@@ -85,9 +89,13 @@ void set_param_gpgpu_num_shaders(int num_shaders);
 class functionalCoreSim: public core_t
 {    
 public:
-    functionalCoreSim(kernel_info_t * kernel, gpgpu_sim *g, unsigned warp_size)
+    functionalCoreSim(kernel_info_t * kernel, gpgpu_sim *g, unsigned warp_size, unsigned sid = 0)
         : core_t( g, kernel, warp_size, kernel->threads_per_cta() )
     {
+        m_sid = sid;
+        m_tid_base = 0;
+        m_warm_caches = false;
+        m_n_insn = 0;
         m_warpAtBarrier =  new bool [m_warp_count];
         m_liveThreadCount = new unsigned [m_warp_count];
     }
@@ -98,16 +106,28 @@ public:
     }
     //! executes all warps till completion 
     void execute();
+    //! initializes threads in the CTA block which we are executing
+    void initializeCTA();
+    //! executes the warps of an initialized CTA till completion 
+    void executeCTA();
     virtual void warp_exit( unsigned warp_id );
     virtual bool warp_waiting_at_barrier( unsigned warp_id ) const  
     {
         return (m_warpAtBarrier[warp_id] || !(m_liveThreadCount[warp_id]>0));
     }
+    //! fast-forwarded CTA of sampled simulation (-gpgpu_sampling): its threads
+    //! are numbered from tid_base so they do not share memory with the CTAs  
+    //! running on shader core sid, whose caches its global accesses warm 
+    void set_fast_forward( unsigned tid_base, bool warm_caches ) 
+    { 
+        m_tid_base = tid_base; 
+        m_warm_caches = warm_caches; 
+    }
+    //! thread instructions executed 
+    unsigned long long get_n_insn() const { return m_n_insn; }
     
 private:
     void executeWarp(unsigned, bool &, bool &);
-    //initializes threads in the CTA block which we are executing
-    void initializeCTA();
     virtual void checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned t, unsigned tid)
     {
     if(m_thread[tid]==NULL || m_thread[tid]->is_done()){
@@ -121,6 +141,11 @@ private:
     //each warp live thread count and barrier indicator
     unsigned * m_liveThreadCount;
     bool* m_warpAtBarrier;
+    //selects the shared and local memory given to the CTA by ptx_sim_init_thread
+    unsigned m_sid;
+    unsigned m_tid_base;
+    bool m_warm_caches;
+    unsigned long long m_n_insn;
 };
 
 #define RECONVERGE_RETURN_PC ((address_type)-2)
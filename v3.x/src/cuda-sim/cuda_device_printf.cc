@@ -30,18 +30,27 @@
 
 void decode_space( memory_space_t &space, ptx_thread_info *thread, const operand_info &op, memory_space *&mem, addr_t &addr);
 
+// set while a SIMT core cluster is simulated on a pool thread (-gpgpu_sim_threads > 1)
+static __thread std::string *t_printf_stage = NULL;
+
+void cuda_printf_set_stage( std::string *stage )
+{
+   t_printf_stage = stage;
+}
+
 void my_cuda_printf(const char *fmtstr,const char *arg_list)
 {
-   FILE *fp = stdout;
+   std::string out;
    unsigned i=0,j=0;
    unsigned arg_offset=0;
    char buf[64];
+   char field[512]; // large enough for %f of any double
    bool in_fmt=false;
    while( fmtstr[i] ) {
       char c = fmtstr[i++];
       if( !in_fmt ) {
          if( c != '%' ) {
-            fprintf(fp,"%c",c);
+            out += c;
          } else {
             in_fmt=true;
             buf[0] = c;
@@ -57,15 +66,23 @@ void my_cuda_printf(const char *fmtstr,const char *arg_list)
          void* ptr = (void*)&arg_list[arg_offset];
          //unsigned long long value = ((unsigned long long*)arg_list)[arg_offset];
          if( c == 'u' || c == 'd' ) {
-            fprintf(fp,buf,*((unsigned long long*)ptr));
+            snprintf(field,sizeof(field),buf,*((unsigned long long*)ptr));
+            out += field;
          } else if( c == 'f' ) {
             double tmp = *((double*)ptr);
-            fprintf(fp,buf,tmp);
+            snprintf(field,sizeof(field),buf,tmp);
+            out += field;
          }
          arg_offset++;
          in_fmt=false;
       }
    }
+   // the whole line is emitted at once; in parallel simulation it is staged and
+   // written by simt_core_cluster::commit_cycle() in cluster order
+   if( t_printf_stage ) 
+      t_printf_stage->append(out);
+   else 
+      fputs(out.c_str(),stdout);
 }
 
 void gpgpusim_cuda_vprintf(const ptx_instruction * pI, ptx_thread_info * thread, const function_info * target_func ) 
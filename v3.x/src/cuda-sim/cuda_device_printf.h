@@ -28,6 +28,11 @@
 #ifndef CUDA_DEVICE_PRINTF_INCLUDED
 #define CUDA_DEVICE_PRINTF_INCLUDED
 
+#include <string>
+
 void gpgpusim_cuda_vprintf(const class ptx_instruction * pI, class ptx_thread_info * thread, const class function_info * target_func );
+// device printf output of the calling host thread is appended to stage 
+// instead of stdout while stage is non-NULL
+void cuda_printf_set_stage( std::string *stage );
 
 #endif
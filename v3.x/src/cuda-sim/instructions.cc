@@ -56,13 +56,27 @@ ptx_reg_t srcOperandModifiers(ptx_reg_t opData, operand_info opInfo, operand_inf
 
 void sign_extend( ptx_reg_t &data, unsigned src_size, const operand_info &dst );
 
+ptx_reg_t &ptx_thread_info::reg_ref( const symbol *reg )
+{
+   assert( reg->has_reg_slot() );
+   unsigned idx = m_reg_frame_base + reg->reg_slot();
+   if( idx >= m_regs.size() ) {
+      // frames are sized on first touch as the callee is not known at call time
+      m_regs.resize( idx+1 );
+      m_regs_valid.resize( idx+1, 0 );
+   }
+   m_regs_valid[idx] = 1;
+   return m_regs[idx];
+}
+
 void ptx_thread_info::set_reg( const symbol *reg, const ptx_reg_t &value ) 
 {
    assert( reg != NULL );
-   if( reg->name() == "_" ) return;
-   assert( !m_regs.empty() );
-   assert( reg->uid() > 0 );
-   m_regs.back()[ reg ] = value;
+   if( !reg->has_reg_slot() ) {
+      assert( reg->name() == "_" );
+      return;
+   }
+   reg_ref(reg) = value;
    if (m_enable_debug_trace ) 
       m_debug_trace_regs_modified.back()[ reg ] = value;
    m_last_set_operand_value = value;
@@ -72,9 +86,8 @@ ptx_reg_t ptx_thread_info::get_reg( const symbol *reg )
 {
    static bool unfound_register_warned = false;
    assert( reg != NULL );
-   assert( !m_regs.empty() );
-   reg_map_t::iterator regs_iter = m_regs.back().find(reg);
-   if (regs_iter == m_regs.back().end()) {
+   unsigned idx = m_reg_frame_base + reg->reg_slot();
+   if( !reg->has_reg_slot() || idx >= m_regs.size() || !m_regs_valid[idx] ) {
       assert( reg->type()->get_key().is_reg() );
       const std::string &name = reg->name();
       unsigned call_uid = m_callstack.back().m_call_uid;
@@ -88,17 +101,28 @@ ptx_reg_t ptx_thread_info::get_reg( const symbol *reg )
                  file_loc.c_str(), name.c_str(), call_uid );
           unfound_register_warned = true;
       }
-      regs_iter = m_regs.back().find(reg);
+      if( !reg->has_reg_slot() ) 
+         return uninit_reg;
    }
    if (m_enable_debug_trace ) 
-      m_debug_trace_regs_read.back()[ reg ] = regs_iter->second;
-   return regs_iter->second;
+      m_debug_trace_regs_read.back()[ reg ] = m_regs[idx];
+   return m_regs[idx];
 }
 
 ptx_reg_t ptx_thread_info::get_operand_value( const operand_info &op, operand_info dstInfo, unsigned opType, ptx_thread_info *thread, int derefFlag )
 {
    ptx_reg_t result, tmp;
 
+   // plain register or literal, resolved in pre_decode
+   if( op.fast_kind() != operand_info::FAST_NONE && 
+       opType != BB128_TYPE && opType != BB64_TYPE && opType != FF64_TYPE ) {
+      if( op.fast_kind() == operand_info::FAST_LITERAL ) 
+         return op.fast_literal();
+      unsigned idx = m_reg_frame_base + op.fast_reg_slot();
+      if( idx < m_regs.size() && m_regs_valid[idx] ) 
+         return m_regs[idx];
+      return get_reg( op.get_symbol() ); // warns about the undefined register
+   }
 
    if(op.get_double_operand_type() == 0) {
       if(((opType != BB128_TYPE) && (opType != BB64_TYPE) && (opType != FF64_TYPE)) || (op.get_addr_space() != undefined_space)) {
@@ -333,9 +357,9 @@ void ptx_thread_info::get_vector_operand_values( const operand_info &op, ptx_reg
       const symbol *sym = NULL;
       sym = op.vec_symbol(idx);
       if( strcmp(sym->name().c_str(),"_") != 0) {
-         reg_map_t::iterator reg_iter = m_regs.back().find(sym);
-         assert( reg_iter != m_regs.back().end() );
-         ptx_regs[idx] = reg_iter->second;
+         unsigned slot = m_reg_frame_base + sym->reg_slot();
+         assert( sym->has_reg_slot() && slot < m_regs.size() && m_regs_valid[slot] );
+         ptx_regs[idx] = m_regs[slot];
       }
    }
 }
@@ -371,7 +395,7 @@ void ptx_thread_info::set_operand_value( const operand_info &dst, const ptx_reg_
         ptx_reg_t predValue;
         
         const symbol *sym = dst.vec_symbol(0);
-        predValue.u64 = (m_regs.back()[ sym ].u64) & ~(0x0C);
+        predValue.u64 = (reg_ref(sym).u64) & ~(0x0C);
         predValue.u64 |= ((overflow & 0x01)<<3);
         predValue.u64 |= ((carry & 0x01)<<2);
 
@@ -396,6 +420,14 @@ void ptx_thread_info::set_operand_value( const operand_info &dst, const ptx_reg_
    size_t size;
    int t;
 
+   if( dst.fast_kind() == operand_info::FAST_REG && 
+       type != BB128_TYPE && type != BB64_TYPE && type != FF64_TYPE ) {
+      ptx_reg_t setValue;
+      setValue.u64 = data.u64;
+      set_reg(dst.get_symbol(),setValue);
+      return;
+   }
+
    type_info_key::type_decode(type,size,t);
 
    /*complete this section for other cases*/
@@ -498,11 +530,11 @@ void ptx_thread_info::set_operand_value( const operand_info &dst, const ptx_reg_
 
           if(dst.get_operand_lohi() == 1)
           {
-              setValue.u64 = ((m_regs.back()[ regName ].u64) & (~(0xFFFF))) + (data.u64 & 0xFFFF);
+              setValue.u64 = ((reg_ref(regName).u64) & (~(0xFFFF))) + (data.u64 & 0xFFFF);
           }
           else if(dst.get_operand_lohi() == 2)
           {
-              setValue.u64 = ((m_regs.back()[ regName ].u64) & (~(0xFFFF0000))) + ((data.u64<<16) & 0xFFFF0000);
+              setValue.u64 = ((reg_ref(regName).u64) & (~(0xFFFF0000))) + ((data.u64<<16) & 0xFFFF0000);
           }
 
           set_reg(predName,predValue);
@@ -555,11 +587,11 @@ void ptx_thread_info::set_operand_value( const operand_info &dst, const ptx_reg_
       {
           if(dst.get_operand_lohi() == 1)
           {
-              setValue.u64 = ((m_regs.back()[ dst.get_symbol() ].u64) & (~(0xFFFF))) + (data.u64 & 0xFFFF);
+              setValue.u64 = ((reg_ref(dst.get_symbol()).u64) & (~(0xFFFF))) + (data.u64 & 0xFFFF);
           }
           else if(dst.get_operand_lohi() == 2)
           {
-              setValue.u64 = ((m_regs.back()[ dst.get_symbol() ].u64) & (~(0xFFFF0000))) + ((data.u64<<16) & 0xFFFF0000);
+              setValue.u64 = ((reg_ref(dst.get_symbol()).u64) & (~(0xFFFF0000))) + ((data.u64<<16) & 0xFFFF0000);
           }
           set_reg(dst.get_symbol(),setValue);
       }
@@ -1320,7 +1352,7 @@ void call_impl( const ptx_instruction *pI, ptx_thread_info *thread )
       assert( callee_pc == thread->get_pc() );
    }
 
-   thread->callstack_push(callee_pc + pI->inst_size(), callee_rpc, return_var_src, return_var_dst, call_uid_next++);
+   thread->callstack_push(callee_pc + pI->inst_size(), callee_rpc, return_var_src, return_var_dst, __sync_fetch_and_add(&call_uid_next,1));
 
    copy_buffer_list_into_frame(thread, arg_values);
 
@@ -1346,7 +1378,7 @@ void callp_impl( const ptx_instruction *pI, ptx_thread_info *thread )
       assert( callee_pc == thread->get_pc() );
    } 
 
-   thread->callstack_push_plus(callee_pc + pI->inst_size(), callee_rpc, return_var_src, return_var_dst, call_uid_next++);
+   thread->callstack_push_plus(callee_pc + pI->inst_size(), callee_rpc, return_var_src, return_var_dst, __sync_fetch_and_add(&call_uid_next,1));
    thread->set_npc(target_pc);
 }
 
@@ -3673,8 +3705,6 @@ void sured_impl( const ptx_instruction *pI, ptx_thread_info *thread ) { inst_not
 void sust_impl( const ptx_instruction *pI, ptx_thread_info *thread ) { inst_not_implemented(pI); }
 void suq_impl( const ptx_instruction *pI, ptx_thread_info *thread ) { inst_not_implemented(pI); }
 
-ptx_reg_t* ptx_tex_regs = NULL;
-
 union intfloat {
    int a;
    float b;
@@ -3787,9 +3817,12 @@ void tex_impl( const ptx_instruction *pI, ptx_thread_info *thread )
    unsigned c_type = pI->get_type2();
    fflush(stdout);
    ptx_reg_t data1, data2, data3, data4;
-   if (!ptx_tex_regs) ptx_tex_regs = new ptx_reg_t[4];
+   // per call: threads of different clusters (-gpgpu_sim_threads) and 
+   // functional CTA workers execute tex concurrently
+   ptx_reg_t tex_regs[4];
    unsigned nelem = src2.get_vect_nelem();
-   thread->get_vector_operand_values(src2, ptx_tex_regs, nelem); //ptx_reg should be 4 entry vector type...coordinates into texture
+   assert(nelem <= 4);
+   thread->get_vector_operand_values(src2, tex_regs, nelem); //ptx_reg should be 4 entry vector type...coordinates into texture
 
    gpgpu_t *gpu = thread->get_gpu();
    const struct textureReference* texref = gpu->get_texref(texname);
@@ -3819,7 +3852,7 @@ void tex_impl( const ptx_instruction *pI, ptx_thread_info *thread )
       height = cuArray->height;
       if (texref->normalized) {
          assert(c_type == F32_TYPE); 
-         x_f32 = ptx_tex_regs[0].f32;
+         x_f32 = tex_regs[0].f32;
          if (texref->addressMode[0] == cudaAddressModeClamp) {
             x_f32 = (x_f32 > 1.0)? 1.0 : x_f32;
             x_f32 = (x_f32 < 0.0)? 0.0 : x_f32;
@@ -3842,11 +3875,11 @@ void tex_impl( const ptx_instruction *pI, ptx_thread_info *thread )
       } else {
          switch ( c_type ) {
          case S32_TYPE: 
-            x = ptx_tex_regs[0].s32; 
+            x = tex_regs[0].s32; 
             assert(texref->filterMode == cudaFilterModePoint); 
             break; 
          case F32_TYPE: 
-            x_f32 = ptx_tex_regs[0].f32; 
+            x_f32 = tex_regs[0].f32; 
             alpha = x_f32 - floor(x_f32); // offset into subtexel (for linear sampling)
             x = (int) x_f32; 
             break; 
@@ -3869,8 +3902,8 @@ void tex_impl( const ptx_instruction *pI, ptx_thread_info *thread )
       width = cuArray->width;
       height = cuArray->height;
       if (texref->normalized) {
-         x_f32 = reduce_precision(ptx_tex_regs[0].f32,16);
-         y_f32 = reduce_precision(ptx_tex_regs[1].f32,15);
+         x_f32 = reduce_precision(tex_regs[0].f32,16);
+         y_f32 = reduce_precision(tex_regs[1].f32,15);
 
          if (texref->addressMode[0]) {//clamp
             if (x_f32<0) x_f32 = 0;
@@ -3900,8 +3933,8 @@ void tex_impl( const ptx_instruction *pI, ptx_thread_info *thread )
             y = (int) floor(y_f32 * height);
          }
       } else {
-         x_f32 = ptx_tex_regs[0].f32;
-         y_f32 = ptx_tex_regs[1].f32;
+         x_f32 = tex_regs[0].f32;
+         y_f32 = tex_regs[1].f32;
 
          alpha = x_f32 - floor(x_f32);
          beta = y_f32 - floor(y_f32);
@@ -4062,16 +4095,19 @@ void vsub_impl( const ptx_instruction *pI, ptx_thread_info *thread ) { inst_not_
 
 void vote_impl( const ptx_instruction *pI, ptx_thread_info *thread ) 
 {
-   static bool first_in_warp = true;
-   static bool and_all;
-   static bool or_all;
-   static unsigned int ballot_result;
-   static std::list<ptx_thread_info*> threads_in_warp;
-   static unsigned last_tid;
+   // state carried across the lanes of one warp; thread local since shader 
+   // cores may be simulated by several host threads (-gpgpu_sim_threads)
+   static __thread bool first_in_warp = true;
+   static __thread bool and_all;
+   static __thread bool or_all;
+   static __thread unsigned int ballot_result;
+   static __thread ptx_thread_info *threads_in_warp[MAX_WARP_SIZE];
+   static __thread unsigned n_threads_in_warp;
+   static __thread unsigned last_tid;
 
    if( first_in_warp ) {
       first_in_warp = false;
-      threads_in_warp.clear();
+      n_threads_in_warp = 0;
       and_all = true;
       or_all = false;
       ballot_result = 0;
@@ -4091,7 +4127,8 @@ void vote_impl( const ptx_instruction *pI, ptx_thread_info *thread )
    bool pred_value = !(src1_data.pred & 0x0001);
    bool invert = src1.is_neg_pred();
 
-   threads_in_warp.push_back(thread);
+   assert( n_threads_in_warp < MAX_WARP_SIZE );
+   threads_in_warp[n_threads_in_warp++] = thread;
    and_all &= (invert ^ pred_value);
    or_all |= (invert ^ pred_value);
 
@@ -4104,9 +4141,9 @@ void vote_impl( const ptx_instruction *pI, ptx_thread_info *thread )
    if( thread->get_hw_tid() == last_tid ) {
       if (pI->vote_mode() == ptx_instruction::vote_ballot) {
          ptx_reg_t data = ballot_result; 
-         for( std::list<ptx_thread_info*>::iterator t=threads_in_warp.begin(); t!=threads_in_warp.end(); ++t ) {
+         for( unsigned t=0; t < n_threads_in_warp; t++ ) {
             const operand_info &dst = pI->dst();
-            (*t)->set_operand_value(dst,data, pI->get_type(), (*t), pI);
+            threads_in_warp[t]->set_operand_value(dst,data, pI->get_type(), threads_in_warp[t], pI);
          }
       } else {
          bool pred_value = false; 
@@ -4121,9 +4158,9 @@ void vote_impl( const ptx_instruction *pI, ptx_thread_info *thread )
          ptx_reg_t data;
          data.pred = pred_value?0:1; //the way ptxplus handles the zero flag, 1 = false and 0 = true
 
-         for( std::list<ptx_thread_info*>::iterator t=threads_in_warp.begin(); t!=threads_in_warp.end(); ++t ) {
+         for( unsigned t=0; t < n_threads_in_warp; t++ ) {
             const operand_info &dst = pI->dst();
-            (*t)->set_operand_value(dst,data, PRED_TYPE, (*t), pI);
+            threads_in_warp[t]->set_operand_value(dst,data, PRED_TYPE, threads_in_warp[t], pI);
          }
       }
       first_in_warp = true;
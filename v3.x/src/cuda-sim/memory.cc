@@ -29,10 +29,11 @@
 #include <stdlib.h>
 #include "../debug.h"
 
-template<unsigned BSIZE> memory_space_impl<BSIZE>::memory_space_impl( std::string name, unsigned hash_size )
+template<unsigned BSIZE> memory_space_impl<BSIZE>::memory_space_impl( std::string name )
 {
    m_name = name;
-   MEM_MAP_RESIZE(hash_size);
+   m_last_block = NULL;
+   m_block_locks = NULL;
 
    m_log2_block_size = -1;
    for( unsigned n=0, mask=1; mask != 0; mask <<= 1, n++ ) {
@@ -44,6 +45,91 @@ template<unsigned BSIZE> memory_space_impl<BSIZE>::memory_space_impl( std::strin
    assert( m_log2_block_size != (unsigned)-1 );
 }
 
+template<unsigned BSIZE> memory_space_impl<BSIZE>::~memory_space_impl()
+{
+   clear();
+   if( m_block_locks ) {
+      for( unsigned n=0; n < N_BLOCK_LOCKS; n++ ) 
+         pthread_mutex_destroy(&m_block_locks[n].mutex);
+      delete[] m_block_locks;
+   }
+}
+
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::enable_concurrent_access()
+{
+   if( m_block_locks ) 
+      return;
+   m_block_locks = new block_lock[N_BLOCK_LOCKS];
+   for( unsigned n=0; n < N_BLOCK_LOCKS; n++ ) 
+      pthread_mutex_init(&m_block_locks[n].mutex,NULL);
+   m_dir.resize( (((mem_addr_t)-1) >> m_log2_block_size >> LEAF_BITS) + 1, NULL );
+}
+
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::clear()
+{
+   for( unsigned d=0; d < m_dir.size(); d++ ) {
+      block_t **leaf = m_dir[d];
+      if( leaf == NULL ) 
+         continue;
+      for( unsigned n=0; n < LEAF_SIZE; n++ ) 
+         delete leaf[n];
+      delete[] leaf;
+   }
+   m_dir.clear();
+   if( m_block_locks ) 
+      m_dir.resize( (((mem_addr_t)-1) >> m_log2_block_size >> LEAF_BITS) + 1, NULL );
+   m_last_block = NULL;
+}
+
+template<unsigned BSIZE> mem_storage<BSIZE> *memory_space_impl<BSIZE>::find_block( mem_addr_t blk_idx ) const
+{
+   // m_last_block is shared by concurrent accesses (see enable_concurrent_access);
+   // the acquire/release pair makes the block's construction visible to the
+   // thread that picks it up. Any block pointer it holds stays valid until 
+   // the memory space is cleared.
+   block_t *blk = __atomic_load_n(&m_last_block,__ATOMIC_ACQUIRE);
+   if( blk && blk->index() == blk_idx ) 
+      return blk;
+   mem_addr_t d = blk_idx >> LEAF_BITS;
+   if( d >= m_dir.size() ) 
+      return NULL;
+   block_t **leaf = __atomic_load_n(&m_dir[d],__ATOMIC_ACQUIRE);
+   if( leaf == NULL ) 
+      return NULL;
+   blk = __atomic_load_n(&leaf[blk_idx & LEAF_MASK],__ATOMIC_ACQUIRE);
+   if( blk ) 
+      __atomic_store_n(&m_last_block,blk,__ATOMIC_RELEASE);
+   return blk;
+}
+
+// with concurrent access enabled the caller holds lock_block(blk_idx)
+template<unsigned BSIZE> mem_storage<BSIZE> *memory_space_impl<BSIZE>::get_block( mem_addr_t blk_idx )
+{
+   block_t *blk = find_block(blk_idx);
+   if( blk ) 
+      return blk;
+   mem_addr_t d = blk_idx >> LEAF_BITS;
+   if( d >= m_dir.size() ) {
+      assert( !m_block_locks );
+      m_dir.resize(d+1,NULL);
+   }
+   block_t **leaf = __atomic_load_n(&m_dir[d],__ATOMIC_ACQUIRE);
+   if( leaf == NULL ) {
+      leaf = new block_t*[LEAF_SIZE];
+      memset(leaf,0,LEAF_SIZE*sizeof(block_t*));
+      block_t **expected = NULL;
+      if( !__atomic_compare_exchange_n(&m_dir[d],&expected,leaf,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) {
+         // another thread installed this leaf first
+         delete[] leaf;
+         leaf = expected;
+      }
+   }
+   blk = new block_t(blk_idx);
+   __atomic_store_n(&leaf[blk_idx & LEAF_MASK],blk,__ATOMIC_RELEASE);
+   __atomic_store_n(&m_last_block,blk,__ATOMIC_RELEASE);
+   return blk;
+}
+
 template<unsigned BSIZE> void memory_space_impl<BSIZE>::write( mem_addr_t addr, size_t length, const void *data, class ptx_thread_info *thd, const ptx_instruction *pI)
 {
    mem_addr_t index = addr >> m_log2_block_size;
@@ -51,7 +137,9 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::write( mem_addr_t addr,
       // fast route for intra-block access 
       unsigned offset = addr & (BSIZE-1);
       unsigned nbytes = length;
-      m_data[index].write(offset,nbytes,(const unsigned char*)data);
+      lock_block(index);
+      get_block(index)->write(offset,nbytes,(const unsigned char*)data);
+      unlock_block(index);
    } else {
       // slow route for inter-block access
       unsigned nbytes_remain = length;
@@ -67,7 +155,9 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::write( mem_addr_t addr,
          } 
          
          size_t tx_bytes = access_limit - offset; 
-         m_data[page].write(offset, tx_bytes, &((const unsigned char*)data)[src_offset]);
+         lock_block(page);
+         get_block(page)->write(offset, tx_bytes, &((const unsigned char*)data)[src_offset]);
+         unlock_block(page);
 
          // advance pointers 
          src_offset += tx_bytes; 
@@ -95,16 +185,17 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::read_single_block( mem_a
              (addr+length),(blk_idx+1)*BSIZE, blk_idx, BSIZE);
       throw 1;
    }
-   typename map_t::const_iterator i = m_data.find(blk_idx);
-   if( i == m_data.end() ) {
-      for( size_t n=0; n < length; n++ ) 
-         ((unsigned char*)data)[n] = (unsigned char) 0;
+   lock_block(blk_idx);
+   const block_t *blk = find_block(blk_idx);
+   if( blk == NULL ) {
+      memset(data,0,length);
       //printf("GPGPU-Sim PTX:  WARNING reading %zu bytes from unititialized memory at address 0x%x in space %s\n", length, addr, m_name.c_str() );
    } else {
       unsigned offset = addr & (BSIZE-1);
       unsigned nbytes = length;
-      i->second.read(offset,nbytes,(unsigned char*)data);
+      blk->read(offset,nbytes,(unsigned char*)data);
    }
+   unlock_block(blk_idx);
 }
 
 template<unsigned BSIZE> void memory_space_impl<BSIZE>::read( mem_addr_t addr, size_t length, void *data ) const
@@ -141,10 +232,16 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::read( mem_addr_t addr, s
 
 template<unsigned BSIZE> void memory_space_impl<BSIZE>::print( const char *format, FILE *fout ) const
 {
-   typename map_t::const_iterator i_page;
-   for (i_page = m_data.begin(); i_page != m_data.end(); ++i_page) {
-      fprintf(fout, "%s - %#x:", m_name.c_str(), i_page->first);
-      i_page->second.print(format, fout);
+   for( unsigned d=0; d < m_dir.size(); d++ ) {
+      if( m_dir[d] == NULL ) 
+         continue;
+      for( unsigned n=0; n < LEAF_SIZE; n++ ) {
+         const block_t *blk = m_dir[d][n];
+         if( blk == NULL ) 
+            continue;
+         fprintf(fout, "%s - %#x:", m_name.c_str(), blk->index());
+         blk->print(format, fout);
+      }
    }
 }
 
@@ -153,6 +250,44 @@ template<unsigned BSIZE> void memory_space_impl<BSIZE>::set_watch( addr_t addr,
    m_watchpoints[watchpoint]=addr;
 }
 
+// blocks are saved as (block number, contents) pairs in address order
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::checkpoint( FILE *fp ) const
+{
+   unsigned nblocks = 0;
+   for( unsigned d=0; d < m_dir.size(); d++ ) {
+      if( m_dir[d] == NULL ) 
+         continue;
+      for( unsigned n=0; n < LEAF_SIZE; n++ ) 
+         nblocks += (m_dir[d][n] != NULL);
+   }
+   checkpoint_write_section(fp,"MEMS",BSIZE);
+   checkpoint_write(fp,nblocks);
+   for( unsigned d=0; d < m_dir.size(); d++ ) {
+      if( m_dir[d] == NULL ) 
+         continue;
+      for( unsigned n=0; n < LEAF_SIZE; n++ ) {
+         const block_t *blk = m_dir[d][n];
+         if( blk == NULL ) 
+            continue;
+         checkpoint_write(fp,blk->index());
+         blk->checkpoint(fp);
+      }
+   }
+}
+
+template<unsigned BSIZE> void memory_space_impl<BSIZE>::restore( FILE *fp )
+{
+   clear();
+   unsigned nblocks;
+   checkpoint_read_section(fp,"MEMS",BSIZE);
+   checkpoint_read(fp,nblocks);
+   for( unsigned b=0; b < nblocks; b++ ) {
+      mem_addr_t blk_idx;
+      checkpoint_read(fp,blk_idx);
+      get_block(blk_idx)->restore(fp);
+   }
+}
+
 template class memory_space_impl<32>;
 template class memory_space_impl<64>;
 template class memory_space_impl<8192>;
@@ -168,7 +303,7 @@ void g_print_memory_space(memory_space *mem, const char *format = "%08x", FILE *
 int main(int argc, char *argv[] )
 {
    int errors_found=0;
-   memory_space *mem = new memory_space_impl<32>("test",4);
+   memory_space *mem = new memory_space_impl<32>("test");
    // write address to [address]
    for( mem_addr_t addr=0; addr < 16*1024; addr+=4) 
       mem->write(addr,4,&addr,NULL,NULL);
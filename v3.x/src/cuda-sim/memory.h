@@ -29,21 +29,16 @@
 #define memory_h_INCLUDED
 
 #include "../abstract_hardware_model.h"
-
-#include "../tr1_hash_map.h"
-#define mem_map tr1_hash_map
-#if tr1_hash_map_ismap == 1
-   #define MEM_MAP_RESIZE(hash_size) 
-#else
-   #define MEM_MAP_RESIZE(hash_size) (m_data.rehash(hash_size))
-#endif
+#include "../checkpoint.h"
 
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
 #include <string>
 #include <map>
+#include <vector>
 #include <stdlib.h>
+#include <pthread.h>
 
 typedef address_type mem_addr_t;
 
@@ -51,20 +46,14 @@ typedef address_type mem_addr_t;
 
 template<unsigned BSIZE> class mem_storage {
 public:
-   mem_storage( const mem_storage &another )
-   {
-      m_data = (unsigned char*)calloc(1,BSIZE);
-      memcpy(m_data,another.m_data,BSIZE);
-   }
-   mem_storage()
-   {
-      m_data = (unsigned char*)calloc(1,BSIZE);
-   }
-   ~mem_storage()
+   mem_storage( mem_addr_t index )
    {
-      free(m_data);
+      m_index = index;
+      memset(m_data,0,BSIZE);
    }
 
+   mem_addr_t index() const { return m_index; }
+
    void write( unsigned offset, size_t length, const unsigned char *data )
    {
       assert( offset + length <= BSIZE );
@@ -91,9 +80,12 @@ public:
       fflush(fout);
    }
 
+   void checkpoint( FILE *fp ) const { checkpoint_write_bytes(fp,m_data,BSIZE); }
+   void restore( FILE *fp ) { checkpoint_read_bytes(fp,m_data,BSIZE); }
+
 private:
-   unsigned m_nbytes;
-   unsigned char *m_data;
+   mem_addr_t m_index; // block number (address / BSIZE)
+   unsigned char m_data[BSIZE];
 };
 
 class ptx_thread_info;
@@ -107,23 +99,62 @@ public:
    virtual void read( mem_addr_t addr, size_t length, void *data ) const = 0;
    virtual void print( const char *format, FILE *fout ) const = 0;
    virtual void set_watch( addr_t addr, unsigned watchpoint ) = 0;
+   // save/replace the whole contents (see -gpgpu_checkpoint_kernel)
+   virtual void checkpoint( FILE *fp ) const = 0;
+   virtual void restore( FILE *fp ) = 0;
+   // allow read() and write() from several host threads at once (see
+   // -gpgpu_sim_threads); the other operations remain single threaded
+   virtual void enable_concurrent_access() = 0;
 };
 
 template<unsigned BSIZE> class memory_space_impl : public memory_space {
 public:
-   memory_space_impl( std::string name, unsigned hash_size );
+   memory_space_impl( std::string name );
+   virtual ~memory_space_impl();
 
    virtual void write( mem_addr_t addr, size_t length, const void *data, ptx_thread_info *thd, const ptx_instruction *pI );
    virtual void read( mem_addr_t addr, size_t length, void *data ) const;
    virtual void print( const char *format, FILE *fout ) const;
    virtual void set_watch( addr_t addr, unsigned watchpoint ); 
+   virtual void checkpoint( FILE *fp ) const;
+   virtual void restore( FILE *fp );
+   virtual void enable_concurrent_access();
 
 private:
+   typedef mem_storage<BSIZE> block_t;
+
    void read_single_block( mem_addr_t blk_idx, mem_addr_t addr, size_t length, void *data) const; 
+   block_t *find_block( mem_addr_t blk_idx ) const;
+   block_t *get_block( mem_addr_t blk_idx );
+   void clear();
+   void lock_block( mem_addr_t blk_idx ) const { if( m_block_locks ) pthread_mutex_lock(&m_block_locks[blk_idx % N_BLOCK_LOCKS].mutex); }
+   void unlock_block( mem_addr_t blk_idx ) const { if( m_block_locks ) pthread_mutex_unlock(&m_block_locks[blk_idx % N_BLOCK_LOCKS].mutex); }
+
    std::string m_name;
    unsigned m_log2_block_size;
-   typedef mem_map<mem_addr_t,mem_storage<BSIZE> > map_t;
-   map_t m_data;
+
+   // Blocks are found through a two level table indexed by block number: 
+   // m_dir[blk_idx >> LEAF_BITS][blk_idx & LEAF_MASK]. Leaves and blocks are 
+   // allocated on the first write to them, unwritten memory reads as zero.
+   enum { 
+      LEAF_BITS = (BSIZE >= 4096) ? 9 : 6,
+      LEAF_SIZE = 1 << LEAF_BITS,
+      LEAF_MASK = LEAF_SIZE - 1
+   };
+   std::vector<block_t**> m_dir;
+   mutable block_t *m_last_block; // most recently accessed block, checked first
+
+   // Concurrent access: m_dir covers the whole address range so it never 
+   // moves, leaves are installed with a compare-and-swap, and the data of 
+   // a block (and its allocation) is protected by one of N_BLOCK_LOCKS 
+   // mutexes striped by block number.
+   enum { N_BLOCK_LOCKS = 64 };
+   union block_lock {
+      pthread_mutex_t mutex;
+      char pad[64]; // one cache line each
+   };
+   block_lock *m_block_locks; // NULL unless enable_concurrent_access() was called
+
    std::map<unsigned,mem_addr_t> m_watchpoints;
 };
 
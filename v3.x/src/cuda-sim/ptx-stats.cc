@@ -31,6 +31,7 @@
 #include "../option_parser.h"
 #include <stdio.h>
 #include <map>
+#include <pthread.h>
 #include "../tr1_hash_map.h"
 
 // options
@@ -117,6 +118,31 @@ typedef tr1_hash_map<ptx_file_line, ptx_file_line_stats, hash_ptx_file_line> ptx
 
 static ptx_file_line_stats_map_t ptx_file_line_stats_tracker;
 
+// the tracker is shared by all shader cores; when they are simulated by 
+// several host threads every update is done under this lock 
+static bool ptx_file_line_stats_multithreaded = false;
+static pthread_mutex_t ptx_file_line_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+class ptx_file_line_stats_lock
+{
+public:
+    ptx_file_line_stats_lock() 
+    {
+        if (ptx_file_line_stats_multithreaded) 
+            pthread_mutex_lock(&ptx_file_line_stats_mutex);
+    }
+    ~ptx_file_line_stats_lock()
+    {
+        if (ptx_file_line_stats_multithreaded) 
+            pthread_mutex_unlock(&ptx_file_line_stats_mutex);
+    }
+};
+
+void ptx_file_line_stats_set_multithreaded(bool multithreaded)
+{
+    ptx_file_line_stats_multithreaded = multithreaded;
+}
+
 // output statistics to a file
 void ptx_file_line_stats_write_file()
 {
@@ -149,13 +175,24 @@ void ptx_file_line_stats_write_file()
 // counting the number of threads (not warps) executing this instruction
 void ptx_file_line_stats_add_exec_count(const ptx_instruction *pInsn)
 {
+    ptx_file_line_stats_lock lock;
     ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())].exec_count += 1;
 }
 
+void ptx_file_line_stats_get_exec_counts(ptx_exec_count_map_t &counts)
+{
+    ptx_file_line_stats_lock lock;
+    counts.clear();
+    ptx_file_line_stats_map_t::const_iterator it;
+    for( it=ptx_file_line_stats_tracker.begin(); it != ptx_file_line_stats_tracker.end(); it++ ) 
+        counts[std::make_pair(it->first.st,it->first.line)] = it->second.exec_count;
+}
+
 // attribute pipeline latency to this ptx instruction (specified by the pc)
 // pipeline latency is the number of cycles a warp with this instruction spent in the pipeline
 void ptx_file_line_stats_add_latency(unsigned pc, unsigned latency)
 {
+    ptx_file_line_stats_lock lock;
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
     ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())].latency += latency;
@@ -165,6 +202,7 @@ void ptx_file_line_stats_add_latency(unsigned pc, unsigned latency)
 // dram traffic is counted in number of requests 
 void ptx_file_line_stats_add_dram_traffic(unsigned pc, unsigned dram_traffic)
 {
+    ptx_file_line_stats_lock lock;
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
     ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())].dram_traffic += dram_traffic;
@@ -174,6 +212,7 @@ void ptx_file_line_stats_add_dram_traffic(unsigned pc, unsigned dram_traffic)
 // counts both the number of warps doing shared memory access and the number of cycles involved
 void ptx_file_line_stats_add_smem_bank_conflict(unsigned pc, unsigned n_way_bkconflict)
 {
+    ptx_file_line_stats_lock lock;
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
     ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
@@ -185,6 +224,7 @@ void ptx_file_line_stats_add_smem_bank_conflict(unsigned pc, unsigned n_way_bkco
 // counts both the number of warps causing this and the number of memory requests generated
 void ptx_file_line_stats_add_uncoalesced_gmem(unsigned pc, unsigned n_access)
 {
+    ptx_file_line_stats_lock lock;
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
     ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
@@ -220,6 +260,7 @@ public:
 
     void attribute_exposed_latency(int count = 1)
     {
+        ptx_file_line_stats_lock lock;
         insn_count_map &exlat_insnmap = ptx_inflight_memory_insns;
         insn_count_map::const_iterator i_exlatinsn;
 
@@ -267,6 +308,7 @@ void ptx_file_line_stats_commit_exposed_latency(int sc_id, int exposed_latency)
 // attribute the number of warp divergence to a ptx instruction
 void ptx_file_line_stats_add_warp_divergence(unsigned pc, unsigned n_way_divergence)
 {
+    ptx_file_line_stats_lock lock;
     const ptx_instruction *pInsn = function_info::pc_to_instruction(pc);
     
     ptx_file_line_stats& line_stats = ptx_file_line_stats_tracker[ptx_file_line(pInsn->source_file(), pInsn->source_line())];
@@ -37,10 +37,22 @@ void ptx_file_line_stats_options(option_parser_t opp);
 // output stats to a file
 void ptx_file_line_stats_write_file();
 
+// serialize updates to the statistics (simulation threads, -gpgpu_sim_threads)
+void ptx_file_line_stats_set_multithreaded(bool multithreaded);
+
 #ifdef __cplusplus
+#include <map>
+#include <string>
+#include <utility>
+
 // stat collection interface to cuda-sim
 class ptx_instruction;
 void ptx_file_line_stats_add_exec_count(const ptx_instruction *pInsn);
+
+// snapshot of the thread execution count of every PTX source line 
+// (execution profile of an interval for sampled simulation)
+typedef std::map<std::pair<std::string,unsigned>,unsigned long> ptx_exec_count_map_t;
+void ptx_file_line_stats_get_exec_counts(ptx_exec_count_map_t &counts);
 #endif
 
 // stat collection interface to gpgpu-sim
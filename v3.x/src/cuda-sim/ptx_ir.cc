@@ -30,11 +30,13 @@
 #include "ptx_ir.h"
 #include "ptx.tab.h"
 #include "opcodes.h"
+#include "ptx_loader.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <list>
 #include <assert.h>
 #include <algorithm>
+#include <unistd.h>
 #include "assert.h"
 
 #include "cuda-sim.h"
@@ -153,6 +155,9 @@ symbol *symbol_table::add_variable( const char *identifier, const type_info *typ
    if ( type != NULL && type->get_key().is_const()  ) {
       m_consts.push_back(s);
    }
+   if ( type != NULL && type->get_key().is_reg() && !type->get_key().is_non_arch_reg() ) {
+      m_regs.push_back(s);
+   }
 
    return s;
 }
@@ -271,6 +276,21 @@ void symbol_table::dump()
 
 unsigned operand_info::sm_next_uid=1;
 
+void operand_info::resolve_fast_path()
+{
+   m_fast_kind = FAST_NONE;
+   if( m_vector || m_double_operand_type != 0 || m_operand_lohi != 0 || 
+       m_addr_space != undefined_space || m_operand_neg || m_immediate_address ) 
+      return;
+   if( is_literal() ) {
+      m_fast_literal = get_literal_value();
+      m_fast_kind = FAST_LITERAL;
+   } else if( is_reg() && m_value.m_symbolic->has_reg_slot() ) {
+      m_fast_reg_slot = m_value.m_symbolic->reg_slot();
+      m_fast_kind = FAST_REG;
+   }
+}
+
 unsigned operand_info::get_uid()
 {
    unsigned result = sm_next_uid++;
@@ -680,6 +700,91 @@ void function_info::find_ipostdominators( )
       // the exit node does not have an immediate post dominator, but everyone else should
 }
 
+// Format: magic number and format version, number of basic blocks, then for 
+// each block its immediate dominator, immediate postdominator (-1 if none), 
+// number of successors and the successor ids.  Bump CFG_CACHE_VERSION when 
+// the layout or the analysis producing it changes.
+#define CFG_CACHE_MAGIC 0x47464347 // "GCFG"
+#define CFG_CACHE_VERSION 2
+
+void function_info::save_cfg_cache( const std::string &path ) const
+{
+   if( path.empty() ) 
+      return;
+   char fname[1024];
+   snprintf(fname,1024,"_cfg_XXXXXX");
+   int fd=mkstemp(fname);
+   FILE *fp = (fd == -1) ? NULL : fdopen(fd,"wb");
+   if( fp == NULL ) 
+      return;
+   unsigned nbb = m_basic_blocks.size();
+   unsigned header[3] = { CFG_CACHE_MAGIC, CFG_CACHE_VERSION, nbb };
+   fwrite(header,sizeof(header),1,fp);
+   for( unsigned i=0; i < nbb; i++ ) {
+      const basic_block_t *bb = m_basic_blocks[i];
+      int v[3] = { bb->immediatedominator_id, bb->immediatepostdominator_id, (int)bb->successor_ids.size() };
+      fwrite(v,sizeof(v),1,fp);
+      for( std::set<int>::const_iterator s=bb->successor_ids.begin(); s != bb->successor_ids.end(); s++ ) 
+         fwrite(&*s,sizeof(int),1,fp);
+   }
+   if( fclose(fp) == 0 ) 
+      ptx_cache_store(path,fname);
+   unlink(fname);
+}
+
+// every block id read back must be a block of this function (or -1 for a 
+// missing immediate (post)dominator); a stale or corrupt entry is ignored
+bool function_info::load_cfg_cache( const std::string &path )
+{
+   if( !ptx_cache_hit(path) ) 
+      return false;
+   FILE *fp = fopen(path.c_str(),"rb");
+   if( fp == NULL ) 
+      return false;
+   unsigned header[3];
+   bool ok = fread(header,sizeof(header),1,fp) == 1 && header[0] == CFG_CACHE_MAGIC && 
+             header[1] == CFG_CACHE_VERSION && header[2] == m_basic_blocks.size();
+   int nbb = m_basic_blocks.size();
+   std::vector<int> idom, ipdom;
+   std::vector< std::set<int> > succ;
+   if( ok ) {
+      idom.resize(nbb);
+      ipdom.resize(nbb);
+      succ.resize(nbb);
+   }
+   for( int i=0; ok && i < nbb; i++ ) {
+      int v[3];
+      ok = fread(v,sizeof(v),1,fp) == 1 && v[0] >= -1 && v[0] < nbb && 
+           v[1] >= -1 && v[1] < nbb && v[2] >= 0 && v[2] <= nbb;
+      if( !ok ) 
+         break;
+      idom[i] = v[0];
+      ipdom[i] = v[1];
+      for( int n=0; ok && n < v[2]; n++ ) {
+         int s;
+         ok = fread(&s,sizeof(s),1,fp) == 1 && s >= 0 && s < nbb;
+         succ[i].insert(s);
+      }
+   }
+   fclose(fp);
+   if( !ok ) {
+      printf("GPGPU-Sim PTX: WARNING ** ignoring cached control flow \"%s\" for '%s'\n", path.c_str(), m_name.c_str() );
+      return false;
+   }
+   printf("GPGPU-Sim PTX: loaded dominators and postdominators for '%s' from \"%s\"\n", m_name.c_str(), path.c_str() );
+   for( int i=0; i < nbb; i++ ) 
+      m_basic_blocks[i]->predecessor_ids.clear();
+   for( int i=0; i < nbb; i++ ) {
+      basic_block_t *bb = m_basic_blocks[i];
+      bb->immediatedominator_id = idom[i];
+      bb->immediatepostdominator_id = ipdom[i];
+      bb->successor_ids = succ[i];
+      for( std::set<int>::iterator s=succ[i].begin(); s != succ[i].end(); s++ ) 
+         m_basic_blocks[*s]->predecessor_ids.insert(i);
+   }
+   return true;
+}
+
 void function_info::find_idominators( )
 {  
    // find immediate dominator blocks, using algorithm of
@@ -1037,6 +1142,9 @@ ptx_instruction::ptx_instruction( int opcode,
    m_vector_spec = 0;
    m_atomic_spec = 0;
    m_membar_level = 0;
+   m_warp_simd_op = WARP_SIMD_NONE;
+   m_exec_fn = NULL;
+   m_op_classification = 0;
    m_inst_size = 8; // bytes
 
    std::list<int>::const_iterator i;
@@ -1237,6 +1345,7 @@ function_info::function_info(int entry_point )
    num_reconvergence_pairs = 0;
    m_symtab = NULL;
    m_assembled = false;
+   m_num_reg_slots = 0;
    m_return_var_sym = NULL; 
    m_kernel_info.cmem = 0;
    m_kernel_info.lmem = 0;
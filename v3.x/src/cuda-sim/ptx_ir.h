@@ -169,6 +169,7 @@ public:
       m_function = NULL;
       m_reg_num=(unsigned)-1;
       m_arch_reg_num=(unsigned)-1;
+      m_reg_slot=(unsigned)-1;
       m_address=(unsigned)-1;
       m_initializer.clear();
       if ( type ) m_is_shared = type->get_key().is_shared();
@@ -262,6 +263,11 @@ public:
       assert( m_reg_num_valid );
       return m_arch_reg_num; 
    }
+   // index of this register in the dense per-thread register file frame of
+   // the function that declares it (assigned by function_info::ptx_assemble)
+   void set_reg_slot( unsigned slot ) { m_reg_slot = slot; }
+   bool has_reg_slot() const { return m_reg_slot != (unsigned)-1; }
+   unsigned reg_slot() const { return m_reg_slot; }
    void print_info(FILE *fp) const;
    unsigned uid() const { return m_uid; }
 
@@ -288,6 +294,7 @@ private:
    unsigned m_reg_num; 
    unsigned m_arch_reg_num; 
    bool m_reg_num_valid; 
+   unsigned m_reg_slot;
 
    std::list<operand_info> m_initializer;
    static unsigned sm_next_uid;
@@ -329,6 +336,9 @@ public:
    iterator const_iterator_begin() { return m_consts.begin();}
    iterator const_iterator_end() { return m_consts.end();}
 
+   iterator reg_iterator_begin() { return m_regs.begin();}
+   iterator reg_iterator_end() { return m_regs.end();}
+
    void dump();
 private:
    unsigned m_reg_allocator;
@@ -345,6 +355,7 @@ private:
    std::map<type_info_key,type_info*,type_info_key_compare>  m_types;
    std::list<symbol*> m_globals;
    std::list<symbol*> m_consts;
+   std::list<symbol*> m_regs; // architected registers, in declaration order
    std::map<std::string,function_info*> m_function_info_lookup;
    std::map<std::string,symbol_table*> m_function_symtab_lookup;
 };
@@ -569,6 +580,8 @@ public:
    }
    void init()
    {
+       m_fast_kind=FAST_NONE;
+       m_fast_reg_slot=(unsigned)-1;
        m_uid=(unsigned)-1;
        m_valid=false;
        m_vector=false;
@@ -761,7 +774,19 @@ public:
    addr_t get_const_mem_offset() const { return m_const_mem_offset; }
    bool is_non_arch_reg() const { return m_is_non_arch_reg; }
 
+   // plain register and literal operands are resolved once by pre_decode so 
+   // get_operand_value/set_operand_value can skip the operand form checks
+   enum fast_kind_t { FAST_NONE=0, FAST_REG, FAST_LITERAL };
+   void resolve_fast_path();
+   enum fast_kind_t fast_kind() const { return m_fast_kind; }
+   unsigned fast_reg_slot() const { return m_fast_reg_slot; }
+   const ptx_reg_t &fast_literal() const { return m_fast_literal; }
+
 private:
+   enum fast_kind_t m_fast_kind;
+   unsigned m_fast_reg_slot;
+   ptx_reg_t m_fast_literal; 
+
    unsigned m_uid;
    bool m_valid;
    bool m_vector;
@@ -840,6 +865,40 @@ struct gpgpu_recon_t {
    class ptx_instruction* target_inst;
 };
 
+// per-thread handler of an opcode, bound to each instruction by pre_decode
+typedef void (*ptx_exec_fn_t)( const class ptx_instruction *pI, class ptx_thread_info *thread );
+
+// Operations that can be executed once for all active threads of a warp (see
+// ptx_exec_warp_inst); everything else runs through ptx_exec_inst per thread
+enum warp_simd_op_t {
+   WARP_SIMD_NONE = 0,
+   WARP_SIMD_MOV,
+   WARP_SIMD_ADD32,
+   WARP_SIMD_ADD64,
+   WARP_SIMD_SUB32,
+   WARP_SIMD_SUB64,
+   WARP_SIMD_AND,
+   WARP_SIMD_OR,
+   WARP_SIMD_XOR,
+   WARP_SIMD_SHL32,
+   WARP_SIMD_SHR32,
+   WARP_SIMD_SRA32,
+   WARP_SIMD_MUL_LO32,
+   WARP_SIMD_MUL_WIDE_U32,
+   WARP_SIMD_MUL_WIDE_S32,
+   WARP_SIMD_ADD_F32,
+   WARP_SIMD_SUB_F32,
+   WARP_SIMD_MUL_F32,
+   WARP_SIMD_SETP_S32,
+   WARP_SIMD_SETP_U32,
+   WARP_SIMD_SETP_S64,
+   WARP_SIMD_SETP_U64,
+   WARP_SIMD_SETP_F32,
+   WARP_SIMD_SELP,
+   WARP_SIMD_CVT_CHOP32,
+   WARP_SIMD_CVT_SEXT32
+};
+
 class ptx_instruction : public warp_inst_t {
 public:
     ptx_instruction( int opcode, 
@@ -994,6 +1053,9 @@ public:
    unsigned dimension() const { return m_geom_spec;}
    enum vote_mode_t { vote_any, vote_all, vote_uni, vote_ballot };
    enum vote_mode_t vote_mode() const { return m_vote_mode; }
+   enum warp_simd_op_t warp_simd_op() const { return m_warp_simd_op; }
+   ptx_exec_fn_t exec_fn() const { return m_exec_fn; }
+   int op_classification() const { return m_op_classification; }
 
    int membar_level() const { return m_membar_level; }
 
@@ -1025,6 +1087,7 @@ private:
    void set_opcode_and_latency();
    void set_fp_or_int_archop();
    void set_mul_div_or_other_archop();
+   void set_warp_simd_op();
 
    basic_block_t        *m_basic_block;
    unsigned          m_uid;
@@ -1061,6 +1124,9 @@ private:
    int m_vector_spec;
    int m_atomic_spec;
    enum vote_mode_t m_vote_mode;
+   enum warp_simd_op_t m_warp_simd_op;
+   ptx_exec_fn_t m_exec_fn; // bound by pre_decode
+   int m_op_classification;
    int m_membar_level;
    int m_instr_mem_index; //index into m_instr_mem array
    unsigned m_inst_size; // bytes
@@ -1163,6 +1229,12 @@ public:
    void find_ipostdominators( );
    void print_ipostdominators();
 
+   // the results of the analyses above that are used after assembly (immediate 
+   // dominators and postdominators, successors once break targets are 
+   // resolved), kept in -gpgpu_ptx_cache_dir between runs
+   bool load_cfg_cache( const std::string &path );
+   void save_cfg_cache( const std::string &path ) const;
+
 
    unsigned get_num_reconvergence_pairs();
 
@@ -1171,6 +1243,8 @@ public:
    unsigned get_function_size() { return m_instructions.size();}
 
    void ptx_assemble();
+   void alloc_reg_slots();
+   unsigned num_reg_slots() const { return m_num_reg_slots; }
  
    unsigned ptx_get_inst_op( ptx_thread_info *thread );
    void add_param( const char *name, struct param_t value )
@@ -1267,6 +1341,7 @@ private:
    ptx_instruction **m_instr_mem;
    unsigned m_start_PC;
    unsigned m_instr_mem_size;
+   unsigned m_num_reg_slots; // size of this function's register file frame
    std::map<std::string,param_t> m_kernel_params;
    std::map<unsigned,param_info> m_ptx_kernel_param_info;
    const symbol *m_return_var_sym;
@@ -31,6 +31,7 @@
 #include "ptx_parser.h"
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/stat.h>
 #include <fstream>
 
 /// globals
@@ -54,6 +55,8 @@ extern FILE *ptxinfo_in;
 static bool g_save_embedded_ptx;
 bool g_keep_intermediate_files;
 bool m_ptx_save_converted_ptxplus;
+static char *g_ptx_cache_dir;
+static std::string g_ptx_cache_module; // cache path of the PTX being parsed
 
 bool keep_intermediate_files() {return g_keep_intermediate_files;}
 
@@ -69,6 +72,102 @@ void ptx_reg_options(option_parser_t opp)
                 &m_ptx_save_converted_ptxplus,
                 "Saved converted ptxplus to a file",
                 "0");
+   option_parser_register(opp, "-gpgpu_ptx_cache_dir", OPT_CSTR, &g_ptx_cache_dir,
+                "directory keeping the output of cuobjdump and ptxas between runs, keyed by the content of their input (default = not kept)",
+                NULL);
+}
+
+// 64-bit FNV-1a
+static unsigned long long ptx_cache_hash( unsigned long long h, const void *data, size_t size )
+{
+   const unsigned char *p = (const unsigned char*)data;
+   for( size_t i=0; i < size; i++ ) {
+      h ^= p[i];
+      h *= 0x100000001b3ULL;
+   }
+   return h;
+}
+
+static std::string ptx_cache_name( const char *kind, unsigned long long h, unsigned long long size, const char *salt )
+{
+   if( salt ) 
+      h = ptx_cache_hash(h,salt,strlen(salt));
+   char buf[1024];
+   snprintf(buf,1024,"%s/%s_%016llx_%llu",g_ptx_cache_dir,kind,h,size);
+   return buf;
+}
+
+std::string ptx_cache_path( const char *kind, const char *data, size_t size, const char *salt )
+{
+   if( g_ptx_cache_dir == NULL || g_ptx_cache_dir[0] == 0 ) 
+      return "";
+   return ptx_cache_name(kind,ptx_cache_hash(0xcbf29ce484222325ULL,data,size),size,salt);
+}
+
+std::string ptx_cache_path_for_file( const char *kind, const char *filename, const char *salt )
+{
+   if( g_ptx_cache_dir == NULL || g_ptx_cache_dir[0] == 0 ) 
+      return "";
+   FILE *fp = fopen(filename,"rb");
+   if( fp == NULL ) 
+      return "";
+   unsigned long long h = 0xcbf29ce484222325ULL;
+   unsigned long long size = 0;
+   char buf[65536];
+   size_t n;
+   while( (n = fread(buf,1,sizeof(buf),fp)) > 0 ) {
+      h = ptx_cache_hash(h,buf,n);
+      size += n;
+   }
+   fclose(fp);
+   return ptx_cache_name(kind,h,size,salt);
+}
+
+std::string ptx_cache_path_in_module( const char *kind, const std::string &name )
+{
+   if( g_ptx_cache_module.empty() ) 
+      return "";
+   return ptx_cache_path(kind,name.c_str(),name.size(),g_ptx_cache_module.c_str());
+}
+
+bool ptx_cache_hit( const std::string &path )
+{
+   return !path.empty() && access(path.c_str(),R_OK) == 0;
+}
+
+// Copies filename into the cache.  The entry only appears under its final name 
+// once complete, so simulations sharing the directory never read a partial one.
+void ptx_cache_store( const std::string &path, const char *filename )
+{
+   if( path.empty() ) 
+      return;
+   mkdir(g_ptx_cache_dir,0777);
+   std::string tmpname = path + ".XXXXXX";
+   std::vector<char> tmp(tmpname.begin(),tmpname.end());
+   tmp.push_back(0);
+   int fd = mkstemp(&tmp[0]);
+   FILE *in = fopen(filename,"rb");
+   FILE *out = (fd == -1) ? NULL : fdopen(fd,"wb");
+   bool ok = in && out;
+   char buf[65536];
+   size_t n;
+   while( ok && (n = fread(buf,1,sizeof(buf),in)) > 0 ) 
+      ok = fwrite(buf,1,n,out) == n;
+   if( in ) 
+      fclose(in);
+   if( out ) 
+      ok = (fclose(out) == 0) && ok;
+   else if( fd != -1 ) 
+      close(fd);
+   if( ok ) 
+      ok = rename(&tmp[0],path.c_str()) == 0;
+   if( !ok ) {
+      printf("GPGPU-Sim PTX: WARNING ** could not add \"%s\" to the cache as \"%s\"\n", filename, path.c_str());
+      if( fd != -1 ) 
+         unlink(&tmp[0]);
+   } else {
+      printf("GPGPU-Sim PTX: cached \"%s\" as \"%s\"\n", filename, path.c_str());
+   }
 }
 
 void print_ptx_file( const char *p, unsigned source_num, const char *filename )
@@ -160,8 +259,10 @@ symbol_table *gpgpu_ptx_sim_load_ptx_from_string( const char *p, unsigned source
        fclose(fp);
     }
     symbol_table *symtab=init_parser(buf);
+    g_ptx_cache_module = ptx_cache_path("ptx",p,strlen(p),NULL);
     ptx__scan_string(p);
     int errors = ptx_parse ();
+    g_ptx_cache_module.clear();
     if ( errors ) {
         char fname[1024];
         snprintf(fname,1024,"_ptx_errors_XXXXXX");
@@ -184,6 +285,27 @@ symbol_table *gpgpu_ptx_sim_load_ptx_from_string( const char *p, unsigned source
 
 void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num )
 {
+    char extra_flags[1024];
+    extra_flags[0]=0;
+
+#if CUDART_VERSION >= 3000
+    snprintf(extra_flags,1024,"--gpu-name=sm_20");
+#endif
+
+    // ptxas output depends on the toolkit and the flags as well as on the PTX
+    char salt[2048];
+    const char *cuda_path = getenv("CUDA_INSTALL_PATH");
+    snprintf(salt,2048,"%s %s",cuda_path?cuda_path:"",extra_flags);
+    std::string cached = ptx_cache_path("ptxinfo",p_for_info,strlen(p_for_info),salt);
+    if( ptx_cache_hit(cached) ) {
+        printf("GPGPU-Sim PTX: loading ptxinfo from cache \"%s\"\n", cached.c_str());
+        ptxinfo_in = fopen(cached.c_str(),"r");
+        g_ptxinfo_filename = cached.c_str();
+        ptxinfo_parse();
+        fclose(ptxinfo_in);
+        return;
+    }
+
     char fname[1024];
     snprintf(fname,1024,"_ptx_XXXXXX");
     int fd=mkstemp(fname); 
@@ -212,13 +334,6 @@ void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num
     char tempfile_ptxinfo[1024];
     snprintf(tempfile_ptxinfo,1024,"%sinfo",fname);
     char commandline[1024];
-    char extra_flags[1024];
-    extra_flags[0]=0;
-
-#if CUDART_VERSION >= 3000
-    snprintf(extra_flags,1024,"--gpu-name=sm_20");
-#endif
-
     snprintf(commandline,1024,"$CUDA_INSTALL_PATH/bin/ptxas %s -v %s --output-file  /dev/null 2> %s",
              extra_flags, fname2, tempfile_ptxinfo);
     printf("GPGPU-Sim PTX: generating ptxinfo using \"%s\"\n", commandline);
@@ -228,6 +343,7 @@ void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num
        printf("               Ensure ptxas is in your path.\n");
        exit(1);
     }
+    ptx_cache_store(cached,tempfile_ptxinfo);
 
     ptxinfo_in = fopen(tempfile_ptxinfo,"r");
     g_ptxinfo_filename = tempfile_ptxinfo;
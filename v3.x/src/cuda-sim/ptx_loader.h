@@ -36,4 +36,14 @@ void gpgpu_ptxinfo_load_from_string( const char *p_for_info, unsigned source_num
 char* gpgpu_ptx_sim_convert_ptx_and_sass_to_ptxplus(const std::string ptx_str, const std::string sass_str, const std::string elf_str);
 bool keep_intermediate_files();
 
+// Persistent cache of the output of external programs (-gpgpu_ptx_cache_dir), 
+// keyed by a hash of their input and of 'salt' (toolkit path, flags).  The 
+// path functions return "" when caching is disabled or the input is unreadable.
+std::string ptx_cache_path( const char *kind, const char *data, size_t size, const char *salt );
+std::string ptx_cache_path_for_file( const char *kind, const char *filename, const char *salt );
+bool ptx_cache_hit( const std::string &path );
+void ptx_cache_store( const std::string &path, const char *filename );
+// entry for 'name' in the PTX module being parsed ("" outside of parsing)
+std::string ptx_cache_path_in_module( const char *kind, const std::string &name );
+
 #endif
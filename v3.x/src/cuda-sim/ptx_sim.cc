@@ -162,7 +162,7 @@ ptx_thread_info::ptx_thread_info( kernel_info_t &kernel )
    m_hw_sid = -1;
    m_last_dram_callback.function = NULL;
    m_last_dram_callback.instruction = NULL;
-   m_regs.push_back( reg_map_t() );
+   m_reg_frame_base = 0;
    m_debug_trace_regs_modified.push_back( reg_map_t() );
    m_debug_trace_regs_read.push_back( reg_map_t() );
    m_callstack.push_back( stack_entry() );
@@ -354,8 +354,11 @@ void ptx_thread_info::callstack_push( unsigned pc, unsigned rpc, const symbol *r
    m_RPC_updated = true;
    m_last_was_call = true;
    assert( m_func_info != NULL );
-   m_callstack.push_back( stack_entry(m_symbol_table,m_func_info,pc,rpc,return_var_src,return_var_dst,call_uid) );
-   m_regs.push_back( reg_map_t() );
+   // callee frame starts right after the caller's registers
+   m_reg_frame_base += m_func_info->num_reg_slots();
+   m_callstack.push_back( stack_entry(m_symbol_table,m_func_info,pc,rpc,return_var_src,return_var_dst,call_uid,m_reg_frame_base) );
+   m_regs.resize( m_reg_frame_base );
+   m_regs_valid.resize( m_reg_frame_base );
    m_debug_trace_regs_modified.push_back( reg_map_t() );
    m_debug_trace_regs_read.push_back( reg_map_t() );
    m_local_mem_stack_pointer += m_func_info->local_mem_framesize(); 
@@ -368,7 +371,8 @@ void ptx_thread_info::callstack_push_plus( unsigned pc, unsigned rpc, const symb
    m_RPC_updated = true;
    m_last_was_call = true;
    assert( m_func_info != NULL );
-   m_callstack.push_back( stack_entry(m_symbol_table,m_func_info,pc,rpc,return_var_src,return_var_dst,call_uid) );
+   // callee is a label in the same function and shares the caller's registers
+   m_callstack.push_back( stack_entry(m_symbol_table,m_func_info,pc,rpc,return_var_src,return_var_dst,call_uid,m_reg_frame_base) );
    //m_regs.push_back( reg_map_t() );
    //m_debug_trace_regs_modified.push_back( reg_map_t() );
    //m_debug_trace_regs_read.push_back( reg_map_t() );
@@ -398,7 +402,8 @@ bool ptx_thread_info::callstack_pop()
       m_local_mem_stack_pointer -= m_func_info->local_mem_framesize(); 
    }
    m_callstack.pop_back();
-   m_regs.pop_back();
+   if( !m_callstack.empty() )
+      m_reg_frame_base = m_callstack.back().m_reg_frame_base;
    m_debug_trace_regs_modified.pop_back();
    m_debug_trace_regs_read.pop_back();
 
@@ -446,27 +451,26 @@ bool ptx_thread_info::callstack_pop_plus()
 void ptx_thread_info::dump_callstack() const
 {
    std::list<stack_entry>::const_iterator c=m_callstack.begin();
-   std::list<reg_map_t>::const_iterator r=m_regs.begin();
 
    printf("\n\n");
    printf("Call stack for thread uid = %u (sc=%u, hwtid=%u)\n", m_uid, m_hw_sid, m_hw_tid );
-   while( c != m_callstack.end() && r != m_regs.end() ) {
+   while( c != m_callstack.end() ) {
       const stack_entry &c_e = *c;
-      const reg_map_t &regs = *r;
+      unsigned frame_base = c_e.m_reg_frame_base;
+      c++;
+      unsigned frame_end = (c != m_callstack.end())? c->m_reg_frame_base : m_regs.size();
+      size_t nregs = 0;
+      for( unsigned r=frame_base; r < frame_end && r < m_regs_valid.size(); r++ ) 
+         nregs += m_regs_valid[r];
       if( !c_e.m_valid ) {
-         printf("  <entry>                              #regs = %zu\n", regs.size() );
+         printf("  <entry>                              #regs = %zu\n", nregs );
       } else {
          printf("  %20s  PC=%3u RV= (callee=\'%s\',caller=\'%s\') #regs = %zu\n", 
                 c_e.m_func_info->get_name().c_str(), c_e.m_PC, 
                 c_e.m_return_var_src->name().c_str(), 
                 c_e.m_return_var_dst->name().c_str(), 
-                regs.size() );
+                nregs );
       }
-      c++;
-      r++;
-   }
-   if( c != m_callstack.end() || r != m_regs.end() ) {
-      printf("  *** mismatch in m_regs and m_callstack sizes ***\n" );
    }
    printf("\n\n");
 }
@@ -491,14 +495,16 @@ const ptx_instruction *ptx_thread_info::get_inst( addr_t pc ) const
 
 void ptx_thread_info::dump_regs( FILE *fp )
 {
-   if(m_regs.empty()) return;
-   if(m_regs.back().empty()) return;
+   if(m_regs.size() <= m_reg_frame_base) return;
    fprintf(fp,"Register File Contents:\n");
    fflush(fp);
-   reg_map_t::const_iterator r;
-   for ( r=m_regs.back().begin(); r != m_regs.back().end(); ++r ) {
-      const symbol *sym = r->first;
-      ptx_reg_t value = r->second;
+   symbol_table::iterator r;
+   for ( r=m_symbol_table->reg_iterator_begin(); r != m_symbol_table->reg_iterator_end(); ++r ) {
+      const symbol *sym = *r;
+      unsigned idx = m_reg_frame_base + sym->reg_slot();
+      if( idx >= m_regs.size() || !m_regs_valid[idx] ) 
+         continue;
+      ptx_reg_t value = m_regs[idx];
       std::string name = sym->name();
       print_reg(fp,name,value,m_symbol_table);
    }
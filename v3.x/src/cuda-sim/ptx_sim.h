@@ -39,6 +39,7 @@
 #include <map>
 #include <set>
 #include <list>
+#include <vector>
 
 #include "memory.h"
 
@@ -178,9 +179,10 @@ struct stack_entry {
       m_return_var_src = NULL;
       m_return_var_dst = NULL;
       m_call_uid = 0;
+      m_reg_frame_base = 0;
       m_valid = false;
    }
-   stack_entry( symbol_table *s, function_info *f, unsigned pc, unsigned rpc, const symbol *return_var_src, const symbol *return_var_dst, unsigned call_uid )
+   stack_entry( symbol_table *s, function_info *f, unsigned pc, unsigned rpc, const symbol *return_var_src, const symbol *return_var_dst, unsigned call_uid, unsigned reg_frame_base )
    {
       m_symbol_table=s;
       m_func_info=f;
@@ -189,6 +191,7 @@ struct stack_entry {
       m_return_var_src = return_var_src;
       m_return_var_dst = return_var_dst;
       m_call_uid = call_uid;
+      m_reg_frame_base = reg_frame_base;
       m_valid = true;
    }
 
@@ -200,6 +203,7 @@ struct stack_entry {
    const symbol  *m_return_var_src;
    const symbol  *m_return_var_dst;
    unsigned       m_call_uid;
+   unsigned       m_reg_frame_base; // offset of this frame in the thread's register file
 };
 
 class ptx_version {
@@ -275,6 +279,8 @@ public:
 
    void ptx_fetch_inst( inst_t &inst ) const;
    void ptx_exec_inst( warp_inst_t &inst, unsigned lane_id );
+   bool pred_skip( const ptx_instruction *pI );
+   void retire_inst( const ptx_instruction *pI, int op_classification );
 
    const ptx_version &get_ptx_version() const;
    void set_reg( const symbol *reg, const ptx_reg_t &value );
@@ -425,6 +431,7 @@ public:
    ptx_reg_t m_last_set_operand_value;
 
 private:
+   ptx_reg_t &reg_ref( const symbol *reg );
 
    bool m_functionalSimulationMode; 
    unsigned m_uid;
@@ -460,8 +467,13 @@ private:
    std::list<stack_entry> m_callstack;
    unsigned m_local_mem_stack_pointer;
 
+   // register file: each call frame occupies a contiguous range of slots 
+   // starting at m_reg_frame_base (see function_info::alloc_reg_slots)
+   std::vector<ptx_reg_t> m_regs;
+   std::vector<unsigned char> m_regs_valid;
+   unsigned m_reg_frame_base;
+
    typedef tr1_hash_map<const symbol*,ptx_reg_t> reg_map_t;
-   std::list<reg_map_t> m_regs;
    std::list<reg_map_t> m_debug_trace_regs_modified;
    std::list<reg_map_t> m_debug_trace_regs_read;
    bool m_enable_debug_trace;
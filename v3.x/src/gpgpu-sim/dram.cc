@@ -33,6 +33,7 @@
 #include "dram_sched.h"
 #include "mem_fetch.h"
 #include "l2cache.h"
+#include "../checkpoint.h"
 
 #ifdef DRAM_VERIFY
 int PRINT_CYCLE = 0;
@@ -115,6 +116,12 @@ dram_t::dram_t( unsigned int partition_id, const struct memory_config *config, m
       mrqq_Dist = StatCreate("mrqq_length",1,64); //track up to 64 entries
 }
 
+dram_t::~dram_t()
+{
+   for( unsigned i=0; i < m_free_reqs.size(); i++ ) 
+      delete m_free_reqs[i];
+}
+
 bool dram_t::full() const 
 {
     if(m_config->scheduler_type == DRAM_FRFCFS ){
@@ -163,13 +170,23 @@ dram_req_t::dram_req_t( class mem_fetch *mf )
    addr = mf->get_addr();
    insertion_time = (unsigned) gpu_sim_cycle;
    rw = data->get_is_write()?WRITE:READ;
+   sched_older = NULL;
+   sched_newer = NULL;
+   row_newer = NULL;
 }
 
 void dram_t::push( class mem_fetch *data ) 
 {
    assert(id == data->get_tlx_addr().chip); // Ensure request is in correct memory partition
 
-   dram_req_t *mrq = new dram_req_t(data);
+   dram_req_t *mrq;
+   if ( m_free_reqs.empty() ) {
+      mrq = new dram_req_t(data);
+   } else {
+      mrq = m_free_reqs.back();
+      m_free_reqs.pop_back();
+      *mrq = dram_req_t(data);
+   }
    data->set_status(IN_PARTITION_MC_INTERFACE_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
    mrqq->push(mrq);
 
@@ -222,7 +239,7 @@ void dram_t::cycle()
                  m_memory_partition_unit->set_done(data);
                  delete data;
               }
-              delete cmd;
+              m_free_reqs.push_back(cmd);
            }
 #ifdef DRAM_VIEWCMD 
            printf("\n");
@@ -431,6 +448,64 @@ class mem_fetch* dram_t::return_queue_top()
     return returnq->top();
 }
 
+void dram_t::checkpoint( FILE *fp ) const
+{
+   checkpoint_write_section(fp,"DRAM",m_config->nbk);
+   checkpoint_write(fp,prio);
+   checkpoint_write(fp,RRDc);
+   checkpoint_write(fp,CCDc);
+   checkpoint_write(fp,RTWc);
+   checkpoint_write(fp,WTRc);
+   checkpoint_write(fp,rw);
+   for (unsigned i=0;i<m_config->nbkgrp;i++) {
+      checkpoint_write(fp,bkgrp[i]->CCDLc);
+      checkpoint_write(fp,bkgrp[i]->RTPLc);
+   }
+   for (unsigned i=0;i<m_config->nbk;i++) {
+      const bank_t *b = bk[i];
+      assert( b->mrq == NULL );
+      checkpoint_write(fp,b->RCDc);
+      checkpoint_write(fp,b->RCDWRc);
+      checkpoint_write(fp,b->RASc);
+      checkpoint_write(fp,b->RPc);
+      checkpoint_write(fp,b->RCc);
+      checkpoint_write(fp,b->WTPc);
+      checkpoint_write(fp,b->RTPc);
+      checkpoint_write(fp,b->rw);
+      checkpoint_write(fp,b->state);
+      checkpoint_write(fp,b->curr_row);
+   }
+}
+
+void dram_t::restore( FILE *fp )
+{
+   checkpoint_read_section(fp,"DRAM",m_config->nbk);
+   checkpoint_read(fp,prio);
+   checkpoint_read(fp,RRDc);
+   checkpoint_read(fp,CCDc);
+   checkpoint_read(fp,RTWc);
+   checkpoint_read(fp,WTRc);
+   checkpoint_read(fp,rw);
+   for (unsigned i=0;i<m_config->nbkgrp;i++) {
+      checkpoint_read(fp,bkgrp[i]->CCDLc);
+      checkpoint_read(fp,bkgrp[i]->RTPLc);
+   }
+   for (unsigned i=0;i<m_config->nbk;i++) {
+      bank_t *b = bk[i];
+      assert( b->mrq == NULL );
+      checkpoint_read(fp,b->RCDc);
+      checkpoint_read(fp,b->RCDWRc);
+      checkpoint_read(fp,b->RASc);
+      checkpoint_read(fp,b->RPc);
+      checkpoint_read(fp,b->RCc);
+      checkpoint_read(fp,b->WTPc);
+      checkpoint_read(fp,b->RTPc);
+      checkpoint_read(fp,b->rw);
+      checkpoint_read(fp,b->state);
+      checkpoint_read(fp,b->curr_row);
+   }
+}
+
 void dram_t::print( FILE* simFile) const
 {
    unsigned i;
@@ -31,6 +31,7 @@
 
 #include "delayqueue.h"
 #include <set>
+#include <vector>
 #include <zlib.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -56,6 +57,11 @@ public:
    unsigned long long int addr;
    unsigned int insertion_time;
    class mem_fetch * data;
+
+   // queues of the frfcfs_scheduler
+   dram_req_t *sched_older;
+   dram_req_t *sched_newer;
+   dram_req_t *row_newer;
 };
 
 struct bankgrp_t
@@ -94,6 +100,7 @@ class dram_t
 public:
    dram_t( unsigned int parition_id, const struct memory_config *config, class memory_stats_t *stats, 
            class memory_partition_unit *mp );
+   ~dram_t();
 
    bool full() const;
    void print( FILE* simFile ) const;
@@ -110,6 +117,10 @@ public:
    void cycle();
    void dram_log (int task);
 
+   // bank and bus timing state at a kernel boundary (no request in flight)
+   void checkpoint( FILE *fp ) const;
+   void restore( FILE *fp );
+
    class memory_partition_unit *m_memory_partition_unit;
    unsigned int id;
 
@@ -145,6 +156,7 @@ private:
 
    fifo_pipeline<dram_req_t> *rwq;
    fifo_pipeline<dram_req_t> *mrqq;
+   std::vector<dram_req_t*> m_free_reqs; // completed requests, reused by push()
    //buffer to hold packets when DRAM processing is over
    //should be filled with dram clock and popped with l2or icnt clock 
    fifo_pipeline<mem_fetch> *returnq;
@@ -37,27 +37,110 @@ frfcfs_scheduler::frfcfs_scheduler( const memory_config *config, dram_t *dm, mem
    m_stats = stats;
    m_num_pending = 0;
    m_dram = dm;
-   m_queue = new std::list<dram_req_t*>[m_config->nbk];
-   m_bins = new std::map<unsigned,std::list<std::list<dram_req_t*>::iterator> >[ m_config->nbk ];
-   m_last_row = new std::list<std::list<dram_req_t*>::iterator>*[ m_config->nbk ];
+   m_queue = new bank_queue[m_config->nbk];
    curr_row_service_time = new unsigned[m_config->nbk];
    row_service_timestamp = new unsigned[m_config->nbk];
+   row_bin empty;
+   empty.row = 0;
+   empty.valid = false;
+   empty.oldest = NULL;
+   empty.newest = NULL;
    for ( unsigned i=0; i < m_config->nbk; i++ ) {
-      m_queue[i].clear();
-      m_bins[i].clear();
-      m_last_row[i] = NULL;
+      m_queue[i].oldest = NULL;
+      m_queue[i].newest = NULL;
+      m_queue[i].size = 0;
+      m_queue[i].bins.assign(16,empty);
+      m_queue[i].n_bins = 0;
+      m_queue[i].serving = false;
+      m_queue[i].serving_row = 0;
       curr_row_service_time[i] = 0;
       row_service_timestamp[i] = 0;
    }
 
 }
 
+static inline unsigned row_hash( unsigned row, unsigned n_slots )
+{
+   return (row * 2654435761u) & (n_slots-1);
+}
+
+// slot of the requests to row, (unsigned)-1 if there are none
+unsigned frfcfs_scheduler::find_bin( const bank_queue &q, unsigned row ) const
+{
+   unsigned mask = q.bins.size()-1;
+   for ( unsigned s = row_hash(row,q.bins.size()); q.bins[s].valid; s = (s+1) & mask ) {
+      if ( q.bins[s].row == row ) 
+         return s;
+   }
+   return (unsigned)-1;
+}
+
+unsigned frfcfs_scheduler::add_bin( bank_queue &q, unsigned row )
+{
+   if ( 2*(q.n_bins+1) > q.bins.size() ) {
+      // more distinct rows pending than ever before in this bank: rehash
+      std::vector<row_bin> old = q.bins;
+      row_bin empty = old[0];
+      empty.valid = false;
+      q.bins.assign(2*old.size(),empty);
+      q.n_bins = 0;
+      for ( unsigned i=0; i < old.size(); i++ ) {
+         if ( old[i].valid ) 
+            q.bins[add_bin(q,old[i].row)] = old[i];
+      }
+   }
+   unsigned mask = q.bins.size()-1;
+   unsigned s = row_hash(row,q.bins.size());
+   while ( q.bins[s].valid ) 
+      s = (s+1) & mask;
+   q.bins[s].row = row;
+   q.bins[s].valid = true;
+   q.bins[s].oldest = NULL;
+   q.bins[s].newest = NULL;
+   q.n_bins++;
+   return s;
+}
+
+// backward shift deletion: entries that probed past slot move into it
+void frfcfs_scheduler::remove_bin( bank_queue &q, unsigned slot )
+{
+   unsigned mask = q.bins.size()-1;
+   q.bins[slot].valid = false;
+   q.n_bins--;
+   for ( unsigned next = (slot+1) & mask; q.bins[next].valid; next = (next+1) & mask ) {
+      unsigned home = row_hash(q.bins[next].row,q.bins.size());
+      bool stays = (slot <= next)? (slot < home && home <= next) : (slot < home || home <= next);
+      if ( stays ) 
+         continue;
+      q.bins[slot] = q.bins[next];
+      q.bins[next].valid = false;
+      slot = next;
+   }
+}
+
 void frfcfs_scheduler::add_req( dram_req_t *req )
 {
    m_num_pending++;
-   m_queue[req->bk].push_front(req);
-   std::list<dram_req_t*>::iterator ptr = m_queue[req->bk].begin();
-   m_bins[req->bk][req->row].push_front( ptr ); //newest reqs to the front
+   bank_queue &q = m_queue[req->bk];
+   req->sched_older = q.newest;
+   req->sched_newer = NULL;
+   if ( q.newest ) 
+      q.newest->sched_newer = req;
+   else 
+      q.oldest = req;
+   q.newest = req;
+   q.size++;
+
+   unsigned s = find_bin(q,req->row);
+   if ( s == (unsigned)-1 ) 
+      s = add_bin(q,req->row);
+   row_bin &bin = q.bins[s];
+   req->row_newer = NULL;
+   if ( bin.newest ) 
+      bin.newest->row_newer = req;
+   else 
+      bin.oldest = req;
+   bin.newest = req;
 }
 
 void frfcfs_scheduler::data_collection(unsigned int bank)
@@ -78,33 +161,42 @@ void frfcfs_scheduler::data_collection(unsigned int bank)
 
 dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 {
-   if ( m_last_row[bank] == NULL ) {
-      if ( m_queue[bank].empty() )
+   bank_queue &q = m_queue[bank];
+   unsigned s;
+   if ( !q.serving ) {
+      if ( q.oldest == NULL )
          return NULL;
 
-      std::map<unsigned,std::list<std::list<dram_req_t*>::iterator> >::iterator bin_ptr = m_bins[bank].find( curr_row );
-      if ( bin_ptr == m_bins[bank].end()) {
-         dram_req_t *req = m_queue[bank].back();
-         bin_ptr = m_bins[bank].find( req->row );
-         assert( bin_ptr != m_bins[bank].end() ); // where did the request go???
-         m_last_row[bank] = &(bin_ptr->second);
+      s = find_bin(q,curr_row);
+      if ( s == (unsigned)-1 ) {
+         s = find_bin(q,q.oldest->row);
+         assert( s != (unsigned)-1 ); // where did the request go???
          data_collection(bank);
-      } else {
-         m_last_row[bank] = &(bin_ptr->second);
-
-      }
+      } 
+      q.serving = true;
+      q.serving_row = q.bins[s].row;
+   } else {
+      s = find_bin(q,q.serving_row);
    }
-   std::list<dram_req_t*>::iterator next = m_last_row[bank]->back();
-   dram_req_t *req = (*next);
+   row_bin &bin = q.bins[s];
+   dram_req_t *req = bin.oldest;
 
    m_stats->concurrent_row_access[m_dram->id][bank]++;
    m_stats->row_access[m_dram->id][bank]++;
-   m_last_row[bank]->pop_back();
+   bin.oldest = req->row_newer;
 
-   m_queue[bank].erase(next);
-   if ( m_last_row[bank]->empty() ) {
-      m_bins[bank].erase( req->row );
-      m_last_row[bank] = NULL;
+   if ( req->sched_older ) 
+      req->sched_older->sched_newer = req->sched_newer;
+   else 
+      q.oldest = req->sched_newer;
+   if ( req->sched_newer ) 
+      req->sched_newer->sched_older = req->sched_older;
+   else 
+      q.newest = req->sched_older;
+   q.size--;
+   if ( bin.oldest == NULL ) {
+      remove_bin(q,s);
+      q.serving = false;
    }
 #ifdef DEBUG_FAST_IDEAL_SCHED
    if ( req )
@@ -121,7 +213,7 @@ dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 void frfcfs_scheduler::print( FILE *fp )
 {
    for ( unsigned b=0; b < m_config->nbk; b++ ) {
-      printf(" %u: queue length = %u\n", b, (unsigned)m_queue[b].size() );
+      printf(" %u: queue length = %u\n", b, m_queue[b].size );
    }
 }
 
@@ -32,9 +32,15 @@
 #include "shader.h"
 #include "gpu-sim.h"
 #include "gpu-misc.h"
-#include <list>
-#include <map>
+#include <vector>
 
+// First-ready first-come-first-serve: a bank keeps serving the row it has 
+// selected until no request to that row is left, then selects the open row 
+// if a request hits it, otherwise the row of its oldest request. 
+// Requests are chained through their own links (dram_req_t::sched_*) into a
+// queue per bank, oldest first, and into a FIFO per row; the rows of a bank 
+// are found through a small open addressing table, so that neither adding 
+// nor scheduling a request allocates memory.
 class frfcfs_scheduler {
 public:
    frfcfs_scheduler( const memory_config *config, dram_t *dm, memory_stats_t *stats );
@@ -45,12 +51,30 @@ public:
    unsigned num_pending() const { return m_num_pending;}
 
 private:
+   struct row_bin {
+      unsigned row;
+      bool valid;
+      dram_req_t *oldest; 
+      dram_req_t *newest;
+   };
+   struct bank_queue {
+      dram_req_t *oldest;
+      dram_req_t *newest;
+      unsigned size;
+      std::vector<row_bin> bins; // power of two, at most half full
+      unsigned n_bins;
+      bool serving; // a row is selected
+      unsigned serving_row;
+   };
+
+   unsigned find_bin( const bank_queue &q, unsigned row ) const;
+   unsigned add_bin( bank_queue &q, unsigned row );
+   void remove_bin( bank_queue &q, unsigned slot );
+
    const memory_config *m_config;
    dram_t *m_dram;
    unsigned m_num_pending;
-   std::list<dram_req_t*>                                    *m_queue;
-   std::map<unsigned,std::list<std::list<dram_req_t*>::iterator> >    *m_bins;
-   std::list<std::list<dram_req_t*>::iterator>                 **m_last_row;
+   bank_queue *m_queue;
    unsigned *curr_row_service_time; //one set of variables for each bank.
    unsigned *row_service_timestamp; //tracks when scheduler began servicing current row
 
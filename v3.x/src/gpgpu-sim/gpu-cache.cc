@@ -27,7 +27,9 @@
 
 #include "gpu-cache.h"
 #include "stat-tool.h"
+#include "../checkpoint.h"
 #include <assert.h>
+#include <algorithm>
 
 #define MAX_DEFAULT_CACHE_SIZE_MULTIBLIER 4
 // used to allocate memory that is large enough to adapt the changes in cache size across kernels
@@ -64,17 +66,12 @@ unsigned l2_cache_config::set_index(new_addr_type addr) const{
 
 tag_array::~tag_array() 
 {
-    delete[] m_lines;
-}
-
-tag_array::tag_array( cache_config &config,
-                      int core_id,
-                      int type_id,
-                      cache_block_t* new_lines)
-    : m_config( config ),
-      m_lines( new_lines )
-{
-    init( core_id, type_id );
+    delete[] m_tag;
+    delete[] m_block_addr;
+    delete[] m_alloc_time;
+    delete[] m_last_access_time;
+    delete[] m_fill_time;
+    delete[] m_status;
 }
 
 void tag_array::update_cache_parameters(cache_config &config)
@@ -88,7 +85,22 @@ tag_array::tag_array( cache_config &config,
     : m_config( config )
 {
     //assert( m_config.m_write_policy == READ_ONLY ); Old assert
-    m_lines = new cache_block_t[MAX_DEFAULT_CACHE_SIZE_MULTIBLIER*config.get_num_lines()];
+    unsigned n_lines = MAX_DEFAULT_CACHE_SIZE_MULTIBLIER*config.get_num_lines();
+    m_tag = new new_addr_type[n_lines];
+    m_block_addr = new new_addr_type[n_lines];
+    m_alloc_time = new unsigned[n_lines];
+    m_last_access_time = new unsigned[n_lines];
+    m_fill_time = new unsigned[n_lines];
+    m_status = new unsigned char[n_lines];
+    for (unsigned i=0; i < n_lines; i++) {
+        cache_block_t line;
+        m_tag[i] = line.m_tag;
+        m_block_addr[i] = line.m_block_addr;
+        m_alloc_time[i] = line.m_alloc_time;
+        m_last_access_time[i] = line.m_last_access_time;
+        m_fill_time[i] = line.m_fill_time;
+        m_status[i] = line.m_status;
+    }
     init( core_id, type_id );
 }
 
@@ -106,66 +118,97 @@ void tag_array::init( int core_id, int type_id )
     m_type_id = type_id;
 }
 
+cache_block_t tag_array::get_block( unsigned idx ) const
+{
+    cache_block_t line;
+    line.m_tag = m_tag[idx];
+    line.m_block_addr = m_block_addr[idx];
+    line.m_alloc_time = m_alloc_time[idx];
+    line.m_last_access_time = m_last_access_time[idx];
+    line.m_fill_time = m_fill_time[idx];
+    line.m_status = (cache_block_state) m_status[idx];
+    return line;
+}
+
+void tag_array::allocate_line( unsigned idx, new_addr_type tag, new_addr_type block_addr, unsigned time )
+{
+    m_tag[idx] = tag;
+    m_block_addr[idx] = block_addr;
+    m_alloc_time[idx] = time;
+    m_last_access_time[idx] = time;
+    m_fill_time[idx] = 0;
+    m_status[idx] = RESERVED;
+}
+
+void tag_array::fill_line( unsigned idx, unsigned time )
+{
+    assert( m_status[idx] == RESERVED );
+    m_status[idx] = VALID;
+    m_fill_time[idx] = time;
+}
+
+void tag_array::swap_lines( unsigned a, unsigned b )
+{
+    std::swap(m_tag[a],m_tag[b]);
+    std::swap(m_block_addr[a],m_block_addr[b]);
+    std::swap(m_alloc_time[a],m_alloc_time[b]);
+    std::swap(m_last_access_time[a],m_last_access_time[b]);
+    std::swap(m_fill_time[a],m_fill_time[b]);
+    std::swap(m_status[a],m_status[b]);
+}
+
+// Each question is answered by a reduction over all ways of the set without 
+// early exits, which the compiler turns into SIMD compares of the packed 
+// tags, states and timestamps. The result is the one of the sequential scan:
+// the first matching way hits, otherwise the last invalid way or the first 
+// unreserved valid way with the oldest timestamp is the victim.
 enum cache_request_status tag_array::probe( new_addr_type addr, unsigned &idx ) const {
     //assert( m_config.m_write_policy == READ_ONLY );
     unsigned set_index = m_config.set_index(addr);
     new_addr_type tag = m_config.tag(addr);
-
-    unsigned invalid_line = (unsigned)-1;
-    unsigned valid_line = (unsigned)-1;
-    unsigned valid_timestamp = (unsigned)-1;
-
-    bool all_reserved = true;
+    const unsigned assoc = m_config.m_assoc;
+    const unsigned base = set_index*assoc;
+    const new_addr_type *tags = m_tag + base;
+    const unsigned char *status = m_status + base;
 
     // check for hit or pending hit
-    for (unsigned way=0; way<m_config.m_assoc; way++) {
-        unsigned index = set_index*m_config.m_assoc+way;
-        cache_block_t *line = &m_lines[index];
-        if (line->m_tag == tag) {
-            if ( line->m_status == RESERVED ) {
-                idx = index;
-                return HIT_RESERVED;
-            } else if ( line->m_status == VALID ) {
-                idx = index;
-                return HIT;
-            } else if ( line->m_status == MODIFIED ) {
-                idx = index;
-                return HIT;
-            } else {
-                assert( line->m_status == INVALID );
-            }
-        }
-        if (line->m_status != RESERVED) {
-            all_reserved = false;
-            if (line->m_status == INVALID) {
-                invalid_line = index;
-            } else {
-                // valid line : keep track of most appropriate replacement candidate
-                if ( m_config.m_replacement_policy == LRU ) {
-                    if ( line->m_last_access_time < valid_timestamp ) {
-                        valid_timestamp = line->m_last_access_time;
-                        valid_line = index;
-                    }
-                } else if ( m_config.m_replacement_policy == FIFO ) {
-                    if ( line->m_alloc_time < valid_timestamp ) {
-                        valid_timestamp = line->m_alloc_time;
-                        valid_line = index;
-                    }
-                }
-            }
-        }
+    unsigned hit_way = assoc;
+    for (unsigned way=0; way<assoc; way++) {
+        unsigned w = (tags[way] == tag && status[way] != INVALID)? way : assoc;
+        hit_way = w < hit_way? w : hit_way;
+    }
+    if (hit_way != assoc) {
+        idx = base + hit_way;
+        return (status[hit_way] == RESERVED)? HIT_RESERVED : HIT;
+    }
+
+    unsigned n_reserved = 0;
+    int invalid_way = -1;
+    for (unsigned way=0; way<assoc; way++) {
+        n_reserved += (status[way] == RESERVED);
+        int w = (status[way] == INVALID)? (int)way : -1;
+        invalid_way = w > invalid_way? w : invalid_way;
     }
-    if ( all_reserved ) {
+    if ( n_reserved == assoc ) {
         assert( m_config.m_alloc_policy == ON_MISS ); 
         return RESERVATION_FAIL; // miss and not enough space in cache to allocate on miss
     }
+    if ( invalid_way != -1 ) {
+        idx = base + invalid_way;
+        return MISS;
+    }
 
-    if ( invalid_line != (unsigned)-1 ) {
-        idx = invalid_line;
-    } else if ( valid_line != (unsigned)-1) {
-        idx = valid_line;
-    } else abort(); // if an unreserved block exists, it is either invalid or replaceable 
-
+    // valid line : most appropriate replacement candidate, keyed by timestamp then way
+    const unsigned *timestamp = ((m_config.m_replacement_policy == LRU)? m_last_access_time : m_alloc_time) + base;
+    unsigned long long victim = (unsigned long long)-1;
+    for (unsigned way=0; way<assoc; way++) {
+        unsigned long long key = (status[way] == VALID || status[way] == MODIFIED)? 
+            ((unsigned long long)timestamp[way] << 32 | way) : (unsigned long long)-1;
+        victim = key < victim? key : victim;
+    }
+    if ( (victim >> 32) == (unsigned)-1 ) 
+        abort(); // if an unreserved block exists, it is either invalid or replaceable 
+    idx = base + (unsigned)(victim & 0xffffffff);
     return MISS;
 }
 
@@ -187,17 +230,17 @@ enum cache_request_status tag_array::access( new_addr_type addr, unsigned time,
     case HIT_RESERVED: 
         m_pending_hit++;
     case HIT: 
-        m_lines[idx].m_last_access_time=time; 
+        m_last_access_time[idx]=time; 
         break;
     case MISS:
         m_miss++;
         shader_cache_access_log(m_core_id, m_type_id, 1); // log cache misses
         if ( m_config.m_alloc_policy == ON_MISS ) {
-            if( m_lines[idx].m_status == MODIFIED ) {
+            if( m_status[idx] == MODIFIED ) {
                 wb = true;
-                evicted = m_lines[idx];
+                evicted = get_block(idx);
             }
-            m_lines[idx].allocate( m_config.tag(addr), m_config.block_addr(addr), time );
+            allocate_line( idx, m_config.tag(addr), m_config.block_addr(addr), time );
         }
         break;
     case RESERVATION_FAIL:
@@ -218,20 +261,80 @@ void tag_array::fill( new_addr_type addr, unsigned time )
     unsigned idx;
     enum cache_request_status status = probe(addr,idx);
     assert(status==MISS); // MSHR should have prevented redundant memory request
-    m_lines[idx].allocate( m_config.tag(addr), m_config.block_addr(addr), time );
-    m_lines[idx].fill(time);
+    allocate_line( idx, m_config.tag(addr), m_config.block_addr(addr), time );
+    fill_line( idx, time );
 }
 
 void tag_array::fill( unsigned index, unsigned time ) 
 {
     assert( m_config.m_alloc_policy == ON_MISS );
-    m_lines[index].fill(time);
+    fill_line( index, time );
 }
 
 void tag_array::flush() 
 {
     for (unsigned i=0; i < m_config.get_num_lines(); i++)
-        m_lines[i].m_status = INVALID;
+        m_status[i] = INVALID;
+}
+
+// Brings the block of addr into the cache as if an access had just completed.
+// Used to keep caches warm while CTAs are executed functionally, so there is
+// no MSHR, no memory traffic and no statistics; lines reserved by requests in
+// flight are left alone and dirty victims are dropped. All accesses of a 
+// fast-forward share one timestamp, so a warmed line is also moved behind the
+// other unreserved ways of its set to keep LRU order among them.
+void tag_array::warm( new_addr_type addr, unsigned time, bool is_write )
+{
+    unsigned idx;
+    enum cache_request_status status = probe(addr,idx);
+    if ( status == HIT ) {
+        m_last_access_time[idx] = time;
+    } else if ( status == MISS ) {
+        if ( is_write && m_config.m_write_alloc_policy == NO_WRITE_ALLOCATE ) 
+            return;
+        allocate_line( idx, m_config.tag(addr), m_config.block_addr(addr), time );
+        fill_line( idx, time );
+    } else {
+        return;
+    }
+    if ( is_write && m_config.m_write_policy == WRITE_BACK ) 
+        m_status[idx] = MODIFIED;
+
+    if ( status == HIT && m_config.m_replacement_policy != LRU ) 
+        return;
+    unsigned set_end = (idx/m_config.m_assoc + 1)*m_config.m_assoc;
+    for ( unsigned next=idx+1; next < set_end; next++ ) {
+        if ( m_status[next] == RESERVED ) 
+            continue;
+        swap_lines(idx,next);
+        idx = next;
+    }
+}
+
+// Only lines are saved: the access counters are statistics of the run that 
+// wrote the checkpoint.  Kernel boundaries have no fills in flight.
+void tag_array::checkpoint( FILE *fp ) const
+{
+    unsigned n = m_config.get_num_lines();
+    checkpoint_write_section(fp,"TAGS",n);
+    checkpoint_write_bytes(fp,m_tag,n*sizeof(new_addr_type));
+    checkpoint_write_bytes(fp,m_block_addr,n*sizeof(new_addr_type));
+    checkpoint_write_bytes(fp,m_alloc_time,n*sizeof(unsigned));
+    checkpoint_write_bytes(fp,m_last_access_time,n*sizeof(unsigned));
+    checkpoint_write_bytes(fp,m_fill_time,n*sizeof(unsigned));
+    checkpoint_write_bytes(fp,m_status,n*sizeof(unsigned char));
+}
+
+void tag_array::restore( FILE *fp )
+{
+    unsigned n = m_config.get_num_lines();
+    checkpoint_read_section(fp,"TAGS",n);
+    checkpoint_read_bytes(fp,m_tag,n*sizeof(new_addr_type));
+    checkpoint_read_bytes(fp,m_block_addr,n*sizeof(new_addr_type));
+    checkpoint_read_bytes(fp,m_alloc_time,n*sizeof(unsigned));
+    checkpoint_read_bytes(fp,m_last_access_time,n*sizeof(unsigned));
+    checkpoint_read_bytes(fp,m_fill_time,n*sizeof(unsigned));
+    checkpoint_read_bytes(fp,m_status,n*sizeof(unsigned char));
 }
 
 float tag_array::windowed_miss_rate( ) const
@@ -272,92 +375,175 @@ void tag_array::get_stats(unsigned &total_access, unsigned &total_misses, unsign
 }
 
 
-bool was_write_sent( const std::list<cache_event> &events )
+bool was_write_sent( const cache_event_list &events )
 {
-    for( std::list<cache_event>::const_iterator e=events.begin(); e!=events.end(); e++ ) {
-        if( *e == WRITE_REQUEST_SENT ) 
-            return true;
-    }
-    return false;
+    return events.contains(WRITE_REQUEST_SENT);
 }
 
-bool was_writeback_sent( const std::list<cache_event> &events )
+bool was_writeback_sent( const cache_event_list &events )
 {
-    for( std::list<cache_event>::const_iterator e=events.begin(); e!=events.end(); e++ ) {
-        if( *e == WRITE_BACK_REQUEST_SENT ) 
-            return true;
-    }
-    return false;
+    return events.contains(WRITE_BACK_REQUEST_SENT);
 }
 
-bool was_read_sent( const std::list<cache_event> &events )
+bool was_read_sent( const cache_event_list &events )
 {
-    for( std::list<cache_event>::const_iterator e=events.begin(); e!=events.end(); e++ ) {
-        if( *e == READ_REQUEST_SENT ) 
-            return true;
-    }
-    return false;
+    return events.contains(READ_REQUEST_SENT);
 }
 /****************************************************************** MSHR ******************************************************************/
 
+mshr_table::mshr_table( unsigned num_entries, unsigned max_merged )
+    : m_num_entries(num_entries),
+    m_max_merged(max_merged)
+{
+    m_slot_bits = 1;
+    while ( (1u << m_slot_bits) < 2*num_entries ) 
+        m_slot_bits++;
+    mshr_entry empty;
+    empty.m_block_addr = 0;
+    empty.m_head = empty.m_tail = NIL;
+    empty.m_size = 0;
+    empty.m_valid = false;
+    empty.m_has_atomic = false;
+    m_slots.assign(1u << m_slot_bits, empty);
+    m_n_entries = 0;
+
+    m_requests.resize(num_entries*max_merged);
+    for ( unsigned i=0; i < m_requests.size(); i++ ) {
+        m_requests[i].m_mf = NULL;
+        m_requests[i].m_next = i+1 < m_requests.size()? i+1 : NIL;
+    }
+    m_free_request = m_requests.empty()? NIL : 0;
+
+    m_ready.resize(num_entries);
+    m_ready_head = 0;
+    m_n_ready = 0;
+}
+
+unsigned mshr_table::home_slot( new_addr_type block_addr ) const{
+    // Fibonacci hashing: the low bits of a block address are always zero
+    return (unsigned)((block_addr * 0x9E3779B97F4A7C15ULL) >> (64 - m_slot_bits));
+}
+
+/// Slot of the entry of block_addr, NIL if there is none
+unsigned mshr_table::find( new_addr_type block_addr ) const{
+    unsigned mask = m_slots.size() - 1;
+    for ( unsigned s = home_slot(block_addr); m_slots[s].m_valid; s = (s+1) & mask ) {
+        if ( m_slots[s].m_block_addr == block_addr ) 
+            return s;
+    }
+    return NIL;
+}
+
+/// Frees an entry, shifting back the entries that probed past it
+void mshr_table::release( unsigned slot ){
+    unsigned mask = m_slots.size() - 1;
+    m_slots[slot].m_valid = false;
+    m_n_entries--;
+    for ( unsigned next = (slot+1) & mask; m_slots[next].m_valid; next = (next+1) & mask ) {
+        unsigned home = home_slot(m_slots[next].m_block_addr);
+        bool stays = (slot <= next)? (slot < home && home <= next) : (slot < home || home <= next);
+        if ( stays ) 
+            continue;
+        m_slots[slot] = m_slots[next];
+        m_slots[next].m_valid = false;
+        slot = next;
+    }
+}
+
 /// Checks if there is a pending request to the lower memory level already
 bool mshr_table::probe( new_addr_type block_addr ) const{
-    table::const_iterator a = m_data.find(block_addr);
-    return a != m_data.end();
+    return find(block_addr) != NIL;
 }
 
 /// Checks if there is space for tracking a new memory access
 bool mshr_table::full( new_addr_type block_addr ) const{
-    table::const_iterator i=m_data.find(block_addr);
-    if ( i != m_data.end() )
-        return i->second.m_list.size() >= m_max_merged;
+    unsigned s = find(block_addr);
+    if ( s != NIL )
+        return m_slots[s].m_size >= m_max_merged;
     else
-        return m_data.size() >= m_num_entries;
+        return m_n_entries >= m_num_entries;
 }
 
 /// Add or merge this access
 void mshr_table::add( new_addr_type block_addr, mem_fetch *mf ){
-	m_data[block_addr].m_list.push_back(mf);
-	assert( m_data.size() <= m_num_entries );
-	assert( m_data[block_addr].m_list.size() <= m_max_merged );
+    unsigned s = find(block_addr);
+    if ( s == NIL ) {
+        assert( m_n_entries < m_num_entries );
+        unsigned mask = m_slots.size() - 1;
+        for ( s = home_slot(block_addr); m_slots[s].m_valid; s = (s+1) & mask ) 
+            ;
+        mshr_entry &e = m_slots[s];
+        e.m_block_addr = block_addr;
+        e.m_head = e.m_tail = NIL;
+        e.m_size = 0;
+        e.m_valid = true;
+        e.m_has_atomic = false;
+        m_n_entries++;
+    }
+    mshr_entry &e = m_slots[s];
+    assert( e.m_size < m_max_merged && m_free_request != NIL );
+    unsigned r = m_free_request;
+    m_free_request = m_requests[r].m_next;
+    m_requests[r].m_mf = mf;
+    m_requests[r].m_next = NIL;
+    if ( e.m_tail == NIL ) 
+        e.m_head = r;
+    else 
+        m_requests[e.m_tail].m_next = r;
+    e.m_tail = r;
+    e.m_size++;
 	// indicate that this MSHR entry contains an atomic operation
 	if ( mf->isatomic() ) {
-		m_data[block_addr].m_has_atomic = true;
+		e.m_has_atomic = true;
 	}
 }
 
 /// Accept a new cache fill response: mark entry ready for processing
 void mshr_table::mark_ready( new_addr_type block_addr, bool &has_atomic ){
     assert( !busy() );
-    table::iterator a = m_data.find(block_addr);
-    assert( a != m_data.end() ); // don't remove same request twice
-    m_current_response.push_back( block_addr );
-    has_atomic = a->second.m_has_atomic;
-    assert( m_current_response.size() <= m_data.size() );
+    unsigned s = find(block_addr);
+    assert( s != NIL ); // don't remove same request twice
+    assert( m_n_ready < m_n_entries );
+    m_ready[(m_ready_head + m_n_ready) % m_ready.size()] = block_addr;
+    m_n_ready++;
+    has_atomic = m_slots[s].m_has_atomic;
 }
 
 /// Returns next ready access
 mem_fetch *mshr_table::next_access(){
     assert( access_ready() );
-    new_addr_type block_addr = m_current_response.front();
-    assert( !m_data[block_addr].m_list.empty() );
-    mem_fetch *result = m_data[block_addr].m_list.front();
-    m_data[block_addr].m_list.pop_front();
-    if ( m_data[block_addr].m_list.empty() ) {
+    unsigned s = find( m_ready[m_ready_head] );
+    assert( s != NIL );
+    mshr_entry &e = m_slots[s];
+    assert( e.m_head != NIL );
+    unsigned r = e.m_head;
+    mem_fetch *result = m_requests[r].m_mf;
+    e.m_head = m_requests[r].m_next;
+    if ( e.m_head == NIL ) 
+        e.m_tail = NIL;
+    e.m_size--;
+    m_requests[r].m_mf = NULL;
+    m_requests[r].m_next = m_free_request;
+    m_free_request = r;
+    if ( e.m_size == 0 ) {
         // release entry
-        m_data.erase(block_addr);
-        m_current_response.pop_front();
+        release(s);
+        m_ready_head = (m_ready_head + 1) % m_ready.size();
+        m_n_ready--;
     }
     return result;
 }
 
 void mshr_table::display( FILE *fp ) const{
     fprintf(fp,"MSHR contents\n");
-    for ( table::const_iterator e=m_data.begin(); e!=m_data.end(); ++e ) {
-        unsigned block_addr = e->first;
-        fprintf(fp,"MSHR: tag=0x%06x, atomic=%d %zu entries : ", block_addr, e->second.m_has_atomic, e->second.m_list.size());
-        if ( !e->second.m_list.empty() ) {
-            mem_fetch *mf = e->second.m_list.front();
+    for ( unsigned s=0; s < m_slots.size(); s++ ) {
+        const mshr_entry &e = m_slots[s];
+        if ( !e.m_valid ) 
+            continue;
+        unsigned block_addr = e.m_block_addr;
+        fprintf(fp,"MSHR: tag=0x%06x, atomic=%d %u entries : ", block_addr, e.m_has_atomic, e.m_size);
+        if ( e.m_head != NIL ) {
+            mem_fetch *mf = m_requests[e.m_head].m_mf;
             fprintf(fp,"%p :",mf);
             mf->print(fp);
         } else {
@@ -571,7 +757,7 @@ baseline_cache::bandwidth_management::bandwidth_management(cache_config &config)
 }
 
 /// use the data port based on the outcome and events generated by the mem_fetch request 
-void baseline_cache::bandwidth_management::use_data_port(mem_fetch *mf, enum cache_request_status outcome, const std::list<cache_event> &events)
+void baseline_cache::bandwidth_management::use_data_port(mem_fetch *mf, enum cache_request_status outcome, const cache_event_list &events)
 {
     unsigned data_size = mf->get_data_size(); 
     unsigned port_width = m_config.m_data_port_width; 
@@ -661,8 +847,7 @@ void baseline_cache::fill(mem_fetch *mf, unsigned time){
     m_mshrs.mark_ready(e->second.m_block_addr, has_atomic);
     if (has_atomic) {
         assert(m_config.m_alloc_policy == ON_MISS);
-        cache_block_t &block = m_tag_array->get_block(e->second.m_cache_index);
-        block.m_status = MODIFIED; // mark line as dirty for atomic operation
+        m_tag_array->set_status(e->second.m_cache_index,MODIFIED); // mark line as dirty for atomic operation
     }
     m_extra_mf_fields.erase(mf);
     m_bandwidth_management.use_fill_port(mf); 
@@ -687,7 +872,7 @@ void baseline_cache::display_state( FILE *fp ) const{
 
 /// Read miss handler without writeback
 void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_addr, unsigned cache_index, mem_fetch *mf,
-		unsigned time, bool &do_miss, std::list<cache_event> &events, bool read_only, bool wa){
+		unsigned time, bool &do_miss, cache_event_list &events, bool read_only, bool wa){
 
 	bool wb=false;
 	cache_block_t e;
@@ -696,7 +881,7 @@ void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_a
 
 /// Read miss handler. Check MSHR hit or MSHR available
 void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_addr, unsigned cache_index, mem_fetch *mf,
-		unsigned time, bool &do_miss, bool &wb, cache_block_t &evicted, std::list<cache_event> &events, bool read_only, bool wa){
+		unsigned time, bool &do_miss, bool &wb, cache_block_t &evicted, cache_event_list &events, bool read_only, bool wa){
 
     bool mshr_hit = m_mshrs.probe(block_addr);
     bool mshr_avail = !m_mshrs.full(block_addr);
@@ -727,7 +912,7 @@ void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_a
 
 
 /// Sends write request to lower level memory (write or writeback)
-void data_cache::send_write_request(mem_fetch *mf, cache_event request, unsigned time, std::list<cache_event> &events){
+void data_cache::send_write_request(mem_fetch *mf, cache_event request, unsigned time, cache_event_list &events){
     events.push_back(request);
     m_miss_queue.push_back(mf);
     mf->set_status(m_miss_queue_status,time);
@@ -737,24 +922,22 @@ void data_cache::send_write_request(mem_fetch *mf, cache_event request, unsigned
 /****** Write-hit functions (Set by config file) ******/
 
 /// Write-back hit: Mark block as modified
-cache_request_status data_cache::wr_hit_wb(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, std::list<cache_event> &events, enum cache_request_status status ){
+cache_request_status data_cache::wr_hit_wb(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, cache_event_list &events, enum cache_request_status status ){
 	new_addr_type block_addr = m_config.block_addr(addr);
 	m_tag_array->access(block_addr,time,cache_index); // update LRU state
-	cache_block_t &block = m_tag_array->get_block(cache_index);
-	block.m_status = MODIFIED;
+	m_tag_array->set_status(cache_index,MODIFIED);
 
 	return HIT;
 }
 
 /// Write-through hit: Directly send request to lower level memory
-cache_request_status data_cache::wr_hit_wt(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, std::list<cache_event> &events, enum cache_request_status status ){
+cache_request_status data_cache::wr_hit_wt(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, cache_event_list &events, enum cache_request_status status ){
 	if(miss_queue_full(0))
 		return RESERVATION_FAIL; // cannot handle request this cycle
 
 	new_addr_type block_addr = m_config.block_addr(addr);
 	m_tag_array->access(block_addr,time,cache_index); // update LRU state
-	cache_block_t &block = m_tag_array->get_block(cache_index);
-	block.m_status = MODIFIED;
+	m_tag_array->set_status(cache_index,MODIFIED);
 
 	// generate a write-through
 	send_write_request(mf, WRITE_REQUEST_SENT, time, events);
@@ -763,22 +946,21 @@ cache_request_status data_cache::wr_hit_wt(new_addr_type addr, unsigned cache_in
 }
 
 /// Write-evict hit: Send request to lower level memory and invalidate corresponding block
-cache_request_status data_cache::wr_hit_we(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, std::list<cache_event> &events, enum cache_request_status status ){
+cache_request_status data_cache::wr_hit_we(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, cache_event_list &events, enum cache_request_status status ){
 	if(miss_queue_full(0))
 		return RESERVATION_FAIL; // cannot handle request this cycle
 
 	// generate a write-through/evict
-	cache_block_t &block = m_tag_array->get_block(cache_index);
 	send_write_request(mf, WRITE_REQUEST_SENT, time, events);
 
 	// Invalidate block
-	block.m_status = INVALID;
+	m_tag_array->set_status(cache_index,INVALID);
 
 	return HIT;
 }
 
 /// Global write-evict, local write-back: Useful for private caches
-enum cache_request_status data_cache::wr_hit_global_we_local_wb(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, std::list<cache_event> &events, enum cache_request_status status ){
+enum cache_request_status data_cache::wr_hit_global_we_local_wb(new_addr_type addr, unsigned cache_index, mem_fetch *mf, unsigned time, cache_event_list &events, enum cache_request_status status ){
 	bool evict = (mf->get_access_type() == GLOBAL_ACC_W); // evict a line that hits on global memory write
 	if(evict)
 		return wr_hit_we(addr, cache_index, mf, time, events, status); // Write-evict
@@ -793,7 +975,7 @@ enum cache_request_status data_cache::wr_hit_global_we_local_wb(new_addr_type ad
 enum cache_request_status
 data_cache::wr_miss_wa( new_addr_type addr,
                         unsigned cache_index, mem_fetch *mf,
-                        unsigned time, std::list<cache_event> &events,
+                        unsigned time, cache_event_list &events,
                         enum cache_request_status status )
 {
     new_addr_type block_addr = m_config.block_addr(addr);
@@ -813,14 +995,14 @@ data_cache::wr_miss_wa( new_addr_type addr,
     //if(!send_write_allocate(mf, addr, block_addr, cache_index, time, events))
     //    return RESERVATION_FAIL;
 
-    const mem_access_t *ma = new  mem_access_t( m_wr_alloc_type,
+    const mem_access_t ma( m_wr_alloc_type,
                         mf->get_addr(),
                         mf->get_data_size(),
                         false, // Now performing a read
                         mf->get_access_warp_mask(),
                         mf->get_access_byte_mask() );
 
-    mem_fetch *n_mf = new mem_fetch( *ma,
+    mem_fetch *n_mf = new mem_fetch( ma,
                     NULL,
                     mf->get_ctrl_size(),
                     mf->get_wid(),
@@ -857,7 +1039,7 @@ data_cache::wr_miss_no_wa( new_addr_type addr,
                            unsigned cache_index,
                            mem_fetch *mf,
                            unsigned time,
-                           std::list<cache_event> &events,
+                           cache_event_list &events,
                            enum cache_request_status status )
 {
     if(miss_queue_full(0))
@@ -878,7 +1060,7 @@ data_cache::rd_hit_base( new_addr_type addr,
                          unsigned cache_index,
                          mem_fetch *mf,
                          unsigned time,
-                         std::list<cache_event> &events,
+                         cache_event_list &events,
                          enum cache_request_status status )
 {
     new_addr_type block_addr = m_config.block_addr(addr);
@@ -887,8 +1069,7 @@ data_cache::rd_hit_base( new_addr_type addr,
     // MODIFIED
     if(mf->isatomic()){ 
         assert(mf->get_access_type() == GLOBAL_ACC_R);
-        cache_block_t &block = m_tag_array->get_block(cache_index);
-        block.m_status = MODIFIED;  // mark line as dirty
+        m_tag_array->set_status(cache_index,MODIFIED);  // mark line as dirty
     }
     return HIT;
 }
@@ -902,7 +1083,7 @@ data_cache::rd_miss_base( new_addr_type addr,
                           unsigned cache_index,
                           mem_fetch *mf,
                           unsigned time,
-                          std::list<cache_event> &events,
+                          cache_event_list &events,
                           enum cache_request_status status ){
     if(miss_queue_full(1))
         // cannot handle request this cycle
@@ -937,7 +1118,7 @@ enum cache_request_status
 read_only_cache::access( new_addr_type addr,
                          mem_fetch *mf,
                          unsigned time,
-                         std::list<cache_event> &events )
+                         cache_event_list &events )
 {
     assert( mf->get_data_size() <= m_config.get_line_sz());
     assert(m_config.m_write_policy == READ_ONLY);
@@ -976,7 +1157,7 @@ data_cache::process_tag_probe( bool wr,
                                unsigned cache_index,
                                mem_fetch* mf,
                                unsigned time,
-                               std::list<cache_event>& events )
+                               cache_event_list& events )
 {
     // Each function pointer ( m_[rd/wr]_[hit/miss] ) is set in the
     // data_cache constructor to reflect the corresponding cache configuration
@@ -1018,7 +1199,7 @@ enum cache_request_status
 data_cache::access( new_addr_type addr,
                     mem_fetch *mf,
                     unsigned time,
-                    std::list<cache_event> &events )
+                    cache_event_list &events )
 {
 
     assert( mf->get_data_size() <= m_config.get_line_sz());
@@ -1042,7 +1223,7 @@ enum cache_request_status
 l1_cache::access( new_addr_type addr,
                   mem_fetch *mf,
                   unsigned time,
-                  std::list<cache_event> &events )
+                  cache_event_list &events )
 {
     return data_cache::access( addr, mf, time, events );
 }
@@ -1054,7 +1235,7 @@ enum cache_request_status
 l2_cache::access( new_addr_type addr,
                   mem_fetch *mf,
                   unsigned time,
-                  std::list<cache_event> &events )
+                  cache_event_list &events )
 {
     return data_cache::access( addr, mf, time, events );
 }
@@ -1065,7 +1246,7 @@ l2_cache::access( new_addr_type addr,
 /// since unlike a normal CPU cache, a "HIT" in texture cache does not
 /// mean the data is ready (still need to get through fragment fifo)
 enum cache_request_status tex_cache::access( new_addr_type addr, mem_fetch *mf,
-    unsigned time, std::list<cache_event> &events )
+    unsigned time, cache_event_list &events )
 {
     if ( m_fragment_fifo.full() || m_request_fifo.full() || m_rob.full() )
         return RESERVATION_FAIL;
@@ -1152,6 +1333,18 @@ void tex_cache::fill( mem_fetch *mf, unsigned time )
     assert( r.m_block_addr == m_config.block_addr(mf->get_addr()) );
 }
 
+void tex_cache::checkpoint( FILE *fp ) const
+{
+    m_tags.checkpoint(fp);
+    checkpoint_write_bytes(fp,m_cache,m_config.get_num_lines()*sizeof(data_block));
+}
+
+void tex_cache::restore( FILE *fp )
+{
+    m_tags.restore(fp);
+    checkpoint_read_bytes(fp,m_cache,m_config.get_num_lines()*sizeof(data_block));
+}
+
 void tex_cache::display_state( FILE *fp ) const
 {
     fprintf(fp,"%s (texture cache) state:\n", m_name.c_str() );
@@ -61,8 +61,36 @@ enum cache_event {
     WRITE_REQUEST_SENT
 };
 
+// Events generated by a single cache access, in the order they occurred.
+// An access sends at most a write, a read and a write-back request, so the
+// events are kept inline (with a mask for lookups) instead of in a std::list.
+class cache_event_list {
+public:
+    cache_event_list() : m_size(0), m_mask(0) {}
+
+    void push_back( enum cache_event e )
+    {
+        assert( m_size < MAX_EVENTS );
+        m_events[m_size++] = e;
+        m_mask |= 1u << e;
+    }
+    bool contains( enum cache_event e ) const { return (m_mask >> e) & 1; }
+    bool empty() const { return m_size == 0; }
+    unsigned size() const { return m_size; }
+    const enum cache_event *begin() const { return m_events; }
+    const enum cache_event *end() const { return m_events + m_size; }
+    void clear() { m_size = 0; m_mask = 0; }
+
+private:
+    static const unsigned MAX_EVENTS = 4;
+    enum cache_event m_events[MAX_EVENTS];
+    unsigned m_size;
+    unsigned m_mask;
+};
+
 const char * cache_request_status_str(enum cache_request_status status); 
 
+// Copy of one line of a tag_array (which stores its lines as arrays of fields)
 struct cache_block_t {
     cache_block_t()
     {
@@ -326,9 +354,13 @@ public:
     void fill( unsigned idx, unsigned time );
 
     unsigned size() const { return m_config.get_num_lines();}
-    cache_block_t &get_block(unsigned idx) { return m_lines[idx];}
+    cache_block_t get_block(unsigned idx) const;
+    void set_status(unsigned idx, enum cache_block_state status) { m_status[idx] = status; }
 
     void flush(); // flash invalidate all entries
+    void warm( new_addr_type addr, unsigned time, bool is_write ); // install without timing or statistics
+    void checkpoint( FILE *fp ) const; // save/restore the lines at a kernel boundary
+    void restore( FILE *fp );
     void new_window();
 
     void print( FILE *stream, unsigned &total_access, unsigned &total_misses ) const;
@@ -337,20 +369,24 @@ public:
 
 	void update_cache_parameters(cache_config &config);
 protected:
-    // This constructor is intended for use only from derived classes that wish to
-    // avoid unnecessary memory allocation that takes place in the
-    // other tag_array constructor
-    tag_array( cache_config &config,
-               int core_id,
-               int type_id,
-               cache_block_t* new_lines );
     void init( int core_id, int type_id );
+    void allocate_line( unsigned idx, new_addr_type tag, new_addr_type block_addr, unsigned time );
+    void fill_line( unsigned idx, unsigned time );
+    void swap_lines( unsigned a, unsigned b );
 
 protected:
 
     cache_config &m_config;
 
-    cache_block_t *m_lines; /* nbanks x nset x assoc lines in total */
+    // nbanks x nset x assoc lines in total, one array per field so that a 
+    // probe scans only the packed tags, states and replacement timestamps 
+    // of a set (see cache_block_t for the meaning of the fields)
+    new_addr_type *m_tag; 
+    new_addr_type *m_block_addr;
+    unsigned *m_alloc_time;
+    unsigned *m_last_access_time;
+    unsigned *m_fill_time;
+    unsigned char *m_status; // cache_block_state
 
     unsigned m_access;
     unsigned m_miss;
@@ -368,14 +404,7 @@ protected:
 
 class mshr_table {
 public:
-    mshr_table( unsigned num_entries, unsigned max_merged )
-    : m_num_entries(num_entries),
-    m_max_merged(max_merged)
-#if (tr1_hash_map_ismap == 0)
-    ,m_data(2*num_entries)
-#endif
-    {
-    }
+    mshr_table( unsigned num_entries, unsigned max_merged );
 
     /// Checks if there is a pending request to the lower memory level already
     bool probe( new_addr_type block_addr ) const;
@@ -388,7 +417,7 @@ public:
     /// Accept a new cache fill response: mark entry ready for processing
     void mark_ready( new_addr_type block_addr, bool &has_atomic );
     /// Returns true if ready accesses exist
-    bool access_ready() const {return !m_current_response.empty();}
+    bool access_ready() const {return m_n_ready != 0;}
     /// Returns next ready access
     mem_fetch *next_access();
     void display( FILE *fp ) const;
@@ -401,21 +430,43 @@ public:
 
 private:
 
+    unsigned find( new_addr_type block_addr ) const;
+    unsigned home_slot( new_addr_type block_addr ) const;
+    void release( unsigned slot );
+
     // finite sized, fully associative table, with a finite maximum number of merged requests
     const unsigned m_num_entries;
     const unsigned m_max_merged;
 
+    // All storage is allocated up front: the entries live in an open addressing
+    // table (linear probing, at least twice as many slots as entries) and the 
+    // merged requests in a pool of m_num_entries*m_max_merged links.  A request
+    // is in the MSHRs of the L1 and of the L2 at the same time while it misses 
+    // in both, so the links belong to the table rather than to the mem_fetch. 
+    static const unsigned NIL = (unsigned)-1;
     struct mshr_entry {
-        std::list<mem_fetch*> m_list;
+        new_addr_type m_block_addr;
+        unsigned m_head; // oldest merged request
+        unsigned m_tail; 
+        unsigned m_size; 
+        bool m_valid;
         bool m_has_atomic; 
-        mshr_entry() : m_has_atomic(false) { }
     }; 
-    typedef tr1_hash_map<new_addr_type,mshr_entry> table;
-    table m_data;
-
-    // it may take several cycles to process the merged requests
-    bool m_current_response_ready;
-    std::list<new_addr_type> m_current_response;
+    struct merged_request {
+        mem_fetch *m_mf;
+        unsigned m_next;
+    };
+    std::vector<mshr_entry> m_slots;
+    unsigned m_slot_bits;
+    unsigned m_n_entries;
+    std::vector<merged_request> m_requests;
+    unsigned m_free_request; // free list through m_next
+
+    // ring of entries with a fill response, it may take several cycles to 
+    // process the merged requests
+    std::vector<new_addr_type> m_ready;
+    unsigned m_ready_head;
+    unsigned m_n_ready;
 };
 
 
@@ -499,6 +550,7 @@ public:
     void get_sub_stats(struct cache_sub_stats &css) const;
 
     void sample_cache_port_utility(bool data_port_busy, bool fill_port_busy); 
+    void sample_idle_cache_port_cycles(unsigned long long n) { m_cache_port_available_cycles += n; }
 private:
     bool check_valid(int type, int status) const;
 
@@ -512,15 +564,15 @@ private:
 class cache_t {
 public:
     virtual ~cache_t() {}
-    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, std::list<cache_event> &events ) =  0;
+    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, cache_event_list &events ) =  0;
 
     // accessors for cache bandwidth availability 
     virtual bool data_port_free() const = 0; 
     virtual bool fill_port_free() const = 0; 
 };
 
-bool was_write_sent( const std::list<cache_event> &events );
-bool was_read_sent( const std::list<cache_event> &events );
+bool was_write_sent( const cache_event_list &events );
+bool was_read_sent( const cache_event_list &events );
 
 /// Baseline cache
 /// Implements common functions for read_only_cache and data_cache
@@ -559,7 +611,7 @@ public:
 		m_mshrs.check_mshr_parameters(config.m_mshr_entries,config.m_mshr_max_merge);
 	}
 
-    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, std::list<cache_event> &events ) =  0;
+    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, cache_event_list &events ) =  0;
     /// Sends next request to lower level of memory
     void cycle();
     /// Interface for response from lower memory level (model bandwidth restictions in caller)
@@ -572,6 +624,10 @@ public:
     mem_fetch *next_access(){return m_mshrs.next_access();}
     // flash invalidate all entries in cache
     void flush(){m_tag_array->flush();}
+    // functional cache warming (fast-forward of sampled simulation)
+    void warm( new_addr_type addr, unsigned time, bool is_write ) { m_tag_array->warm(addr,time,is_write); }
+    void checkpoint( FILE *fp ) const { m_tag_array->checkpoint(fp); }
+    void restore( FILE *fp ) { m_tag_array->restore(fp); }
     void print(FILE *fp, unsigned &accesses, unsigned &misses) const;
     void display_state( FILE *fp ) const;
 
@@ -590,6 +646,14 @@ public:
     bool data_port_free() const { return m_bandwidth_management.data_port_free(); } 
     bool fill_port_free() const { return m_bandwidth_management.fill_port_free(); } 
 
+    /// True if cycle() would have no effect other than sampling idle ports
+    bool idle() const 
+    { 
+        return m_miss_queue.empty() && !access_ready() && data_port_free() && fill_port_free(); 
+    }
+    /// Accounts for n cycles skipped while idle() (see -gpgpu_skip_idle_cycles)
+    void skip_idle_cycles( unsigned long long n ) { m_stats.sample_idle_cache_port_cycles(n); }
+
 protected:
     // Constructor that can be used by derived classes with custom tag arrays
     baseline_cache( const char *name,
@@ -643,10 +707,10 @@ protected:
     }
     /// Read miss handler without writeback
     void send_read_request(new_addr_type addr, new_addr_type block_addr, unsigned cache_index, mem_fetch *mf,
-    		unsigned time, bool &do_miss, std::list<cache_event> &events, bool read_only, bool wa);
+    		unsigned time, bool &do_miss, cache_event_list &events, bool read_only, bool wa);
     /// Read miss handler. Check MSHR hit or MSHR available
     void send_read_request(new_addr_type addr, new_addr_type block_addr, unsigned cache_index, mem_fetch *mf,
-    		unsigned time, bool &do_miss, bool &wb, cache_block_t &evicted, std::list<cache_event> &events, bool read_only, bool wa);
+    		unsigned time, bool &do_miss, bool &wb, cache_block_t &evicted, cache_event_list &events, bool read_only, bool wa);
 
     /// Sub-class containing all metadata for port bandwidth management 
     class bandwidth_management 
@@ -655,7 +719,7 @@ protected:
         bandwidth_management(cache_config &config); 
 
         /// use the data port based on the outcome and events generated by the mem_fetch request 
-        void use_data_port(mem_fetch *mf, enum cache_request_status outcome, const std::list<cache_event> &events); 
+        void use_data_port(mem_fetch *mf, enum cache_request_status outcome, const cache_event_list &events); 
 
         /// use the fill port 
         void use_fill_port(mem_fetch *mf); 
@@ -684,7 +748,7 @@ public:
     : baseline_cache(name,config,core_id,type_id,memport,status){}
 
     /// Access cache for read_only_cache: returns RESERVATION_FAIL if request could not be accepted (for any reason)
-    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, std::list<cache_event> &events );
+    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, cache_event_list &events );
 
     virtual ~read_only_cache(){}
 
@@ -725,7 +789,7 @@ public:
     }
 
     /// Access cache for read_only_cache: returns RESERVATION_FAIL if request could not be accepted (for any reason)
-    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, std::list<cache_event> &events );
+    virtual enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, cache_event_list &events );
 
     virtual ~banked_read_only_cache(){}
 
@@ -797,7 +861,7 @@ public:
     virtual enum cache_request_status access( new_addr_type addr,
                                               mem_fetch *mf,
                                               unsigned time,
-                                              std::list<cache_event> &events );
+                                              cache_event_list &events );
 protected:
     data_cache( const char *name,
                 cache_config &config,
@@ -829,7 +893,7 @@ protected:
                            unsigned cache_index,
                            mem_fetch* mf,
                            unsigned time,
-                           std::list<cache_event>& events );
+                           cache_event_list& events );
 
 protected:
     mem_fetch_allocator *m_memfetch_creator;
@@ -839,7 +903,7 @@ protected:
     void send_write_request( mem_fetch *mf,
                              cache_event request,
                              unsigned time,
-                             std::list<cache_event> &events);
+                             cache_event_list &events);
 
     // Member Function pointers - Set by configuration options
     // to the functions below each grouping
@@ -849,7 +913,7 @@ protected:
                                  unsigned cache_index,
                                  mem_fetch *mf,
                                  unsigned time,
-                                 std::list<cache_event> &events,
+                                 cache_event_list &events,
                                  enum cache_request_status status );
     /// Marks block as MODIFIED and updates block LRU
     enum cache_request_status
@@ -857,14 +921,14 @@ protected:
                    unsigned cache_index,
                    mem_fetch *mf,
                    unsigned time,
-                   std::list<cache_event> &events,
+                   cache_event_list &events,
                    enum cache_request_status status ); // write-back
     enum cache_request_status
         wr_hit_wt( new_addr_type addr,
                    unsigned cache_index,
                    mem_fetch *mf,
                    unsigned time,
-                   std::list<cache_event> &events,
+                   cache_event_list &events,
                    enum cache_request_status status ); // write-through
 
     /// Marks block as INVALID and sends write request to lower level memory
@@ -873,14 +937,14 @@ protected:
                    unsigned cache_index,
                    mem_fetch *mf,
                    unsigned time,
-                   std::list<cache_event> &events,
+                   cache_event_list &events,
                    enum cache_request_status status ); // write-evict
     enum cache_request_status
         wr_hit_global_we_local_wb( new_addr_type addr,
                                    unsigned cache_index,
                                    mem_fetch *mf,
                                    unsigned time,
-                                   std::list<cache_event> &events,
+                                   cache_event_list &events,
                                    enum cache_request_status status );
         // global write-evict, local write-back
 
@@ -891,7 +955,7 @@ protected:
                                   unsigned cache_index,
                                   mem_fetch *mf,
                                   unsigned time,
-                                  std::list<cache_event> &events,
+                                  cache_event_list &events,
                                   enum cache_request_status status );
     /// Sends read request, and possible write-back request,
     //  to lower level memory for a write miss with write-allocate
@@ -900,14 +964,14 @@ protected:
                     unsigned cache_index,
                     mem_fetch *mf,
                     unsigned time,
-                    std::list<cache_event> &events,
+                    cache_event_list &events,
                     enum cache_request_status status ); // write-allocate
     enum cache_request_status
         wr_miss_no_wa( new_addr_type addr,
                        unsigned cache_index,
                        mem_fetch *mf,
                        unsigned time,
-                       std::list<cache_event> &events,
+                       cache_event_list &events,
                        enum cache_request_status status ); // no write-allocate
 
     // Currently no separate functions for reads
@@ -917,14 +981,14 @@ protected:
                                  unsigned cache_index,
                                  mem_fetch *mf,
                                  unsigned time,
-                                 std::list<cache_event> &events,
+                                 cache_event_list &events,
                                  enum cache_request_status status );
     enum cache_request_status
         rd_hit_base( new_addr_type addr,
                      unsigned cache_index,
                      mem_fetch *mf,
                      unsigned time,
-                     std::list<cache_event> &events,
+                     cache_event_list &events,
                      enum cache_request_status status );
 
     /******* Read-miss configs *******/
@@ -933,14 +997,14 @@ protected:
                                   unsigned cache_index,
                                   mem_fetch *mf,
                                   unsigned time,
-                                  std::list<cache_event> &events,
+                                  cache_event_list &events,
                                   enum cache_request_status status );
     enum cache_request_status
         rd_miss_base( new_addr_type addr,
                       unsigned cache_index,
                       mem_fetch*mf,
                       unsigned time,
-                      std::list<cache_event> &events,
+                      cache_event_list &events,
                       enum cache_request_status status );
 
 };
@@ -962,7 +1026,7 @@ public:
         access( new_addr_type addr,
                 mem_fetch *mf,
                 unsigned time,
-                std::list<cache_event> &events );
+                cache_event_list &events );
 
 protected:
     l1_cache( const char *name,
@@ -994,7 +1058,7 @@ public:
         access( new_addr_type addr,
                 mem_fetch *mf,
                 unsigned time,
-                std::list<cache_event> &events );
+                cache_event_list &events );
 };
 
 /*****************************************************************************/
@@ -1031,7 +1095,7 @@ public:
     /// otherwise returns HIT_RESERVED or MISS; NOTE: *never* returns HIT
     /// since unlike a normal CPU cache, a "HIT" in texture cache does not
     /// mean the data is ready (still need to get through fragment fifo)
-    enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, std::list<cache_event> &events );
+    enum cache_request_status access( new_addr_type addr, mem_fetch *mf, unsigned time, cache_event_list &events );
     void cycle();
     /// Place returning cache block into reorder buffer
     void fill( mem_fetch *mf, unsigned time );
@@ -1039,6 +1103,10 @@ public:
     bool access_ready() const{return !m_result_fifo.empty();}
     /// Pop next ready access (includes both accesses that "HIT" and those that "MISS")
     mem_fetch *next_access(){return m_result_fifo.pop();}
+    /// True if no access is in flight other than misses waiting for memory 
+    bool idle() const { return m_fragment_fifo.empty() && m_request_fifo.empty() && m_result_fifo.empty(); }
+    void checkpoint( FILE *fp ) const;
+    void restore( FILE *fp );
     void display_state( FILE *fp ) const;
 
     // accessors for cache bandwidth availability - stubs for now 
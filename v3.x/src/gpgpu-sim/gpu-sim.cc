@@ -51,6 +51,7 @@
 #include "l2cache.h"
 
 #include "../cuda-sim/ptx-stats.h"
+#include "../cuda-sim/memory.h"
 #include "../statwrapper.h"
 #include "../abstract_hardware_model.h"
 #include "../debug.h"
@@ -61,6 +62,10 @@
 #include "power_stat.h"
 #include "visualizer.h"
 #include "stats.h"
+#include "sim_thread_pool.h"
+#include "warp_trace.h"
+#include "sampling.h"
+#include "../checkpoint.h"
 
 #ifdef GPGPUSIM_POWER_MODEL
 #include "power_interface.h"
@@ -408,6 +413,36 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
                   "500.0:2000.0:2000.0:2000.0");
    option_parser_register(opp, "-gpgpu_max_concurrent_kernel", OPT_INT32, &max_concurrent_kernel,
                           "maximum kernels that can run concurrently on GPU", "8" );
+   option_parser_register(opp, "-gpgpu_sim_threads", OPT_INT32, &gpgpu_sim_threads,
+                          "number of host threads used to simulate SIMT core clusters and L2 sub-partitions, or CTAs in functional simulation mode, in parallel (1 = serial)", 
+                          "1");
+   option_parser_register(opp, "-gpgpu_skip_idle_cycles", OPT_BOOL, &gpgpu_skip_idle_cycles,
+                          "simulate only the DRAM while all cores and L2 caches are waiting on DRAM (1=on, 0=off (default))", 
+                          "0");
+   option_parser_register(opp, "-gpgpu_checkpoint_kernel", OPT_UINT32, &gpgpu_checkpoint_kernel,
+                          "save the simulator state to -gpgpu_checkpoint_file before launching this kernel (kernel uid, 0 = off)", 
+                          "0");
+   option_parser_register(opp, "-gpgpu_resume_kernel", OPT_UINT32, &gpgpu_resume_kernel,
+                          "skip the kernels before this one and restore the state saved by -gpgpu_checkpoint_kernel (kernel uid, 0 = off); device-to-host copies made before this kernel return the data recorded in the checkpoint", 
+                          "0");
+   option_parser_register(opp, "-gpgpu_checkpoint_file", OPT_CSTR, &gpgpu_checkpoint_file,
+                          "checkpoint file written by -gpgpu_checkpoint_kernel and read by -gpgpu_resume_kernel", 
+                          "gpgpusim.ckpt");
+   option_parser_register(opp, "-gpgpu_warp_trace_record", OPT_CSTR, &gpgpu_warp_trace_record,
+                          "record the instruction stream of every warp to this file for -gpgpu_warp_trace_replay", 
+                          NULL);
+   option_parser_register(opp, "-gpgpu_warp_trace_replay", OPT_CSTR, &gpgpu_warp_trace_replay,
+                          "drive the timing model from a trace written by -gpgpu_warp_trace_record instead of functional simulation", 
+                          NULL);
+   option_parser_register(opp, "-gpgpu_sampling", OPT_CSTR, &gpgpu_sampling,
+                          "sampled simulation: fast-forward CTA units functionally except those selected by periodic:P, units:0,3,5-7 or bbv:T", 
+                          NULL);
+   option_parser_register(opp, "-gpgpu_sampling_unit", OPT_UINT32, &gpgpu_sampling_unit,
+                          "CTAs per sampling unit (0 = one wave, as many CTAs as the GPU runs concurrently)", 
+                          "0");
+   option_parser_register(opp, "-gpgpu_sampling_warm_caches", OPT_BOOL, &gpgpu_sampling_warm_caches,
+                          "warm the L1D and L2 with the global accesses of fast-forwarded CTAs", 
+                          "1");
    option_parser_register(opp, "-gpgpu_cflog_interval", OPT_INT32, &gpgpu_cflog_interval, 
                "Interval between each snapshot in control flow logger", 
                "0");
@@ -528,6 +563,10 @@ void gpgpu_sim::set_kernel_done( kernel_info_t *kernel )
 { 
     unsigned uid = kernel->get_uid();
     m_finished_kernel.push_back(uid);
+    if( m_warp_trace ) 
+        m_warp_trace->flush();
+    if( m_sampler ) 
+        m_sampler->kernel_done(*kernel,gpu_sim_cycle+gpu_tot_sim_cycle,gpu_sim_insn+gpu_tot_sim_insn);
     std::vector<kernel_info_t*>::iterator k;
     for( k=m_running_kernels.begin(); k!=m_running_kernels.end(); k++ ) {
         if( *k == kernel ) {
@@ -538,6 +577,119 @@ void gpgpu_sim::set_kernel_done( kernel_info_t *kernel )
     assert( k != m_running_kernels.end() ); 
 }
 
+bool gpgpu_sim::replay_readback( void *dst, size_t src_start_addr, size_t count )
+{
+   if( m_warp_trace && m_warp_trace->replaying() ) {
+      m_warp_trace->replay_readback(m_readback_kernel,dst,src_start_addr,count);
+      return true;
+   }
+   return gpgpu_t::replay_readback(dst,src_start_addr,count);
+}
+
+void gpgpu_sim::record_readback( const void *data, size_t src_start_addr, size_t count )
+{
+   gpgpu_t::record_readback(data,src_start_addr,count);
+   if( m_warp_trace && !m_warp_trace->replaying() ) 
+      m_warp_trace->record_readback(m_readback_kernel,data,src_start_addr,count);
+}
+
+bool gpgpu_sim::skip_kernel( const kernel_info_t &kernel )
+{
+   set_readback_kernel(kernel.get_uid());
+   return kernel.get_uid() < m_config.gpgpu_resume_kernel;
+}
+
+void gpgpu_sim::kernel_boundary( const kernel_info_t &kernel )
+{
+   unsigned uid = kernel.get_uid();
+   if( uid != m_config.gpgpu_checkpoint_kernel && uid != m_config.gpgpu_resume_kernel ) 
+      return;
+   if( active() ) {
+      // the state of kernels still running on other streams is not saved
+      printf("GPGPU-Sim uArch: ERROR ** kernel %u is launched while another kernel is running, "
+             "cannot checkpoint or resume here (set CUDA_LAUNCH_BLOCKING=1)\n", uid );
+      abort();
+   }
+   if( uid == m_config.gpgpu_checkpoint_kernel ) {
+      save_checkpoint(m_config.gpgpu_checkpoint_file,uid);
+      record_readbacks(false);
+   }
+   if( uid == m_config.gpgpu_resume_kernel ) 
+      load_checkpoint(m_config.gpgpu_checkpoint_file,uid);
+}
+
+// The checkpoint holds what kernels before kernel_uid leave behind: device 
+// memory, cache contents, DRAM bank state and the cumulative cycle and 
+// instruction counts.  Host and stream state are recreated by running the 
+// application again with the earlier kernels skipped.  Device memory only 
+// holds the results of the skipped kernels once the checkpoint is restored, 
+// so the device-to-host copies made before kernel_uid are saved as well 
+// (section RDBK) and returned again by the resumed run.
+void gpgpu_sim::save_checkpoint( const char *filename, unsigned kernel_uid ) const
+{
+   FILE *fp = fopen(filename,"wb");
+   if( fp == NULL ) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot open checkpoint file \'%s\' for writing\n", filename);
+      abort();
+   }
+   checkpoint_write_section(fp,"GPGS",kernel_uid);
+   save_readbacks(fp);
+   gpgpu_t::checkpoint(fp);
+   checkpoint_write(fp,gpu_tot_sim_cycle+gpu_sim_cycle);
+   checkpoint_write(fp,gpu_tot_sim_insn+gpu_sim_insn);
+   checkpoint_write(fp,gpu_tot_issued_cta);
+   checkpoint_write_section(fp,"CORE",m_shader_config->n_simt_clusters);
+   for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+      m_cluster[i]->checkpoint(fp);
+   checkpoint_write_section(fp,"MEMP",m_memory_config->m_n_mem);
+   for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+      m_memory_partition_unit[i]->checkpoint(fp);
+   checkpoint_write_section(fp,"MSUB",m_memory_config->m_n_mem_sub_partition);
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+      m_memory_sub_partition[i]->checkpoint(fp);
+   if( fclose(fp) != 0 ) {
+      printf("GPGPU-Sim uArch: ERROR ** failed writing checkpoint file \'%s\'\n", filename);
+      abort();
+   }
+   printf("GPGPU-Sim uArch: saved checkpoint before kernel %u to \'%s\'\n", kernel_uid, filename);
+}
+
+void gpgpu_sim::load_checkpoint( const char *filename, unsigned kernel_uid )
+{
+   FILE *fp = fopen(filename,"rb");
+   if( fp == NULL ) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot open checkpoint file \'%s\'\n", filename);
+      abort();
+   }
+   unsigned long long tot_sim_cycle, tot_sim_insn;
+   checkpoint_read_section(fp,"GPGS",kernel_uid);
+   load_readbacks(fp,false); // already loaded by the constructor
+   if( num_replay_readbacks() ) {
+      printf("GPGPU-Sim uArch: ERROR ** the checkpointed run made %zu more device-to-host copies before kernel %u "
+             "than this run\n", num_replay_readbacks(), kernel_uid );
+      abort();
+   }
+   replay_readbacks(false);
+   gpgpu_t::restore(fp);
+   checkpoint_read(fp,tot_sim_cycle);
+   checkpoint_read(fp,tot_sim_insn);
+   checkpoint_read(fp,gpu_tot_issued_cta);
+   gpu_tot_sim_cycle = tot_sim_cycle - gpu_sim_cycle;
+   gpu_tot_sim_insn = tot_sim_insn - gpu_sim_insn;
+   checkpoint_read_section(fp,"CORE",m_shader_config->n_simt_clusters);
+   for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+      m_cluster[i]->restore(fp);
+   checkpoint_read_section(fp,"MEMP",m_memory_config->m_n_mem);
+   for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+      m_memory_partition_unit[i]->restore(fp);
+   checkpoint_read_section(fp,"MSUB",m_memory_config->m_n_mem_sub_partition);
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+      m_memory_sub_partition[i]->restore(fp);
+   fclose(fp);
+   printf("GPGPU-Sim uArch: resumed from checkpoint \'%s\' before kernel %u (gpu_tot_sim_cycle = %llu, gpu_tot_sim_insn = %llu)\n", 
+          filename, kernel_uid, tot_sim_cycle, tot_sim_insn);
+}
+
 void set_ptx_warp_size(const struct core_config * warp_size);
 
 gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config ) 
@@ -564,9 +716,60 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
     gpu_deadlock = false;
 
 
+    m_warp_trace = NULL;
+    if (m_config.gpgpu_warp_trace_record && m_config.gpgpu_warp_trace_replay) {
+        printf("GPGPU-Sim uArch: ERROR ** -gpgpu_warp_trace_record and -gpgpu_warp_trace_replay are exclusive\n");
+        abort();
+    }
+    if (m_config.gpgpu_warp_trace_record) 
+        m_warp_trace = new warp_trace(m_config.gpgpu_warp_trace_record,false,m_shader_config->warp_size);
+    else if (m_config.gpgpu_warp_trace_replay) 
+        m_warp_trace = new warp_trace(m_config.gpgpu_warp_trace_replay,true,m_shader_config->warp_size);
+
+    m_sampler = NULL;
+    m_ffwd_sid = 0;
+    if (m_config.gpgpu_sampling) {
+        if (m_warp_trace) {
+            printf("GPGPU-Sim uArch: ERROR ** -gpgpu_sampling cannot be combined with a warp trace\n");
+            abort();
+        }
+        m_sampler = new sim_sampler(m_config.gpgpu_sampling,m_config.gpgpu_sampling_unit);
+    }
+
     m_cluster = new simt_core_cluster*[m_shader_config->n_simt_clusters];
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
         m_cluster[i] = new simt_core_cluster(this,i,m_shader_config,m_memory_config,m_shader_stats,m_memory_stats);
+    m_cluster_active = new bool[m_shader_config->n_simt_clusters];
+    if (m_config.gpgpu_checkpoint_kernel) 
+        record_readbacks(true);
+    if (m_config.gpgpu_resume_kernel) {
+        // device-to-host copies made while the earlier kernels are skipped
+        FILE *fp = fopen(m_config.gpgpu_checkpoint_file,"rb");
+        if (fp == NULL) {
+            printf("GPGPU-Sim uArch: ERROR ** cannot open checkpoint file \'%s\'\n", m_config.gpgpu_checkpoint_file);
+            abort();
+        }
+        checkpoint_read_section(fp,"GPGS",m_config.gpgpu_resume_kernel);
+        load_readbacks(fp,true);
+        fclose(fp);
+        replay_readbacks(true);
+    }
+    m_idle_skip = IDLE_SKIP_OFF;
+    m_idle_skip_until = 0;
+    m_idle_skip_core_cycles = 0;
+    m_idle_skip_l2_cycles = 0;
+    m_total_idle_skip_cycles = 0;
+    m_idle_active_sms = 0;
+    m_idle_duty_cycle = 0;
+
+    m_thread_pool = NULL;
+    if (m_config.get_sim_threads() > 1) {
+        m_thread_pool = new sim_thread_pool(m_config.get_sim_threads());
+        m_global_mem->enable_concurrent_access();
+        ptx_sim_set_multithreaded(true);
+        printf("GPGPU-Sim uArch: simulating with %u threads\n", 
+               m_config.get_sim_threads());
+    }
 
     m_memory_partition_unit = new memory_partition_unit*[m_memory_config->m_n_mem];
     m_memory_sub_partition = new memory_sub_partition*[m_memory_config->m_n_mem_sub_partition];
@@ -687,6 +890,7 @@ void gpgpu_sim::init()
     last_gpu_sim_insn = 0;
     m_total_cta_launched=0;
 
+    end_idle_skip();
     reinit_clock_domains();
     set_param_gpgpu_num_shaders(m_config.num_shader());
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
@@ -725,6 +929,7 @@ void gpgpu_sim::update_stats() {
 
 void gpgpu_sim::print_stats()
 {
+    end_idle_skip();
     ptx_file_line_stats_write_file();
     gpu_print_stat();
 
@@ -770,6 +975,7 @@ void gpgpu_sim::deadlock_check()
          printf("GPGPU-Sim uArch DEADLOCK:  iterconnect contains traffic\n");
          icnt_display_state( stdout );
       }
+      mem_fetch::print_live( stdout );
       printf("\nRe-run the simulator in gdb and use debug routines in .gdbinit to debug this\n");
       fflush(stdout);
       abort();
@@ -900,6 +1106,10 @@ void gpgpu_sim::gpu_print_stat()
    // performance counter for stalls due to congestion.
    printf("gpu_stall_dramfull = %d\n", gpu_stall_dramfull);
    printf("gpu_stall_icnt2sh    = %d\n", gpu_stall_icnt2sh );
+   if (m_config.gpgpu_skip_idle_cycles) 
+      printf("gpu_tot_idle_cycles_skipped = %llu\n", m_total_idle_skip_cycles);
+   if (m_sampler) 
+      m_sampler->print(stdout, gpu_tot_sim_cycle+gpu_sim_cycle, gpu_tot_sim_insn+gpu_sim_insn);
 
    time_t curr_time;
    time(&curr_time);
@@ -1142,6 +1352,8 @@ int gpgpu_sim::next_clock_domain(void)
 
 void gpgpu_sim::issue_block2core()
 {
+    if (m_sampler) 
+        fast_forward_ctas();
     unsigned last_issued = m_last_cluster_issue; 
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
         unsigned idx = (i + last_issued + 1) % m_shader_config->n_simt_clusters;
@@ -1153,18 +1365,85 @@ void gpgpu_sim::issue_block2core()
     }
 }
 
+// -gpgpu_sampling: execute the CTAs of fast-forwarded units functionally as 
+// soon as they come up for issue.  Each CTA is attributed to a shader core in
+// turn for cache warming; its threads are numbered past the hardware threads 
+// of that core so its shared and local memory are not those of a running CTA.
+void gpgpu_sim::fast_forward_ctas()
+{
+    unsigned long long cycle = gpu_sim_cycle+gpu_tot_sim_cycle;
+    for (unsigned n=0; n < m_running_kernels.size(); n++) {
+        kernel_info_t *kernel = m_running_kernels[n];
+        if (kernel == NULL) 
+            continue;
+        unsigned wave_ctas = m_shader_config->max_cta(*kernel) * m_config.num_shader();
+        bool ffwd = false;
+        while (!kernel->no_more_ctas_to_run() && 
+               m_sampler->fast_forward(*kernel,wave_ctas,cycle,gpu_sim_insn+gpu_tot_sim_insn)) {
+            unsigned cta_size = kernel->threads_per_cta();
+            unsigned tid_base = (m_shader_config->n_thread_per_shader + cta_size - 1) / cta_size * cta_size;
+            functionalCoreSim cta(kernel,this,m_shader_config->warp_size,m_ffwd_sid);
+            cta.set_fast_forward(tid_base,m_config.gpgpu_sampling_warm_caches);
+            cta.execute();
+            m_sampler->add_ffwd_cta(*kernel,cta.get_n_insn());
+            m_ffwd_sid = (m_ffwd_sid + 1) % m_config.num_shader();
+            ffwd = true;
+        }
+        if (ffwd && kernel->done()) 
+            set_kernel_done(kernel);
+    }
+}
+
+void gpgpu_sim::warm_caches( warp_inst_t &inst, unsigned sid )
+{
+    unsigned time = gpu_sim_cycle+gpu_tot_sim_cycle;
+    bool is_write = inst.is_store();
+    inst.generate_mem_accesses();
+    while (!inst.accessq_empty()) {
+        const mem_access_t &access = inst.accessq_back();
+        new_addr_type addr = access.get_addr();
+        if (!is_write) 
+            m_cluster[m_shader_config->sid_to_cluster(sid)]->warm_L1D(sid,addr,time);
+        addrdec_t raw_addr;
+        m_memory_config->m_address_mapping.addrdec_tlx(addr,&raw_addr);
+        m_memory_sub_partition[raw_addr.sub_partition]->warm_L2(addr,time,is_write);
+        inst.accessq_pop_back();
+    }
+}
+
+// tasks run on m_thread_pool when -gpgpu_sim_threads > 1 
+struct parallel_core_cycle_arg {
+    simt_core_cluster **cluster;
+    const bool *active;
+};
+
+static void parallel_core_cycle( void *arg, unsigned cluster_id )
+{
+    parallel_core_cycle_arg *p = (parallel_core_cycle_arg*) arg;
+    if (p->active[cluster_id]) 
+        p->cluster[cluster_id]->core_cycle();
+    ptx_sim_flush_thread_insn_count();
+}
+
+static void parallel_cache_cycle( void *arg, unsigned sub_partition_id )
+{
+    memory_sub_partition **sub_partition = (memory_sub_partition**) arg;
+    sub_partition[sub_partition_id]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
+}
+
 unsigned long long g_single_step=0; // set this in gdb to single step the pipeline
 
 void gpgpu_sim::cycle()
 {
    int clock_mask = next_clock_domain();
+   bool skip_idle = (m_idle_skip == IDLE_SKIP_ACTIVE);
 
-   if (clock_mask & CORE ) {
+   if ((clock_mask & CORE) && !skip_idle) {
        // shader core loading (pop from ICNT into core) follows CORE clock
       for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
          m_cluster[i]->icnt_cycle(); 
    }
-    if (clock_mask & ICNT) {
+    if ((clock_mask & ICNT) && !skip_idle) {
         // pop from memory controller to interconnect
         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
             mem_fetch* mf = m_memory_sub_partition[i]->top();
@@ -1193,10 +1472,27 @@ void gpgpu_sim::cycle()
                         m_power_stats->pwr_mem_stat->n_nop[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_act[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_pre[CURRENT_STAT_IDX][i],
                         m_power_stats->pwr_mem_stat->n_rd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_wr[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_req[CURRENT_STAT_IDX][i]);
       }
+      if (skip_idle) {
+         // a reply from DRAM ends the idle period
+         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+            if (!m_memory_sub_partition[i]->dram_L2_queue_empty()) {
+               end_idle_skip();
+               skip_idle = false;
+               break;
+            }
+         }
+      }
+   }
+
+   if (skip_idle && (clock_mask & L2) && (gpu_sim_cycle+gpu_tot_sim_cycle) >= m_idle_skip_until) {
+      end_idle_skip(); // a ROP delay expires
+      skip_idle = false;
    }
 
    // L2 operations follow L2 clock domain
-   if (clock_mask & L2) {
+   if ((clock_mask & L2) && skip_idle) {
+      m_idle_skip_l2_cycles++;
+   } else if (clock_mask & L2) {
        m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
       for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
           //move memory request from interconnect into memory partition (if not backed up)
@@ -1207,20 +1503,58 @@ void gpgpu_sim::cycle()
               mem_fetch* mf = (mem_fetch*) icnt_pop( m_shader_config->mem2device(i) );
               m_memory_sub_partition[i]->push( mf, gpu_sim_cycle + gpu_tot_sim_cycle );
           }
-          m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
-          m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+          if (!m_thread_pool) {
+             m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
+             m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+          }
+       }
+       if (m_thread_pool) {
+          // sub-partitions only interact through the interconnect, which is not touched by cache_cycle()
+          m_thread_pool->run(parallel_cache_cycle, m_memory_sub_partition, m_memory_config->m_n_mem_sub_partition);
+          for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+             m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
        }
    }
 
-   if (clock_mask & ICNT) {
+   if ((clock_mask & ICNT) && !skip_idle) {
       icnt_transfer();
    }
 
-   if (clock_mask & CORE) {
+   if ((clock_mask & CORE) && skip_idle) {
+      // the cores would only update the statistics measured in the ARMED cycle
+      m_idle_skip_core_cycles++;
+      for (unsigned i=0;i<m_shader_config->num_shader();i++) 
+         m_shader_stats->shader_cycles[i] += m_idle_shader_cycles[i];
+      for (unsigned i=0;i<m_idle_shader_cycle_distro.size();i++) 
+         m_shader_stats->shader_cycle_distro[i] += m_idle_shader_cycle_distro[i];
+      *active_sms += m_idle_active_sms;
+      *average_pipeline_duty_cycle += m_idle_duty_cycle;
+   } else if (clock_mask & CORE) {
+      if (m_idle_skip == IDLE_SKIP_ARMED) {
+         // measure the statistics updated by an idle core cycle
+         m_idle_shader_cycles.assign(m_shader_stats->shader_cycles, m_shader_stats->shader_cycles+m_shader_config->num_shader());
+         m_idle_shader_cycle_distro.assign(m_shader_stats->shader_cycle_distro, m_shader_stats->shader_cycle_distro+m_shader_config->warp_size+3);
+         m_idle_active_sms = *active_sms;
+         m_idle_duty_cycle = *average_pipeline_duty_cycle;
+      }
       // L1 cache + shader core pipeline stages
       m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
+      if (m_thread_pool) {
+         // clusters only interact through state staged by simt_core_cluster 
+         // during core_cycle(); commit it in cluster order afterwards
+         bool more_cta_left = get_more_cta_left();
+         for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+            m_cluster_active[i] = m_cluster[i]->get_not_completed() || more_cta_left;
+         parallel_core_cycle_arg arg = { m_cluster, m_cluster_active };
+         m_thread_pool->run(parallel_core_cycle, &arg, m_shader_config->n_simt_clusters);
+         for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+            m_cluster[i]->commit_cycle();
+      }
       for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
-         if (m_cluster[i]->get_not_completed() || get_more_cta_left() ) {
+         if (m_thread_pool) {
+            if (m_cluster_active[i]) 
+               *active_sms+=m_cluster[i]->get_n_active_sms();
+         } else if (m_cluster[i]->get_not_completed() || get_more_cta_left() ) {
                m_cluster[i]->core_cycle();
                *active_sms+=m_cluster[i]->get_n_active_sms();
          }
@@ -1235,6 +1569,17 @@ void gpgpu_sim::cycle()
       temp=temp/m_shader_config->num_shader();
       *average_pipeline_duty_cycle=((*average_pipeline_duty_cycle)+temp);
         //cout<<"Average pipeline duty cycle: "<<*average_pipeline_duty_cycle<<endl;
+      if (m_idle_skip == IDLE_SKIP_ARMED) {
+         for (unsigned i=0;i<m_shader_config->num_shader();i++) 
+            m_idle_shader_cycles[i] = m_shader_stats->shader_cycles[i] - m_idle_shader_cycles[i];
+         for (unsigned i=0;i<m_idle_shader_cycle_distro.size();i++) 
+            m_idle_shader_cycle_distro[i] = m_shader_stats->shader_cycle_distro[i] - m_idle_shader_cycle_distro[i];
+         m_idle_active_sms = *active_sms - m_idle_active_sms;
+         m_idle_duty_cycle = *average_pipeline_duty_cycle - m_idle_duty_cycle;
+      }
+   }
+
+   if (clock_mask & CORE) {
 
 
       if( g_single_step && ((gpu_sim_cycle+gpu_tot_sim_cycle) >= g_single_step) ) {
@@ -1251,7 +1596,14 @@ void gpgpu_sim::cycle()
       }
 #endif
 
+      unsigned cta_launched = m_total_cta_launched;
       issue_block2core();
+      if (m_config.gpgpu_skip_idle_cycles) {
+         if (skip_idle && m_total_cta_launched != cta_launched) 
+            end_idle_skip();
+         else if (!skip_idle) 
+            update_idle_skip();
+      }
       
       // Depending on configuration, flush the caches once all of threads are completed.
       int all_threads_complete = 1;
@@ -1338,6 +1690,62 @@ void gpgpu_sim::cycle()
 }
 
 
+// True if no core, cluster or L2 can change state until DRAM returns data or, 
+// for the L2, until cycle next_event (when the first ROP delay expires)
+bool gpgpu_sim::waiting_on_memory( unsigned long long &next_event )
+{
+   if (g_interactive_debugger_enabled || g_single_step) 
+      return false;
+   for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+      if (m_cluster[i]->can_issue_block2core() || !m_cluster[i]->waiting_on_memory()) 
+         return false;
+   }
+   next_event = (unsigned long long)-1;
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+      if (!m_memory_sub_partition[i]->waiting_on_memory(next_event)) 
+         return false;
+   }
+   return !icnt_busy();
+}
+
+// called at the end of each simulated core cycle when -gpgpu_skip_idle_cycles is on
+void gpgpu_sim::update_idle_skip()
+{
+   unsigned long long next_event;
+   bool idle = waiting_on_memory(next_event);
+   if (!idle) {
+      m_idle_skip = IDLE_SKIP_OFF;
+   } else if (m_idle_skip == IDLE_SKIP_OFF) {
+      m_idle_skip = IDLE_SKIP_ARMED;
+   } else {
+      assert(m_idle_skip == IDLE_SKIP_ARMED);
+      m_idle_skip = IDLE_SKIP_ACTIVE;
+      m_idle_skip_until = next_event;
+      m_idle_skip_core_cycles = 0;
+      m_idle_skip_l2_cycles = 0;
+      bool more_cta_left = get_more_cta_left();
+      m_idle_cluster_active.resize(m_shader_config->n_simt_clusters);
+      for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+         m_idle_cluster_active[i] = m_cluster[i]->get_not_completed() || more_cta_left;
+   }
+}
+
+// resume simulating every clock domain; accounts for the skipped cycles in 
+// the statistics that are not updated in cycle()
+void gpgpu_sim::end_idle_skip()
+{
+   if (m_idle_skip == IDLE_SKIP_ACTIVE) {
+      for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+         if (m_idle_cluster_active[i]) 
+            m_cluster[i]->skip_idle_cycles(m_idle_skip_core_cycles);
+      }
+      for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+         m_memory_sub_partition[i]->skip_idle_cycles(m_idle_skip_l2_cycles);
+      m_total_idle_skip_cycles += m_idle_skip_core_cycles;
+   }
+   m_idle_skip = IDLE_SKIP_OFF;
+}
+
 void shader_core_ctx::dump_warp_state( FILE *fout ) const
 {
    fprintf(fout, "\n");
@@ -314,6 +314,7 @@ public:
     unsigned num_shader() const { return m_shader_config.num_shader(); }
     unsigned num_cluster() const { return m_shader_config.n_simt_clusters; }
     unsigned get_max_concurrent_kernel() const { return max_concurrent_kernel; }
+    unsigned get_sim_threads() const { return gpgpu_sim_threads; }
 
 private:
     void init_clock_domains(void ); 
@@ -344,6 +345,16 @@ private:
     int   gpgpu_cflog_interval;
     char * gpgpu_clock_domains;
     unsigned max_concurrent_kernel;
+    unsigned gpgpu_sim_threads;
+    bool  gpgpu_skip_idle_cycles;
+    unsigned gpgpu_checkpoint_kernel;
+    unsigned gpgpu_resume_kernel;
+    char *gpgpu_checkpoint_file;
+    char *gpgpu_warp_trace_record;
+    char *gpgpu_warp_trace_replay;
+    char *gpgpu_sampling;
+    unsigned gpgpu_sampling_unit;
+    bool  gpgpu_sampling_warm_caches;
 
     // visualizer
     bool  g_visualizer_enabled;
@@ -419,12 +430,35 @@ public:
     */
     simt_core_cluster * getSIMTCluster();
 
+   //! Host threads simulating the GPU in parallel, NULL if -gpgpu_sim_threads is 1
+   class sim_thread_pool *get_thread_pool() { return m_thread_pool; }
+
+   //! Warp trace being recorded or replayed, NULL unless -gpgpu_warp_trace_record/replay is set
+   class warp_trace *get_warp_trace() { return m_warp_trace; }
+
+   //! Install the lines touched by a functionally executed global memory 
+   //! instruction in the L1D of shader core sid and in the L2 (-gpgpu_sampling)
+   void warm_caches( warp_inst_t &inst, unsigned sid );
+
+   // kernel boundary checkpoints (-gpgpu_checkpoint_kernel, -gpgpu_resume_kernel): 
+   // skip_kernel() is called for every launched kernel and is true for the 
+   // kernels replaced by the restored state, 
+   // kernel_boundary() saves or restores the state before a kernel is launched
+   bool skip_kernel( const kernel_info_t &kernel );
+   void kernel_boundary( const kernel_info_t &kernel );
+
+   // device-to-host copies also go to/come from the warp trace, since global 
+   // memory does not hold the results of replayed kernels
+   virtual bool replay_readback( void *dst, size_t src_start_addr, size_t count );
+   virtual void record_readback( const void *data, size_t src_start_addr, size_t count );
+
 
 private:
    // clocks
    void reinit_clock_domains(void);
    int  next_clock_domain(void);
    void issue_block2core();
+   void fast_forward_ctas();
    void print_dram_stats(FILE *fout) const;
    void shader_print_runtime_stat( FILE *fout );
    void shader_print_l1_miss_stat( FILE *fout ) const;
@@ -435,9 +469,22 @@ private:
 
    void gpgpu_debug();
 
+   void save_checkpoint( const char *filename, unsigned kernel_uid ) const;
+   void load_checkpoint( const char *filename, unsigned kernel_uid );
+
+   // idle cycle skipping (-gpgpu_skip_idle_cycles)
+   bool waiting_on_memory( unsigned long long &next_event );
+   void update_idle_skip();
+   void end_idle_skip();
+
 ///// data /////
 
    class simt_core_cluster **m_cluster;
+   bool *m_cluster_active; // clusters simulated in the current core cycle (parallel mode)
+   class sim_thread_pool *m_thread_pool; // NULL unless -gpgpu_sim_threads > 1
+   class warp_trace *m_warp_trace;
+   class sim_sampler *m_sampler; // NULL unless -gpgpu_sampling is set
+   unsigned m_ffwd_sid; // shader core whose caches the next fast-forwarded CTA warms
    class memory_partition_unit **m_memory_partition_unit;
    class memory_sub_partition **m_memory_sub_partition;
 
@@ -449,6 +496,24 @@ private:
    unsigned m_last_cluster_issue;
    float * average_pipeline_duty_cycle;
    float * active_sms;
+
+   // -gpgpu_skip_idle_cycles: once every core and L2 is found waiting on 
+   // memory at the end of two consecutive core cycles (ARMED, then ACTIVE), 
+   // only the DRAM clock domain is simulated until a reply reaches an L2, 
+   // a ROP delay expires or a CTA is launched.  The per core cycle statistics 
+   // measured in the ARMED cycle are added for each skipped core cycle.
+   enum idle_skip_state { IDLE_SKIP_OFF, IDLE_SKIP_ARMED, IDLE_SKIP_ACTIVE };
+   enum idle_skip_state m_idle_skip;
+   unsigned long long m_idle_skip_until; // first cycle at which a ROP delay expires
+   unsigned long long m_idle_skip_core_cycles;
+   unsigned long long m_idle_skip_l2_cycles;
+   unsigned long long m_total_idle_skip_cycles;
+   std::vector<unsigned long long> m_idle_shader_cycles;
+   std::vector<unsigned> m_idle_shader_cycle_distro;
+   float m_idle_active_sms;
+   float m_idle_duty_cycle;
+   std::vector<bool> m_idle_cluster_active;
+
    // time of next rising edge 
    double core_time;
    double icnt_time;
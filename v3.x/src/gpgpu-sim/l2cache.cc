@@ -44,6 +44,7 @@
 #include "shader.h"
 #include "mem_latency_stat.h"
 #include "l2cache_trace.h"
+#include "../checkpoint.h"
 
 
 mem_fetch * partition_mf_allocator::alloc(new_addr_type addr, mem_access_type type, unsigned size, bool wr ) const 
@@ -292,6 +293,17 @@ void memory_partition_unit::print( FILE *fp ) const
     m_dram->print(fp); 
 }
 
+// DRAM state only: the sub-partitions are saved individually by gpgpu_sim
+void memory_partition_unit::checkpoint( FILE *fp ) const
+{
+    m_dram->checkpoint(fp);
+}
+
+void memory_partition_unit::restore( FILE *fp )
+{
+    m_dram->restore(fp);
+}
+
 memory_sub_partition::memory_sub_partition( unsigned sub_partition_id, 
                                             const struct memory_config *config,
                                             class memory_stats_t *stats )
@@ -379,7 +391,7 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
             bool output_full = m_L2_icnt_queue->full(); 
             bool port_free = m_L2cache->data_port_free(); 
             if ( !output_full && port_free ) {
-                std::list<cache_event> events;
+                cache_event_list events;
                 enum cache_request_status status = m_L2cache->access(mf->get_addr(),mf,gpu_sim_cycle+gpu_tot_sim_cycle,events);
                 bool write_sent = was_write_sent(events);
                 bool read_sent = was_read_sent(events);
@@ -427,6 +439,37 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
     }
 }
 
+bool memory_sub_partition::waiting_on_memory( unsigned long long &next_event ) const
+{
+    if( !m_icnt_L2_queue->empty() || !m_dram_L2_queue->empty() || !m_L2_icnt_queue->empty() ) 
+        return false;
+    if( !m_config->m_L2_config.disabled() && !m_L2cache->idle() ) 
+        return false;
+    if( !m_rop.empty() && m_rop.front().ready_cycle < next_event ) 
+        next_event = m_rop.front().ready_cycle;
+    return true;
+}
+
+void memory_sub_partition::skip_idle_cycles( unsigned long long n )
+{
+    if( !m_config->m_L2_config.disabled() ) 
+        m_L2cache->skip_idle_cycles(n);
+}
+
+void memory_sub_partition::checkpoint( FILE *fp ) const
+{
+    checkpoint_write_section(fp,"L2SP",m_id);
+    if( !m_config->m_L2_config.disabled() ) 
+        m_L2cache->checkpoint(fp);
+}
+
+void memory_sub_partition::restore( FILE *fp )
+{
+    checkpoint_read_section(fp,"L2SP",m_id);
+    if( !m_config->m_L2_config.disabled() ) 
+        m_L2cache->restore(fp);
+}
+
 bool memory_sub_partition::full() const
 {
     return m_icnt_L2_queue->full();
@@ -447,6 +490,11 @@ void memory_sub_partition::L2_dram_queue_pop()
    m_L2_dram_queue->pop(); 
 }
 
+bool memory_sub_partition::dram_L2_queue_empty() const
+{
+   return m_dram_L2_queue->empty(); 
+}
+
 bool memory_sub_partition::dram_L2_queue_full() const
 {
    return m_dram_L2_queue->full(); 
@@ -535,6 +583,12 @@ unsigned memory_sub_partition::flushL2()
     return 0; // L2 is read only in this version
 }
 
+void memory_sub_partition::warm_L2( new_addr_type addr, unsigned time, bool is_write )
+{
+    if (!m_config->m_L2_config.disabled()) 
+        m_L2cache->warm(addr,time,is_write);
+}
+
 bool memory_sub_partition::busy() const 
 {
     return !m_request_tracker.empty();
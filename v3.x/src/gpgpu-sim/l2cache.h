@@ -72,6 +72,8 @@ public:
    void print_stat( FILE *fp ) { m_dram->print_stat(fp); }
    void visualize() const { m_dram->visualize(); }
    void print( FILE *fp ) const;
+   void checkpoint( FILE *fp ) const;
+   void restore( FILE *fp );
 
    class memory_sub_partition * get_sub_partition(int sub_partition_id) 
    {
@@ -153,6 +155,14 @@ public:
 
    void cache_cycle( unsigned cycle );
 
+   // for -gpgpu_skip_idle_cycles: true if cache_cycle() has nothing to do 
+   // before cycle next_event (left unchanged if it is only waiting on DRAM)
+   bool waiting_on_memory( unsigned long long &next_event ) const;
+   void skip_idle_cycles( unsigned long long n );
+   // L2 contents at a kernel boundary (-gpgpu_checkpoint_kernel, -gpgpu_resume_kernel)
+   void checkpoint( FILE *fp ) const;
+   void restore( FILE *fp );
+
    bool full() const;
    void push( class mem_fetch* mf, unsigned long long clock_cycle );
    class mem_fetch* pop(); 
@@ -160,6 +170,7 @@ public:
    void set_done( mem_fetch *mf );
 
    unsigned flushL2();
+   void warm_L2( new_addr_type addr, unsigned time, bool is_write ); // functional fill, no traffic
 
    // interface to L2_dram_queue
    bool L2_dram_queue_empty() const; 
@@ -167,6 +178,7 @@ public:
    void L2_dram_queue_pop(); 
 
    // interface to dram_L2_queue
+   bool dram_L2_queue_empty() const; 
    bool dram_L2_queue_full() const; 
    void dram_L2_queue_push( class mem_fetch* mf ); 
 
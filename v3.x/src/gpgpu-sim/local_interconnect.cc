@@ -0,0 +1,276 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "local_interconnect.h"
+#include <assert.h>
+#include <stdlib.h>
+#include "../option_parser.h"
+
+void local_icnt_config::reg_options( class OptionParser *opp )
+{
+   option_parser_register(opp, "-icnt_subnets", OPT_UINT32, &subnets,
+                          "local crossbar (-network_mode 2): 1 = requests and replies share one crossbar, 2 = separate crossbars",
+                          "2");
+   option_parser_register(opp, "-icnt_latency", OPT_UINT32, &latency,
+                          "local crossbar: cycles between serialization of a packet and its ejection",
+                          "8");
+   option_parser_register(opp, "-icnt_flit_size", OPT_UINT32, &flit_size,
+                          "local crossbar: flit size in bytes",
+                          "32");
+   option_parser_register(opp, "-icnt_port_bandwidth", OPT_UINT32, &port_bandwidth,
+                          "local crossbar: flits per cycle through each input and output port",
+                          "1");
+   option_parser_register(opp, "-icnt_in_buffer_limit", OPT_UINT32, &in_buffer_limit,
+                          "local crossbar: input buffer size in flits",
+                          "64");
+   option_parser_register(opp, "-icnt_out_buffer_limit", OPT_UINT32, &out_buffer_limit,
+                          "local crossbar: output buffer size in flits",
+                          "64");
+}
+
+xbar_router::xbar_router( unsigned subnet, unsigned n_nodes, const local_icnt_config &config )
+   : m_subnet(subnet), m_n_nodes(n_nodes), m_config(config)
+{
+   m_in_buffers.resize(n_nodes);
+   m_out_buffers.resize(n_nodes);
+   m_in_flits.resize(n_nodes,0);
+   m_out_flits.resize(n_nodes,0);
+   m_in_free_time.resize(n_nodes,0);
+   m_out_free_time.resize(n_nodes,0);
+   m_grant_ptr.resize(n_nodes,0);
+   m_request.resize(n_nodes,0);
+   m_n_requests.resize(n_nodes,0);
+   m_requested_outputs.reserve(n_nodes);
+   m_packets_in_flight = 0;
+}
+
+bool xbar_router::has_buffer( unsigned input, unsigned n_flits ) const
+{
+   return m_in_flits[input] + n_flits <= m_config.in_buffer_limit;
+}
+
+void xbar_router::push( unsigned input, unsigned output, void *data, unsigned n_flits, unsigned long long time )
+{
+   assert(has_buffer(input,n_flits));
+   packet p;
+   p.data = data;
+   p.output = output;
+   p.n_flits = n_flits;
+   p.push_time = time;
+   p.ready_time = 0;
+   m_in_buffers[input].push_back(p);
+   m_in_flits[input] += n_flits;
+   m_packets_in_flight++;
+   m_stats.flits += n_flits;
+   m_overall_stats.flits += n_flits;
+}
+
+void *xbar_router::pop( unsigned output, unsigned long long time )
+{
+   std::deque<packet> &buf = m_out_buffers[output];
+   if( buf.empty() || buf.front().ready_time > time )
+      return NULL;
+   const packet &p = buf.front();
+   void *data = p.data;
+   unsigned long long latency = time - p.push_time;
+   m_out_flits[output] -= p.n_flits;
+   buf.pop_front();
+   m_packets_in_flight--;
+
+   m_stats.packets++;
+   m_stats.total_latency += latency;
+   if( latency > m_stats.max_latency ) m_stats.max_latency = latency;
+   m_overall_stats.packets++;
+   m_overall_stats.total_latency += latency;
+   if( latency > m_overall_stats.max_latency ) m_overall_stats.max_latency = latency;
+   return data;
+}
+
+void xbar_router::advance( unsigned long long time )
+{
+   // requests: the head packet of every idle input asks for its output if that
+   // output is idle and has room; each output keeps the requester closest to
+   // its grant pointer
+   m_requested_outputs.clear();
+   for( unsigned i=0; i < m_n_nodes; i++ ) {
+      if( m_in_buffers[i].empty() || m_in_free_time[i] > time )
+         continue;
+      const packet &p = m_in_buffers[i].front();
+      unsigned o = p.output;
+      if( m_out_free_time[o] > time || m_out_flits[o] + p.n_flits > m_config.out_buffer_limit )
+         continue;
+      if( m_n_requests[o]++ == 0 ) {
+         m_request[o] = i;
+         m_requested_outputs.push_back(o);
+      } else {
+         unsigned ptr = m_grant_ptr[o];
+         if( (i + m_n_nodes - ptr) % m_n_nodes < (m_request[o] + m_n_nodes - ptr) % m_n_nodes )
+            m_request[o] = i;
+      }
+   }
+
+   // grants: an input requests a single output, so every grant is accepted
+   for( std::vector<unsigned>::const_iterator it=m_requested_outputs.begin(); it != m_requested_outputs.end(); ++it ) {
+      unsigned o = *it;
+      unsigned i = m_request[o];
+      m_stats.conflicts += m_n_requests[o] - 1;
+      m_overall_stats.conflicts += m_n_requests[o] - 1;
+      m_n_requests[o] = 0;
+
+      packet p = m_in_buffers[i].front();
+      m_in_buffers[i].pop_front();
+      m_in_flits[i] -= p.n_flits;
+
+      unsigned serialization = (p.n_flits + m_config.port_bandwidth - 1) / m_config.port_bandwidth;
+      m_in_free_time[i] = time + serialization;
+      m_out_free_time[o] = time + serialization;
+      p.ready_time = time + serialization + m_config.latency;
+      m_out_flits[o] += p.n_flits;
+      m_out_buffers[o].push_back(p);
+      m_grant_ptr[o] = (i + 1) % m_n_nodes;
+   }
+}
+
+void xbar_router::clear_stats()
+{
+   m_stats.clear();
+}
+
+void xbar_router::display_stats( FILE *fp, bool overall ) const
+{
+   const xbar_stats &s = overall? m_overall_stats : m_stats;
+   fprintf(fp, "Local crossbar subnet %u: packets = %llu, flits = %llu, avg latency = %.4f, max latency = %llu, arbitration conflicts = %llu\n",
+           m_subnet, s.packets, s.flits, s.packets? (double)s.total_latency / s.packets : 0.0,
+           s.max_latency, s.conflicts );
+}
+
+void xbar_router::display_state( FILE *fp ) const
+{
+   fprintf(fp, "Local crossbar subnet %u: %u packets in flight\n", m_subnet, m_packets_in_flight );
+   for( unsigned n=0; n < m_n_nodes; n++ ) {
+      if( !m_in_buffers[n].empty() )
+         fprintf(fp, "   input %u: %zu packets (%u flits), head to output %u\n",
+                 n, m_in_buffers[n].size(), m_in_flits[n], m_in_buffers[n].front().output );
+      if( !m_out_buffers[n].empty() )
+         fprintf(fp, "   output %u: %zu packets (%u flits)\n", n, m_out_buffers[n].size(), m_out_flits[n] );
+   }
+}
+
+local_interconnect::local_interconnect( const local_icnt_config &config )
+   : m_config(config)
+{
+   m_n_shader = 0;
+   m_n_mem = 0;
+   m_time = 0;
+}
+
+local_interconnect::~local_interconnect()
+{
+   for( unsigned s=0; s < m_subnets.size(); s++ )
+      delete m_subnets[s];
+}
+
+void local_interconnect::create( unsigned n_shader, unsigned n_mem )
+{
+   if( m_config.subnets < 1 || m_config.subnets > 2 ) {
+      printf("GPGPU-Sim uArch: ERROR ** -icnt_subnets must be 1 or 2 (got %u)\n", m_config.subnets);
+      abort();
+   }
+   if( !m_config.latency || !m_config.flit_size || !m_config.port_bandwidth
+       || !m_config.in_buffer_limit || !m_config.out_buffer_limit ) {
+      printf("GPGPU-Sim uArch: ERROR ** local crossbar latency, flit size, port bandwidth and buffer limits must be non-zero\n");
+      abort();
+   }
+   if( m_config.out_buffer_limit < m_config.in_buffer_limit ) {
+      // a packet that fits the input buffer must also fit an empty output buffer
+      printf("GPGPU-Sim uArch: ERROR ** -icnt_out_buffer_limit (%u) must be at least -icnt_in_buffer_limit (%u)\n",
+             m_config.out_buffer_limit, m_config.in_buffer_limit);
+      abort();
+   }
+   m_n_shader = n_shader;
+   m_n_mem = n_mem;
+   for( unsigned s=0; s < m_config.subnets; s++ )
+      m_subnets.push_back( new xbar_router(s, n_shader + n_mem, m_config) );
+}
+
+void local_interconnect::init()
+{
+   for( unsigned s=0; s < m_subnets.size(); s++ )
+      m_subnets[s]->clear_stats();
+}
+
+bool local_interconnect::has_buffer( unsigned input, unsigned size ) const
+{
+   return m_subnets[push_subnet(input)]->has_buffer(input, n_flits(size));
+}
+
+void local_interconnect::push( unsigned input, unsigned output, void *data, unsigned size )
+{
+   m_subnets[push_subnet(input)]->push(input, output, data, n_flits(size), m_time);
+}
+
+void *local_interconnect::pop( unsigned output )
+{
+   return m_subnets[pop_subnet(output)]->pop(output, m_time);
+}
+
+void local_interconnect::advance()
+{
+   for( unsigned s=0; s < m_subnets.size(); s++ ) {
+      if( m_subnets[s]->busy() )
+         m_subnets[s]->advance(m_time);
+   }
+   m_time++;
+}
+
+bool local_interconnect::busy() const
+{
+   for( unsigned s=0; s < m_subnets.size(); s++ ) {
+      if( m_subnets[s]->busy() )
+         return true;
+   }
+   return false;
+}
+
+void local_interconnect::display_stats() const
+{
+   for( unsigned s=0; s < m_subnets.size(); s++ )
+      m_subnets[s]->display_stats(stdout, false);
+}
+
+void local_interconnect::display_overall_stats() const
+{
+   printf("Local crossbar: %llu cycles\n", m_time);
+   for( unsigned s=0; s < m_subnets.size(); s++ )
+      m_subnets[s]->display_stats(stdout, true);
+}
+
+void local_interconnect::display_state( FILE *fp ) const
+{
+   for( unsigned s=0; s < m_subnets.size(); s++ )
+      m_subnets[s]->display_state(fp);
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef LOCAL_INTERCONNECT_H
+#define LOCAL_INTERCONNECT_H
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+
+// Analytical crossbar between the SIMT core clusters and the memory
+// sub-partitions (-network_mode 2). Each subnet is a single crossbar with
+// one FIFO input buffer per node; every icnt cycle each free output grants
+// one of the inputs whose head packet targets it (one iSLIP iteration with
+// round robin grant pointers). A packet of n flits occupies its input and
+// output port for ceil(n/port_bandwidth) cycles and can be popped
+// icnt_latency cycles after it has been serialized. Buffer limits are in
+// flits and icnt_has_buffer() reports the space left in the input buffer.
+
+struct local_icnt_config {
+   void reg_options( class OptionParser *opp );
+
+   unsigned subnets;         // 1 = shared, 2 = separate request and reply crossbars
+   unsigned latency;         // cycles from serialization to ejection
+   unsigned flit_size;       // bytes
+   unsigned port_bandwidth;  // flits per cycle per port
+   unsigned in_buffer_limit; // flits per input port
+   unsigned out_buffer_limit;// flits per output port (includes packets in flight)
+};
+
+class xbar_router {
+public:
+   xbar_router( unsigned subnet, unsigned n_nodes, const local_icnt_config &config );
+
+   bool has_buffer( unsigned input, unsigned n_flits ) const;
+   void push( unsigned input, unsigned output, void *data, unsigned n_flits, unsigned long long time );
+   void *pop( unsigned output, unsigned long long time );
+   void advance( unsigned long long time );
+   bool busy() const { return m_packets_in_flight > 0; }
+
+   void clear_stats();
+   void display_stats( FILE *fp, bool overall ) const;
+   void display_state( FILE *fp ) const;
+
+private:
+   struct packet {
+      void *data;
+      unsigned output;
+      unsigned n_flits;
+      unsigned long long push_time;
+      unsigned long long ready_time; // earliest cycle the packet may be popped
+   };
+   struct xbar_stats {
+      xbar_stats() { clear(); }
+      void clear() { packets=0; flits=0; total_latency=0; max_latency=0; conflicts=0; }
+      unsigned long long packets;
+      unsigned long long flits;
+      unsigned long long total_latency;
+      unsigned long long max_latency;
+      unsigned long long conflicts; // requests that lost output arbitration
+   };
+
+   unsigned m_subnet;
+   unsigned m_n_nodes;
+   const local_icnt_config &m_config;
+
+   std::vector<std::deque<packet> > m_in_buffers;
+   std::vector<std::deque<packet> > m_out_buffers;
+   std::vector<unsigned> m_in_flits;     // flits waiting in each input buffer
+   std::vector<unsigned> m_out_flits;    // flits granted to each output and not yet popped
+   std::vector<unsigned long long> m_in_free_time;  // first cycle each port is not serializing
+   std::vector<unsigned long long> m_out_free_time;
+   std::vector<unsigned> m_grant_ptr;    // round robin priority pointer of each output
+
+   // per-cycle arbitration scratch: best requesting input of each output
+   // and the list of outputs that received a request
+   std::vector<unsigned> m_request;
+   std::vector<unsigned> m_requested_outputs;
+   std::vector<unsigned> m_n_requests;
+
+   unsigned m_packets_in_flight;
+
+   xbar_stats m_stats;
+   xbar_stats m_overall_stats;
+};
+
+class local_interconnect {
+public:
+   local_interconnect( const local_icnt_config &config );
+   ~local_interconnect();
+
+   void create( unsigned n_shader, unsigned n_mem );
+   void init();
+   bool has_buffer( unsigned input, unsigned size ) const;
+   void push( unsigned input, unsigned output, void *data, unsigned size );
+   void *pop( unsigned output );
+   void advance();
+   bool busy() const;
+   void display_stats() const;
+   void display_overall_stats() const;
+   void display_state( FILE *fp ) const;
+   unsigned get_flit_size() const { return m_config.flit_size; }
+
+private:
+   unsigned n_flits( unsigned size ) const { return (size + m_config.flit_size - 1) / m_config.flit_size; }
+   // requests from the shaders use subnet 0, replies from memory use the last subnet
+   unsigned push_subnet( unsigned input ) const { return (input < m_n_shader)? 0 : m_subnets.size()-1; }
+   unsigned pop_subnet( unsigned output ) const { return (output < m_n_shader)? m_subnets.size()-1 : 0; }
+
+   const local_icnt_config &m_config;
+   unsigned m_n_shader, m_n_mem;
+   std::vector<xbar_router*> m_subnets;
+   unsigned long long m_time;
+};
+
+#endif
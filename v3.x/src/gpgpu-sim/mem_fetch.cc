@@ -30,22 +30,129 @@
 #include "shader.h"
 #include "visualizer.h"
 #include "gpu-sim.h"
+#include <pthread.h>
+#include <vector>
 
 unsigned mem_fetch::sm_next_mf_request_uid=1;
+const warp_inst_t mem_fetch::sm_empty_inst;
+
+// Freed mem_fetch objects go on a free list of the freeing host thread. 
+// Requests are often created on one thread (a SIMT core cluster simulated by
+// a pool thread) and deleted on another (DRAM and L2 run on the main 
+// thread), so a thread that accumulates more than 2*MEM_FETCH_POOL_CHUNK 
+// free objects moves a batch of MEM_FETCH_POOL_CHUNK to a shared depot, and
+// a thread whose list runs dry takes a batch from the depot before it 
+// allocates a new chunk.
+#define MEM_FETCH_POOL_CHUNK 256
+
+struct mem_fetch_free_node {
+   mem_fetch_free_node *m_next;
+   mem_fetch_free_node *m_next_batch; // valid in the first node of a depot batch
+};
+
+// per host thread free list and live counts; print_live() adds the counts 
+// of all threads (a thread's count goes negative when it deletes requests 
+// created elsewhere)
+struct mem_fetch_thread_state {
+   mem_fetch_thread_state() 
+   {
+      m_free_list = NULL;
+      m_num_free = 0;
+      memset(m_num_live,0,sizeof(m_num_live));
+   }
+   mem_fetch_free_node *m_free_list;
+   unsigned m_num_free;
+   long long m_num_live[NUM_MEM_REQ_STAT];
+   char m_pad[64]; // keeps the states of different threads on separate cache lines
+};
+
+static __thread mem_fetch_thread_state *t_mem_fetch_state = NULL;
+static std::vector<mem_fetch_thread_state*> g_mem_fetch_states;
+static mem_fetch_free_node *g_mem_fetch_depot = NULL;
+static pthread_mutex_t g_mem_fetch_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static mem_fetch_thread_state *mem_fetch_state()
+{
+   if( t_mem_fetch_state == NULL ) {
+      // never freed: the states of exited threads still hold live counts
+      t_mem_fetch_state = new mem_fetch_thread_state();
+      pthread_mutex_lock(&g_mem_fetch_pool_lock);
+      g_mem_fetch_states.push_back(t_mem_fetch_state);
+      pthread_mutex_unlock(&g_mem_fetch_pool_lock);
+   }
+   return t_mem_fetch_state;
+}
+
+void *mem_fetch::operator new( size_t size )
+{
+   assert( size == sizeof(mem_fetch) );
+   mem_fetch_thread_state *t = mem_fetch_state();
+   if( t->m_free_list == NULL ) {
+      pthread_mutex_lock(&g_mem_fetch_pool_lock);
+      mem_fetch_free_node *batch = g_mem_fetch_depot;
+      if( batch ) 
+         g_mem_fetch_depot = batch->m_next_batch;
+      pthread_mutex_unlock(&g_mem_fetch_pool_lock);
+      if( batch ) {
+         t->m_free_list = batch;
+         t->m_num_free = MEM_FETCH_POOL_CHUNK;
+      } else {
+         // chunks are never returned to the heap
+         char *chunk = (char*)malloc(MEM_FETCH_POOL_CHUNK*sizeof(mem_fetch));
+         assert( chunk != NULL );
+         for( unsigned n=0; n < MEM_FETCH_POOL_CHUNK; n++ ) {
+            mem_fetch_free_node *node = (mem_fetch_free_node*)(chunk + n*sizeof(mem_fetch));
+            node->m_next = t->m_free_list;
+            t->m_free_list = node;
+         }
+         t->m_num_free = MEM_FETCH_POOL_CHUNK;
+      }
+   }
+   mem_fetch_free_node *node = t->m_free_list;
+   t->m_free_list = node->m_next;
+   t->m_num_free--;
+   return node;
+}
+
+void mem_fetch::operator delete( void *p )
+{
+   if( p == NULL ) 
+      return;
+   mem_fetch_thread_state *t = mem_fetch_state();
+   mem_fetch_free_node *node = (mem_fetch_free_node*)p;
+   node->m_next = t->m_free_list;
+   t->m_free_list = node;
+   t->m_num_free++;
+   if( t->m_num_free > 2*MEM_FETCH_POOL_CHUNK ) {
+      // hand the most recently freed MEM_FETCH_POOL_CHUNK objects to the depot
+      mem_fetch_free_node *batch = t->m_free_list;
+      mem_fetch_free_node *last = batch;
+      for( unsigned n=1; n < MEM_FETCH_POOL_CHUNK; n++ ) 
+         last = last->m_next;
+      t->m_free_list = last->m_next;
+      t->m_num_free -= MEM_FETCH_POOL_CHUNK;
+      last->m_next = NULL;
+      pthread_mutex_lock(&g_mem_fetch_pool_lock);
+      batch->m_next_batch = g_mem_fetch_depot;
+      g_mem_fetch_depot = batch;
+      pthread_mutex_unlock(&g_mem_fetch_pool_lock);
+   }
+}
 
 mem_fetch::mem_fetch( const mem_access_t &access, 
-                      const warp_inst_t *inst,
+                      mem_fetch_inst *inst,
                       unsigned ctrl_size, 
                       unsigned wid,
                       unsigned sid, 
                       unsigned tpc, 
                       const class memory_config *config )
 {
-   m_request_uid = sm_next_mf_request_uid++;
+   m_request_uid = __sync_fetch_and_add(&sm_next_mf_request_uid,1);
    m_access = access;
+   m_inst = inst;
    if( inst ) { 
-       m_inst = *inst;
-       assert( wid == m_inst.warp_id() );
+       inst->add_ref();
+       assert( wid == inst->inst().warp_id() );
    }
    m_data_size = access.get_size();
    m_ctrl_size = ctrl_size;
@@ -59,13 +166,17 @@ mem_fetch::mem_fetch( const mem_access_t &access,
    m_timestamp2 = 0;
    m_status = MEM_FETCH_INITIALIZED;
    m_status_change = gpu_sim_cycle + gpu_tot_sim_cycle;
+   mem_fetch_state()->m_num_live[m_status]++;
    m_mem_config = config;
    icnt_flit_size = config->icnt_flit_size;
 }
 
 mem_fetch::~mem_fetch()
 {
+    mem_fetch_state()->m_num_live[m_status]--;
     m_status = MEM_FETCH_DELETED;
+    if( m_inst ) 
+        m_inst->release();
 }
 
 #define MF_TUP_BEGIN(X) static const char* Status_str[] = {
@@ -88,37 +199,75 @@ void mem_fetch::print( FILE *fp, bool print_inst ) const
        fprintf(fp," status = %s (%llu), ", Status_str[m_status], m_status_change );
     else
        fprintf(fp," status = %u??? (%llu), ", m_status, m_status_change );
-    if( !m_inst.empty() && print_inst ) m_inst.print(fp);
+    if( m_inst && print_inst ) m_inst->inst().print(fp);
     else fprintf(fp,"\n");
 }
 
+// the sums are taken between cycles, when no other thread allocates or 
+// frees requests
+static void mem_fetch_sum_live( long long num_live[NUM_MEM_REQ_STAT] )
+{
+    memset(num_live,0,NUM_MEM_REQ_STAT*sizeof(long long));
+    pthread_mutex_lock(&g_mem_fetch_pool_lock);
+    for( unsigned t=0; t < g_mem_fetch_states.size(); t++ ) {
+        for( unsigned s=0; s < NUM_MEM_REQ_STAT; s++ ) 
+            num_live[s] += g_mem_fetch_states[t]->m_num_live[s];
+    }
+    pthread_mutex_unlock(&g_mem_fetch_pool_lock);
+}
+
+unsigned mem_fetch::num_live()
+{
+    long long num_live[NUM_MEM_REQ_STAT];
+    mem_fetch_sum_live(num_live);
+    long long total = 0;
+    for( unsigned s=0; s < NUM_MEM_REQ_STAT; s++ ) 
+        total += num_live[s];
+    return total;
+}
+
+void mem_fetch::print_live( FILE *fp )
+{
+    long long num_live[NUM_MEM_REQ_STAT];
+    mem_fetch_sum_live(num_live);
+    fprintf(fp,"GPGPU-Sim uArch: %u mem_fetch objects allocated\n", mem_fetch::num_live() );
+    for( unsigned s=0; s < NUM_MEM_REQ_STAT; s++ ) {
+        if( num_live[s] ) 
+            fprintf(fp,"GPGPU-Sim uArch:    %-32s = %lld\n", Status_str[s], num_live[s] );
+    }
+}
+
 void mem_fetch::set_status( enum mem_fetch_status status, unsigned long long cycle ) 
 {
+    mem_fetch_thread_state *t = mem_fetch_state();
+    t->m_num_live[m_status]--;
+    t->m_num_live[status]++;
     m_status = status;
     m_status_change = cycle;
 }
 
 bool mem_fetch::isatomic() const
 {
-   if( m_inst.empty() ) return false;
-   return m_inst.isatomic();
+   if( m_inst == NULL ) return false;
+   return m_inst->inst().isatomic();
 }
 
 void mem_fetch::do_atomic()
 {
-    m_inst.do_atomic( m_access.get_warp_mask() );
+    m_inst->inst().do_atomic( m_access.get_warp_mask() );
 }
 
 bool mem_fetch::istexture() const
 {
-    if( m_inst.empty() ) return false;
-    return m_inst.space.get_type() == tex_space;
+    if( m_inst == NULL ) return false;
+    return m_inst->inst().space.get_type() == tex_space;
 }
 
 bool mem_fetch::isconst() const
 { 
-    if( m_inst.empty() ) return false;
-    return (m_inst.space.get_type() == const_space) || (m_inst.space.get_type() == param_space_kernel);
+    if( m_inst == NULL ) return false;
+    const warp_inst_t &inst = m_inst->inst();
+    return (inst.space.get_type() == const_space) || (inst.space.get_type() == param_space_kernel);
 }
 
 /// Returns number of flits traversing interconnect. simt_to_mem specifies the direction
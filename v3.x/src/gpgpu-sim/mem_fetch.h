@@ -47,10 +47,25 @@ enum mf_type {
 #undef MF_TUP
 #undef MF_TUP_END
 
+// Copy of the instruction that generated a set of memory requests.  It is 
+// shared by those requests and freed when the last reference is released.
+class mem_fetch_inst {
+public:
+   mem_fetch_inst( const warp_inst_t &inst ) : m_inst(inst), m_refs(1) {}
+
+   void add_ref() { __sync_fetch_and_add(&m_refs,1); }
+   void release() { if( __sync_sub_and_fetch(&m_refs,1) == 0 ) delete this; }
+   warp_inst_t &inst() { return m_inst; }
+
+private:
+   warp_inst_t m_inst;
+   unsigned m_refs;
+};
+
 class mem_fetch {
 public:
     mem_fetch( const mem_access_t &access, 
-               const warp_inst_t *inst,
+               mem_fetch_inst *inst,
                unsigned ctrl_size, 
                unsigned wid,
                unsigned sid, 
@@ -58,6 +73,14 @@ public:
                const class memory_config *config );
    ~mem_fetch();
 
+   // mem_fetch objects are recycled through per host thread free lists
+   static void *operator new( size_t size );
+   static void operator delete( void *p );
+
+   // number of mem_fetch objects currently allocated, in total and per status
+   static unsigned num_live();
+   static void print_live( FILE *fp );
+
    void set_status( enum mem_fetch_status status, unsigned long long cycle );
    void set_reply() 
    { 
@@ -104,14 +127,17 @@ public:
    const active_mask_t& get_access_warp_mask() const { return m_access.get_warp_mask(); }
    mem_access_byte_mask_t get_access_byte_mask() const { return m_access.get_byte_mask(); }
 
-   address_type get_pc() const { return m_inst.empty()?-1:m_inst.pc; }
-   const warp_inst_t &get_inst() { return m_inst; }
+   address_type get_pc() const { return m_inst?m_inst->inst().pc:-1; }
+   const warp_inst_t &get_inst() { return m_inst?m_inst->inst():sm_empty_inst; }
    enum mem_fetch_status get_status() const { return m_status; }
 
    const memory_config *get_mem_config(){return m_mem_config;}
 
    unsigned get_num_flits(bool simt_to_mem);
 private:
+   mem_fetch( const mem_fetch &another ); // not copyable, m_inst is reference counted
+   mem_fetch &operator=( const mem_fetch &another );
+
    // request source information
    unsigned m_request_uid;
    unsigned m_sid;
@@ -135,10 +161,11 @@ private:
    unsigned m_timestamp2; // set to gpu_sim_cycle+gpu_tot_sim_cycle when pushed onto icnt to shader; only used for reads
    unsigned m_icnt_receive_time; // set to gpu_sim_cycle + interconnect_latency when fixed icnt latency mode is enabled
 
-   // requesting instruction (put last so mem_fetch prints nicer in gdb)
-   warp_inst_t m_inst;
+   // requesting instruction, NULL if the request was not generated by one
+   mem_fetch_inst *m_inst;
 
    static unsigned sm_next_mf_request_uid;
+   static const warp_inst_t sm_empty_inst;
 
    const class memory_config *m_mem_config;
    unsigned icnt_flit_size;
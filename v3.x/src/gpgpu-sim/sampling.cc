@@ -0,0 +1,310 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "sampling.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+sim_sampler::sim_sampler( const char *spec, unsigned unit_ctas )
+{
+   m_period = 1;
+   m_threshold = 0;
+   m_unit_ctas = unit_ctas;
+   m_window_open = false;
+   m_n_detailed_units = 0;
+   m_n_ffwd_units = 0;
+   m_n_ffwd_ctas = 0;
+   m_ffwd_insn = 0;
+
+   bool ok = true;
+   if( !strncmp(spec,"periodic:",9) ) {
+      m_mode = PERIODIC;
+      m_period = strtoul(spec+9,NULL,0);
+      ok = m_period > 0;
+   } else if( !strncmp(spec,"units:",6) ) {
+      m_mode = UNIT_LIST;
+      const char *p = spec+6;
+      while( ok && *p ) {
+         char *end;
+         unsigned first = strtoul(p,&end,0);
+         unsigned last = first;
+         ok = end != p;
+         if( ok && *end == '-' ) {
+            p = end+1;
+            last = strtoul(p,&end,0);
+            ok = end != p && last >= first;
+         }
+         m_units.push_back( std::make_pair(first,last) );
+         p = end;
+         if( ok && *p ) 
+            ok = *p++ == ',' && *p;
+      }
+      ok = ok && !m_units.empty();
+   } else if( !strncmp(spec,"bbv:",4) ) {
+      m_mode = BBV;
+      char *end;
+      m_threshold = strtod(spec+4,&end);
+      ok = end != spec+4 && !*end && m_threshold >= 0;
+      if( ok && !enable_ptx_file_line_stats ) {
+         printf("GPGPU-Sim uArch: ERROR ** -gpgpu_sampling bbv needs -enable_ptx_file_line_stats 1\n");
+         abort();
+      }
+   } else {
+      ok = false;
+   }
+   if( !ok ) {
+      printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_sampling \"%s\" (expected periodic:P, units:LIST or bbv:T)\n", spec);
+      abort();
+   }
+}
+
+bool sim_sampler::detailed_unit( const kernel_state_t &k ) const
+{
+   switch( m_mode ) {
+   case PERIODIC: return (k.unit % m_period) == 0;
+   case UNIT_LIST: 
+      for( unsigned i=0; i < m_units.size(); i++ ) {
+         if( k.unit >= m_units[i].first && k.unit <= m_units[i].second ) 
+            return true;
+      }
+      return false;
+   case BBV: return k.unit == 0 || k.new_phase;
+   }
+   return true;
+}
+
+bool sim_sampler::fast_forward( const kernel_info_t &kernel, unsigned wave_ctas, 
+                                unsigned long long cycle, unsigned long long insn )
+{
+   std::map<unsigned,kernel_state_t>::iterator i = m_kernels.find(kernel.get_uid());
+   if( i == m_kernels.end() ) {
+      kernel_state_t &k = m_kernels[kernel.get_uid()];
+      k.unit = (unsigned)-1;
+      k.unit_ctas = m_unit_ctas? m_unit_ctas : (wave_ctas? wave_ctas : 1);
+      k.ffwd = false;
+      k.new_phase = false;
+      k.unit_ffwd_insn = 0;
+      i = m_kernels.find(kernel.get_uid());
+   }
+   kernel_state_t &k = i->second;
+
+   dim3 id = kernel.get_next_cta_id();
+   dim3 grid = kernel.get_grid_dim();
+   unsigned unit = (id.x + grid.x*(id.y + grid.y*id.z)) / k.unit_ctas;
+   if( unit != k.unit ) {
+      if( k.unit != (unsigned)-1 ) 
+         end_unit(k,cycle,insn);
+      k.unit = unit;
+      k.ffwd = !detailed_unit(k);
+      k.new_phase = false;
+      k.unit_ffwd_insn = 0;
+      if( k.ffwd ) {
+         m_n_ffwd_units++;
+         if( m_mode == BBV ) 
+            ptx_file_line_stats_get_exec_counts(k.unit_start_counts);
+      } else {
+         m_n_detailed_units++;
+         close_window(cycle,insn);
+         window_t w;
+         w.start_cycle = cycle;
+         w.start_insn = insn;
+         w.cycles = 0;
+         w.insn = 0;
+         w.ffwd_insn = 0;
+         m_windows.push_back(w);
+         m_window_open = true;
+         if( m_mode == BBV ) 
+            ptx_file_line_stats_get_exec_counts(m_window_start_counts);
+      }
+   }
+   return k.ffwd;
+}
+
+void sim_sampler::add_ffwd_cta( const kernel_info_t &kernel, unsigned long long n_insn )
+{
+   std::map<unsigned,kernel_state_t>::iterator i = m_kernels.find(kernel.get_uid());
+   assert( i != m_kernels.end() && i->second.ffwd );
+   i->second.unit_ffwd_insn += n_insn;
+   m_n_ffwd_ctas++;
+   m_ffwd_insn += n_insn;
+}
+
+void sim_sampler::kernel_done( const kernel_info_t &kernel, unsigned long long cycle, unsigned long long insn )
+{
+   std::map<unsigned,kernel_state_t>::iterator i = m_kernels.find(kernel.get_uid());
+   if( i == m_kernels.end() ) 
+      return;
+   if( i->second.unit != (unsigned)-1 ) 
+      end_unit(i->second,cycle,insn);
+   m_kernels.erase(i);
+}
+
+void sim_sampler::end_unit( kernel_state_t &k, unsigned long long cycle, unsigned long long insn )
+{
+   if( !k.ffwd ) {
+      close_window(cycle,insn);
+      return;
+   }
+   if( m_mode != BBV || m_phases.empty() ) 
+      return;
+
+   // a fast-forwarded unit is timed by the detailed window closest to it
+   exec_vector_t v;
+   exec_vector(k.unit_start_counts,v);
+   unsigned best = 0;
+   double best_dist = 2;
+   for( unsigned p=0; p < m_phases.size(); p++ ) {
+      double dist = 0;
+      exec_vector_t::const_iterator a = v.begin(), b = m_phases[p].begin();
+      while( a != v.end() || b != m_phases[p].end() ) {
+         if( b == m_phases[p].end() || (a != v.end() && a->first < b->first) ) {
+            dist += a->second;
+            a++;
+         } else if( a == v.end() || b->first < a->first ) {
+            dist += b->second;
+            b++;
+         } else {
+            dist += fabs(a->second - b->second);
+            a++;
+            b++;
+         }
+      }
+      if( p == 0 || dist < best_dist ) {
+         best = p;
+         best_dist = dist;
+      }
+   }
+   m_windows[best].ffwd_insn += k.unit_ffwd_insn;
+   k.new_phase = best_dist/2 > m_threshold;
+}
+
+void sim_sampler::close_window( unsigned long long cycle, unsigned long long insn )
+{
+   if( !m_window_open ) 
+      return;
+   window_t &w = m_windows.back();
+   w.cycles = cycle - w.start_cycle;
+   w.insn = insn - w.start_insn;
+   m_window_open = false;
+   if( m_mode == BBV ) {
+      m_phases.push_back(exec_vector_t());
+      exec_vector(m_window_start_counts,m_phases.back());
+   }
+}
+
+// fraction of the thread instructions executed since start by each PTX line
+void sim_sampler::exec_vector( const ptx_exec_count_map_t &start, exec_vector_t &v ) const
+{
+   ptx_exec_count_map_t now;
+   ptx_file_line_stats_get_exec_counts(now);
+   double total = 0;
+   for( ptx_exec_count_map_t::const_iterator i=now.begin(); i != now.end(); i++ ) {
+      ptx_exec_count_map_t::const_iterator s = start.find(i->first);
+      unsigned long delta = i->second - (s == start.end()? 0 : s->second);
+      if( delta ) {
+         v[i->first] = delta;
+         total += delta;
+      }
+   }
+   for( exec_vector_t::iterator i=v.begin(); i != v.end(); i++ ) 
+      i->second /= total;
+}
+
+// two-sided 95% Student t quantiles for 1..29 degrees of freedom
+static const double t_95[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                               2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                               2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045 };
+
+void sim_sampler::print( FILE *fp, unsigned long long cycle, unsigned long long insn ) const
+{
+   std::vector<window_t> windows = m_windows;
+   if( m_window_open ) {
+      windows.back().cycles = cycle - windows.back().start_cycle;
+      windows.back().insn = insn - windows.back().start_insn;
+   }
+
+   // IPC of the detailed windows, or of the whole timing run if they are empty
+   unsigned long long w_cycles = 0, w_insn = 0;
+   for( unsigned i=0; i < windows.size(); i++ ) {
+      w_cycles += windows[i].cycles;
+      w_insn += windows[i].insn;
+   }
+   double ipc = w_cycles? (double)w_insn/w_cycles : (cycle? (double)insn/cycle : 0);
+
+   // cycles of the fast-forwarded instructions
+   double ffwd_cycles = 0;
+   if( ipc > 0 ) {
+      unsigned long long untimed = m_ffwd_insn;
+      for( unsigned i=0; i < windows.size(); i++ ) {
+         if( windows[i].ffwd_insn && windows[i].insn ) {
+            ffwd_cycles += windows[i].ffwd_insn * (double)windows[i].cycles / windows[i].insn;
+            untimed -= windows[i].ffwd_insn;
+         }
+      }
+      ffwd_cycles += untimed / ipc;
+   }
+
+   // confidence interval from the spread of the window IPCs
+   std::vector<double> samples;
+   for( unsigned i=0; i < windows.size(); i++ ) {
+      if( windows[i].cycles ) 
+         samples.push_back( (double)windows[i].insn / windows[i].cycles );
+   }
+   double h = 0; // relative half width of the IPC interval
+   unsigned n = samples.size();
+   if( n > 1 ) {
+      double mean = 0, var = 0;
+      for( unsigned i=0; i < n; i++ ) 
+         mean += samples[i];
+      mean /= n;
+      for( unsigned i=0; i < n; i++ ) 
+         var += (samples[i]-mean)*(samples[i]-mean);
+      var /= n-1;
+      double t = (n-1 <= 29)? t_95[n-2] : 1.96;
+      if( mean > 0 ) 
+         h = t*sqrt(var/n)/mean;
+   }
+   double est_cycle = cycle + ffwd_cycles;
+   double est_cycle_lo = cycle + ffwd_cycles/(1+h);
+   double est_cycle_hi = h < 1? cycle + ffwd_cycles/(1-h) : HUGE_VAL;
+   unsigned long long est_insn = insn + m_ffwd_insn;
+
+   fprintf(fp, "gpu_sampling_detailed_units = %u\n", m_n_detailed_units);
+   fprintf(fp, "gpu_sampling_ffwd_units = %u\n", m_n_ffwd_units);
+   fprintf(fp, "gpu_sampling_ffwd_ctas = %llu\n", m_n_ffwd_ctas);
+   fprintf(fp, "gpu_sampling_ffwd_insn = %llu\n", m_ffwd_insn);
+   fprintf(fp, "gpu_sampling_windows = %u\n", (unsigned)windows.size());
+   fprintf(fp, "gpu_est_tot_sim_cycle = %.0f\n", est_cycle);
+   fprintf(fp, "gpu_est_tot_sim_cycle_95ci = [%.0f, %.0f]\n", est_cycle_lo, est_cycle_hi);
+   fprintf(fp, "gpu_est_tot_sim_insn = %llu\n", est_insn);
+   fprintf(fp, "gpu_est_tot_ipc = %12.4f\n", est_cycle > 0? est_insn/est_cycle : 0);
+   fprintf(fp, "gpu_est_tot_ipc_95ci = [%.4f, %.4f]\n", 
+           est_cycle_hi > 0? est_insn/est_cycle_hi : 0, est_cycle_lo > 0? est_insn/est_cycle_lo : 0);
+}
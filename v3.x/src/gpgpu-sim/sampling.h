@@ -0,0 +1,111 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+#include "../abstract_hardware_model.h"
+#include "../cuda-sim/ptx-stats.h"
+
+// Sampled simulation (-gpgpu_sampling). The CTAs of a kernel are grouped in 
+// units of consecutive CTA ids (-gpgpu_sampling_unit, one wave of the GPU by 
+// default). Detailed units run on the timing model, the other units are 
+// executed functionally (fast-forwarded) when their first CTA comes up for 
+// issue, optionally warming the caches with their global accesses. Each 
+// detailed unit opens a measurement window that lasts until the next unit 
+// starts; the fast-forwarded instructions are converted to cycles with the 
+// IPC of the windows to extrapolate the full run. Unit selection: 
+//    periodic:P      every P-th unit of a kernel is detailed
+//    units:0,3,5-7   the listed units of every kernel are detailed
+//    bbv:T           unit 0 is detailed; a fast-forwarded unit whose PTX line 
+//                    execution vector is further than T (normalized Manhattan
+//                    distance) from every detailed unit starts a new phase, 
+//                    so the unit after it is detailed.  Its instructions are 
+//                    timed with the IPC of the closest detailed unit.
+class sim_sampler {
+public:
+   sim_sampler( const char *spec, unsigned unit_ctas );
+
+   // true if the next CTA of kernel should be fast-forwarded; wave_ctas is 
+   // the unit size used when -gpgpu_sampling_unit is 0
+   bool fast_forward( const kernel_info_t &kernel, unsigned wave_ctas, 
+                      unsigned long long cycle, unsigned long long insn );
+   void add_ffwd_cta( const kernel_info_t &kernel, unsigned long long n_insn );
+   void kernel_done( const kernel_info_t &kernel, unsigned long long cycle, unsigned long long insn );
+
+   // cycle and insn are the totals simulated by the timing model so far
+   void print( FILE *fp, unsigned long long cycle, unsigned long long insn ) const;
+
+private:
+   enum mode_t { PERIODIC, UNIT_LIST, BBV };
+   typedef std::map<std::pair<std::string,unsigned>,double> exec_vector_t;
+
+   struct window_t {
+      unsigned long long start_cycle;
+      unsigned long long start_insn;
+      unsigned long long cycles;
+      unsigned long long insn;
+      unsigned long long ffwd_insn; // fast-forwarded instructions timed by this window (bbv)
+   };
+   struct kernel_state_t {
+      unsigned unit;          // unit of the CTAs being issued
+      unsigned unit_ctas;
+      bool ffwd;              // current unit is fast-forwarded
+      bool new_phase;         // bbv: next unit is detailed
+      unsigned long long unit_ffwd_insn;
+      ptx_exec_count_map_t unit_start_counts;
+   };
+
+   bool detailed_unit( const kernel_state_t &k ) const;
+   void end_unit( kernel_state_t &k, unsigned long long cycle, unsigned long long insn );
+   void close_window( unsigned long long cycle, unsigned long long insn );
+   void exec_vector( const ptx_exec_count_map_t &start, exec_vector_t &v ) const;
+
+   mode_t m_mode;
+   unsigned m_period;
+   std::vector<std::pair<unsigned,unsigned> > m_units; // detailed unit ranges (inclusive)
+   double m_threshold;
+   unsigned m_unit_ctas;
+
+   std::map<unsigned,kernel_state_t> m_kernels; // by kernel uid
+
+   std::vector<window_t> m_windows;
+   bool m_window_open;
+   ptx_exec_count_map_t m_window_start_counts;
+   std::vector<exec_vector_t> m_phases; // bbv: execution vector of each window
+
+   unsigned m_n_detailed_units;
+   unsigned m_n_ffwd_units;
+   unsigned long long m_n_ffwd_ctas;
+   unsigned long long m_ffwd_insn;
+};
+
+#endif
@@ -33,51 +33,80 @@
 
 //Constructor
 Scoreboard::Scoreboard( unsigned sid, unsigned n_warps )
-: longopregs()
 {
 	m_sid = sid;
-	//Initialize size of table
-	reg_table.resize(n_warps);
-	longopregs.resize(n_warps);
+	m_n_warps = n_warps;
+	//Initialize size of table, room for 256 registers per thread
+	m_n_words = 0;
+	n_pending.resize(n_warps,0);
+	grow(4);
+}
+
+// Widen the bitmasks of every warp to n_words words
+void Scoreboard::grow(unsigned n_words)
+{
+	std::vector<unsigned long long> regs(m_n_warps*n_words,0), longops(m_n_warps*n_words,0);
+	for(unsigned wid=0; wid<m_n_warps; wid++) {
+		for(unsigned w=0; w<m_n_words; w++) {
+			regs[wid*n_words+w] = reg_table[wid*m_n_words+w];
+			longops[wid*n_words+w] = longopregs[wid*m_n_words+w];
+		}
+	}
+	reg_table.swap(regs);
+	longopregs.swap(longops);
+	m_n_words = n_words;
 }
 
 // Print scoreboard contents
 void Scoreboard::printContents() const
 {
 	printf("scoreboard contents (sid=%d): \n", m_sid);
-	for(unsigned i=0; i<reg_table.size(); i++) {
-		if(reg_table[i].size() == 0 ) continue;
+	for(unsigned i=0; i<m_n_warps; i++) {
+		if(n_pending[i] == 0 ) continue;
 		printf("  wid = %2d: ", i);
-		std::set<unsigned>::const_iterator it;
-		for( it=reg_table[i].begin() ; it != reg_table[i].end(); it++ )
-			printf("%u ", *it);
+		for(unsigned r=0; r<64*m_n_words; r++ ) {
+			if( reg_table[i*m_n_words+r/64] & (1ULL << (r%64)) )
+				printf("%u ", r);
+		}
 		printf("\n");
 	}
 }
 
 void Scoreboard::reserveRegister(unsigned wid, unsigned regnum) 
 {
-	if( !(reg_table[wid].find(regnum) == reg_table[wid].end()) ){
+	if( regnum/64 >= m_n_words ) 
+		grow(regnum/64+1);
+	unsigned long long &word = reg_table[wid*m_n_words+regnum/64];
+	unsigned long long bit = 1ULL << (regnum%64);
+	if( word & bit ){
 		printf("Error: trying to reserve an already reserved register (sid=%d, wid=%d, regnum=%d).", m_sid, wid, regnum);
         abort();
 	}
     SHADER_DPRINTF( SCOREBOARD,
                     "Reserved Register - warp:%d, reg: %d\n", wid, regnum );
-	reg_table[wid].insert(regnum);
+	word |= bit;
+	n_pending[wid]++;
 }
 
 // Unmark register as write-pending
 void Scoreboard::releaseRegister(unsigned wid, unsigned regnum) 
 {
-	if( !(reg_table[wid].find(regnum) != reg_table[wid].end()) ) 
+	if( regnum/64 >= m_n_words ) 
+        return;
+	unsigned long long &word = reg_table[wid*m_n_words+regnum/64];
+	unsigned long long bit = 1ULL << (regnum%64);
+	if( !(word & bit) ) 
         return;
     SHADER_DPRINTF( SCOREBOARD,
                     "Release register - warp:%d, reg: %d\n", wid, regnum );
-	reg_table[wid].erase(regnum);
+	word &= ~bit;
+	n_pending[wid]--;
 }
 
 const bool Scoreboard::islongop (unsigned warp_id,unsigned regnum) {
-	return longopregs[warp_id].find(regnum) != longopregs[warp_id].end();
+	if( regnum/64 >= m_n_words ) 
+		return false;
+	return (longopregs[warp_id*m_n_words+regnum/64] >> (regnum%64)) & 1;
 }
 
 void Scoreboard::reserveRegisters(const class warp_inst_t* inst) 
@@ -106,7 +135,7 @@ void Scoreboard::reserveRegisters(const class warp_inst_t* inst)
                                 "New longopreg marked - warp:%d, reg: %d\n",
                                 inst->warp_id(),
                                 inst->out[r] );
-                longopregs[inst->warp_id()].insert(inst->out[r]);
+                longopregs[inst->warp_id()*m_n_words+inst->out[r]/64] |= 1ULL << (inst->out[r]%64);
             }
     	}
     }
@@ -122,7 +151,8 @@ void Scoreboard::releaseRegisters(const class warp_inst_t *inst)
                             inst->warp_id(),
                             inst->out[r] );
             releaseRegister(inst->warp_id(), inst->out[r]);
-            longopregs[inst->warp_id()].erase(inst->out[r]);
+            if( inst->out[r]/64 < m_n_words ) 
+                longopregs[inst->warp_id()*m_n_words+inst->out[r]/64] &= ~(1ULL << (inst->out[r]%64));
         }
     }
 }
@@ -135,31 +165,17 @@ void Scoreboard::releaseRegisters(const class warp_inst_t *inst)
  **/ 
 bool Scoreboard::checkCollision( unsigned wid, const class inst_t *inst ) const
 {
-	// Get list of all input and output registers
-	std::set<int> inst_regs;
-
-	if(inst->out[0] > 0) inst_regs.insert(inst->out[0]);
-	if(inst->out[1] > 0) inst_regs.insert(inst->out[1]);
-	if(inst->out[2] > 0) inst_regs.insert(inst->out[2]);
-	if(inst->out[3] > 0) inst_regs.insert(inst->out[3]);
-	if(inst->in[0] > 0) inst_regs.insert(inst->in[0]);
-	if(inst->in[1] > 0) inst_regs.insert(inst->in[1]);
-	if(inst->in[2] > 0) inst_regs.insert(inst->in[2]);
-	if(inst->in[3] > 0) inst_regs.insert(inst->in[3]);
-	if(inst->pred > 0) inst_regs.insert(inst->pred);
-	if(inst->ar1 > 0) inst_regs.insert(inst->ar1);
-	if(inst->ar2 > 0) inst_regs.insert(inst->ar2);
-
-	// Check for collision, get the intersection of reserved registers and instruction registers
-	std::set<int>::const_iterator it2;
-	for ( it2=inst_regs.begin() ; it2 != inst_regs.end(); it2++ )
-		if(reg_table[wid].find(*it2) != reg_table[wid].end()) {
+	// intersection of the reserved registers and the register mask of the 
+	// instruction (usually a single word)
+	const unsigned long long *pending = &reg_table[wid*m_n_words];
+	for( unsigned w=0; w < inst->n_reg_words; w++ ) {
+		if( inst->reg_word[w] < m_n_words && (pending[inst->reg_word[w]] & inst->reg_bits[w]) ) 
 			return true;
-		}
+	}
 	return false;
 }
 
 bool Scoreboard::pendingWrites(unsigned wid) const
 {
-	return !reg_table[wid].empty();
+	return n_pending[wid] != 0;
 }
@@ -28,7 +28,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
-#include <set>
 #include "assert.h"
 
 #ifndef SCOREBOARD_H_
@@ -50,15 +49,20 @@ public:
     const bool islongop(unsigned warp_id, unsigned regnum);
 private:
     void reserveRegister(unsigned wid, unsigned regnum);
+    void grow(unsigned n_words);
     int get_sid() const { return m_sid; }
 
     unsigned m_sid;
+    unsigned m_n_warps;
 
+    // register bitmasks of m_n_words 64-bit words per warp, widened when a 
+    // register past the end is reserved (register r is bit r%64 of word r/64)
+    unsigned m_n_words;
     // keeps track of pending writes to registers
-    // indexed by warp id, reg_id => pending write count
-    std::vector< std::set<unsigned> > reg_table;
+    std::vector<unsigned long long> reg_table;
+    std::vector<unsigned> n_pending; // per warp
     //Register that depend on a long operation (global, local or tex memory)
-    std::vector< std::set<unsigned> > longopregs;
+    std::vector<unsigned long long> longopregs;
 };
 
 
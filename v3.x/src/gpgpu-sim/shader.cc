@@ -36,6 +36,7 @@
 #include "../cuda-sim/ptx_sim.h"
 #include "../cuda-sim/ptx-stats.h"
 #include "../cuda-sim/cuda-sim.h"
+#include "../cuda-sim/cuda_device_printf.h"
 #include "gpu-sim.h"
 #include "mem_fetch.h"
 #include "mem_latency_stat.h"
@@ -46,6 +47,8 @@
 #include <limits.h>
 #include "traffic_breakdown.h"
 #include "shader_trace.h"
+#include "warp_trace.h"
+#include "../checkpoint.h"
 
 #define PRIORITIZE_MSHR_OVER_WB 1
 #define MAX(a,b) (((a)>(b))?(a):(b))
@@ -121,6 +124,8 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     
     m_warp.resize(m_config->max_warps_per_shader, shd_warp_t(this, warp_size));
     m_scoreboard = new Scoreboard(m_sid, m_config->max_warps_per_shader);
+    m_warp_trace = gpu->get_warp_trace();
+    m_warp_trace_stream.resize(m_config->max_warps_per_shader, NULL);
     
     //scedulers
     //must currently occur after all inputs have been initialized.
@@ -315,6 +320,7 @@ void shader_core_ctx::reinit(unsigned start_thread, unsigned end_thread, bool re
    for (unsigned i = start_thread / m_config->warp_size; i < end_thread / m_config->warp_size; ++i) {
       m_warp[i].reset();
       m_simt_stack[i]->reset();
+      update_warp_ready(i);
    }
 }
 
@@ -338,8 +344,16 @@ void shader_core_ctx::init_warps( unsigned cta_id, unsigned start_thread, unsign
             }
             m_simt_stack[i]->launch(start_pc,active_threads);
             m_warp[i].init(start_pc,cta_id,i,active_threads, m_dynamic_warp_id);
+            update_warp_ready(i);
             ++m_dynamic_warp_id;
             m_not_completed += n_active;
+            if( m_warp_trace ) {
+                dim3 ctaid = m_thread[start_thread]->get_ctaid();
+                dim3 grid = m_kernel->get_grid_dim();
+                unsigned cta_linear_id = ctaid.x + grid.x*(ctaid.y + grid.y*ctaid.z);
+                assert( m_warp_trace_stream[i] == NULL );
+                m_warp_trace_stream[i] = m_warp_trace->begin_warp(m_kernel->get_uid(),cta_linear_id,i-start_warp);
+            }
       }
    }
 }
@@ -457,7 +471,56 @@ void shader_core_stats::print( FILE* fout ) const
    m_incoming_traffic_stats->print(fout); 
 }
 
+// counters of shader_core_stats_pod that are not indexed by shader id 
+#define SHADER_CORE_STATS_COUNTERS(X) \
+    X(gpgpu_n_load_insn) X(gpgpu_n_store_insn) X(gpgpu_n_shmem_insn) X(gpgpu_n_tex_insn) \
+    X(gpgpu_n_const_insn) X(gpgpu_n_param_insn) X(gpgpu_n_shmem_bkconflict) \
+    X(gpgpu_n_cache_bkconflict) X(gpgpu_n_intrawarp_mshr_merge) X(gpgpu_n_cmem_portconflict) \
+    X(gpu_reg_bank_conflict_stalls) X(gpgpu_n_stall_shd_mem) \
+    X(gpgpu_n_mem_read_local) X(gpgpu_n_mem_write_local) X(gpgpu_n_mem_texture) \
+    X(gpgpu_n_mem_const) X(gpgpu_n_mem_read_global) X(gpgpu_n_mem_write_global) \
+    X(gpgpu_n_mem_read_inst) X(gpgpu_n_mem_l2_writeback) X(gpgpu_n_mem_l1_write_allocate) \
+    X(gpgpu_n_mem_l2_write_allocate) X(made_write_mfs) X(made_read_mfs)
+
+shader_core_stats::shader_core_stats( shader_core_stats *parent )
+{
+    // start from the parent's pointers (per-shader arrays, traffic breakdown)
+    memcpy(this->shader_core_stats_pod_start, parent->shader_core_stats_pod_start, sizeof(shader_core_stats_pod));
+    m_config = parent->m_config;
+    m_parent = parent;
+    m_outgoing_traffic_stats = parent->m_outgoing_traffic_stats;
+    m_incoming_traffic_stats = parent->m_incoming_traffic_stats;
+#define CLEAR_COUNTER(x) x = 0;
+    SHADER_CORE_STATS_COUNTERS(CLEAR_COUNTER)
+#undef CLEAR_COUNTER
+    memset(gpu_stall_shd_mem_breakdown, 0, sizeof(gpu_stall_shd_mem_breakdown));
+    shader_cycle_distro = (unsigned*) calloc(m_config->warp_size+3, sizeof(unsigned));
+}
+
+void shader_core_stats::merge_into_parent()
+{
+    assert(m_parent);
+#define MERGE_COUNTER(x) m_parent->x += x; x = 0;
+    SHADER_CORE_STATS_COUNTERS(MERGE_COUNTER)
+#undef MERGE_COUNTER
+    for (unsigned i = 0; i < N_MEM_STAGE_ACCESS_TYPE; i++) {
+        for (unsigned j = 0; j < N_MEM_STAGE_STALL_TYPE; j++) {
+            m_parent->gpu_stall_shd_mem_breakdown[i][j] += gpu_stall_shd_mem_breakdown[i][j];
+            gpu_stall_shd_mem_breakdown[i][j] = 0;
+        }
+    }
+    for (unsigned i = 0; i < m_config->warp_size + 3; i++) {
+        m_parent->shader_cycle_distro[i] += shader_cycle_distro[i];
+        shader_cycle_distro[i] = 0;
+    }
+}
+
 void shader_core_stats::event_warp_issued( unsigned s_id, unsigned warp_id, unsigned num_issued, unsigned dynamic_warp_id ) {
+    if ( m_parent ) {
+        // rows are indexed by shader id, so clusters never share one
+        m_parent->event_warp_issued(s_id, warp_id, num_issued, dynamic_warp_id);
+        return;
+    }
     assert( warp_id <= m_config->max_warps_per_shader );
     for ( unsigned i = 0; i < num_issued; ++i ) {
         if ( m_shader_dynamic_warp_issue_distro[ s_id ].size() <= dynamic_warp_id ) {
@@ -593,6 +656,7 @@ void shader_core_ctx::decode()
                }
            }
         }
+        update_warp_ready(m_inst_fetch_buffer.m_warp_id);
         m_inst_fetch_buffer.m_valid = false;
     }
 }
@@ -613,15 +677,21 @@ void shader_core_ctx::fetch()
                     if( m_threadState[tid].m_active == true ) {
                         m_threadState[tid].m_active = false; 
                         unsigned cta_id = m_warp[warp_id].get_cta_id();
-                        register_cta_thread_exit(cta_id);
+                        m_cluster->cta_thread_exit(this,cta_id);
                         m_not_completed -= 1;
                         m_active_threads.reset(tid);
                         assert( m_thread[tid]!= NULL );
                         did_exit=true;
                     }
                 }
-                if( did_exit ) 
+                if( did_exit ) {
                     m_warp[warp_id].set_done_exit();
+                    update_warp_ready(warp_id);
+                    if( m_warp_trace_stream[warp_id] ) {
+                        m_warp_trace->end_warp(m_warp_trace_stream[warp_id]);
+                        m_warp_trace_stream[warp_id] = NULL;
+                    }
+                }
             }
 
             // this code fetches instructions from the i-cache or generates memory requests
@@ -655,7 +725,7 @@ void shader_core_ctx::fetch()
                                               m_sid,
                                               m_tpc,
                                               m_memory_config );
-                std::list<cache_event> events;
+                cache_event_list events;
                 enum cache_request_status status = m_L1I->access( (new_addr_type)ppc, mf, gpu_sim_cycle+gpu_tot_sim_cycle,events);
                 if( status == MISS ) {
                     m_last_warp_fetched=warp_id;
@@ -687,9 +757,63 @@ void shader_core_ctx::fetch()
 
 void shader_core_ctx::func_exec_inst( warp_inst_t &inst )
 {
-    execute_warp_inst_t(inst);
-    if( inst.is_load() || inst.is_store() )
+    unsigned warp_id = inst.warp_id();
+    warp_trace_stream *trace = m_warp_trace_stream[warp_id];
+    if( trace && m_warp_trace->replaying() ) {
+        trace->replay_exec(inst);
+        if( inst.isatomic() ) {
+            for( unsigned t=0; t < m_config->warp_size; t++ ) 
+                if( inst.active(t) ) 
+                    m_warp[warp_id].inc_n_atomic();
+        }
+    } else {
+        execute_warp_inst_t(inst);
+        if( trace ) 
+            trace->record_exec(inst);
+    }
+    if( inst.is_load() || inst.is_store() ) {
+        if( inst.space.is_local() ) {
+            for( unsigned t=0; t < m_config->warp_size; t++ ) {
+                if( !inst.active(t) ) 
+                    continue;
+                unsigned tid = warp_id*m_config->warp_size + t;
+                new_addr_type localaddrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
+                unsigned num_addrs;
+                num_addrs = translate_local_memaddr(inst.get_addr(t), tid, m_config->n_simt_clusters*m_config->n_simt_cores_per_cluster,
+                       inst.data_size, (new_addr_type*) localaddrs );
+                inst.set_addr(t, (new_addr_type*) localaddrs, num_addrs);
+            }
+        }
         inst.generate_mem_accesses();
+    }
+}
+
+// SIMT stack update of a warp whose instruction stream is traced: recorded 
+// after it is collected from the functional threads, or taken from the trace 
+// during replay, where threads exiting on this instruction are retired here
+void shader_core_ctx::update_simt_stack_trace( unsigned warp_id, warp_inst_t *inst )
+{
+    warp_trace_stream *trace = m_warp_trace_stream[warp_id];
+    simt_mask_t thread_done;
+    addr_vector_t next_pc;
+    if( m_warp_trace->replaying() ) {
+        trace->replay_simt(*inst,thread_done,next_pc);
+        for( unsigned t=0; t < m_config->warp_size; t++ ) {
+            unsigned tid = warp_id*m_config->warp_size + t;
+            if( !thread_done.test(t) || ptx_thread_done(tid) ) 
+                continue;
+            m_thread[tid]->set_done();
+            m_thread[tid]->exitCore();
+            m_thread[tid]->registerExit();
+            m_warp[warp_id].set_completed(t);
+            m_warp[warp_id].ibuffer_flush();
+        }
+    } else {
+        bool return_rpc = (inst->reconvergence_pc == RECONVERGE_RETURN_PC);
+        getSIMTStackUpdate(warp_id,inst,thread_done,next_pc);
+        trace->record_simt(*inst,return_rpc,thread_done,next_pc);
+    }
+    m_simt_stack[warp_id]->update(thread_done,next_pc,inst->reconvergence_pc,inst->op,warp_id);
 }
 
 void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t* next_inst, const active_mask_t &active_mask, unsigned warp_id )
@@ -704,13 +828,17 @@ void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t*
     m_stats->shader_cycle_distro[2+(*pipe_reg)->active_count()]++;
     func_exec_inst( **pipe_reg );
     if( next_inst->op == BARRIER_OP ) 
-        m_barriers.warp_reaches_barrier(m_warp[warp_id].get_cta_id(),warp_id);
+        update_warps_ready( m_barriers.warp_reaches_barrier(m_warp[warp_id].get_cta_id(),warp_id) );
     else if( next_inst->op == MEMORY_BARRIER_OP ) 
         m_warp[warp_id].set_membar();
 
-    updateSIMTStack(warp_id,*pipe_reg);
+    if( m_warp_trace_stream[warp_id] ) 
+        update_simt_stack_trace(warp_id,*pipe_reg);
+    else
+        updateSIMTStack(warp_id,*pipe_reg);
     m_scoreboard->reserveRegisters(*pipe_reg);
     m_warp[warp_id].set_next_pc(next_inst->pc + next_inst->isize);
+    update_warp_ready(warp_id);
 }
 
 void shader_core_ctx::issue(){
@@ -879,6 +1007,7 @@ void scheduler_unit::cycle()
                     // control hazard
                     warp(warp_id).set_next_pc(pc);
                     warp(warp_id).ibuffer_flush();
+                    m_shader->update_warp_ready(warp_id);
                 } else {
 
                     //HAVE AN INSTRUCTION THAT CAN BE ISSUED
@@ -931,6 +1060,7 @@ void scheduler_unit::cycle()
                               (*iter)->get_warp_id(), (*iter)->get_dynamic_warp_id() );
                warp(warp_id).set_next_pc(pc);
                warp(warp_id).ibuffer_flush();
+               m_shader->update_warp_ready(warp_id);
             }
             if(warp_inst_issued) {
                 SCHED_DPRINTF( "Warp (warp_id %u, dynamic_warp_id %u) issued %u instructions\n",
@@ -1005,6 +1135,57 @@ bool scheduler_unit::sort_warps_by_oldest_dynamic_id(shd_warp_t* lhs, shd_warp_t
     }
 }
 
+void scheduler_unit::order_greedy_then_oldest( std::vector< shd_warp_t* >& result_list,
+                                               unsigned num_warps_to_add )
+{
+    assert( num_warps_to_add <= m_supervised_warps.size() );
+    result_list.clear();
+    if ( m_age_ordered_stamp != m_shader->m_dynamic_warp_id ) {
+        m_age_ordered_warps = m_supervised_warps;
+        std::sort( m_age_ordered_warps.begin(), m_age_ordered_warps.end(),
+                   scheduler_unit::sort_warps_by_dynamic_id );
+        m_age_rank.resize( m_warp->size() );
+        for ( unsigned r = 0; r < m_age_ordered_warps.size(); ++r ) {
+            m_age_rank[ m_age_ordered_warps[r] - &warp(0) ] = r;
+        }
+        m_age_ordered_stamp = m_shader->m_dynamic_warp_id;
+    }
+
+    // Blocked warps sort to the back in order_by_priority and do nothing in
+    // cycle(), and neither do warps with an empty ibuffer, so both are left
+    // out here.  When the list is limited, unblocked warps still take up one
+    // of the num_warps_to_add slots (as does the greedy warp) even when they
+    // have nothing to issue.
+    bool limited = num_warps_to_add < m_age_ordered_warps.size();
+    const warp_set_t &with_inst = m_shader->warps_with_inst();
+    warp_set_t candidates = m_shader->unblocked_warps() & m_supervised_mask;
+    if ( !limited ) {
+        candidates &= with_inst;
+    }
+    shd_warp_t* greedy_value = NULL;
+    if ( m_last_supervised_issued != m_supervised_warps.end() ) {
+        greedy_value = *m_last_supervised_issued;
+        unsigned w = greedy_value - &warp(0);
+        if ( candidates.test(w) && with_inst.test(w) ) {
+            result_list.push_back( greedy_value );
+        }
+    }
+
+    // visit the candidates oldest first
+    warp_set_t by_age;
+    for ( unsigned w = candidates._Find_first(); w < candidates.size(); w = candidates._Find_next(w) ) {
+        by_age.set( m_age_rank[w] );
+    }
+    unsigned count = 0;
+    for ( unsigned r = by_age._Find_first(); r < by_age.size() && count < num_warps_to_add; r = by_age._Find_next(r) ) {
+        shd_warp_t* w = m_age_ordered_warps[r];
+        ++count;
+        if ( w != greedy_value && with_inst.test( w - &warp(0) ) ) {
+            result_list.push_back( w );
+        }
+    }
+}
+
 void lrr_scheduler::order_warps()
 {
     order_lrr( m_next_cycle_prioritized_warps,
@@ -1015,12 +1196,8 @@ void lrr_scheduler::order_warps()
 
 void gto_scheduler::order_warps()
 {
-    order_by_priority( m_next_cycle_prioritized_warps,
-                       m_supervised_warps,
-                       m_last_supervised_issued,
-                       m_supervised_warps.size(),
-                       ORDERING_GREEDY_THEN_PRIORITY_FUNC,
-                       scheduler_unit::sort_warps_by_oldest_dynamic_id );
+    order_greedy_then_oldest( m_next_cycle_prioritized_warps,
+                              m_supervised_warps.size() );
 }
 
 void
@@ -1030,12 +1207,10 @@ two_level_active_scheduler::do_on_warp_issued( unsigned warp_id,
 {
     scheduler_unit::do_on_warp_issued( warp_id, num_issued, prioritized_iter );
     if ( SCHEDULER_PRIORITIZATION_LRR == m_inner_level_prioritization ) {
-        std::vector< shd_warp_t* > new_active; 
-        order_lrr( new_active,
-                   m_next_cycle_prioritized_warps,
-                   prioritized_iter,
-                   m_next_cycle_prioritized_warps.size() );
-        m_next_cycle_prioritized_warps = new_active;
+        // same result as order_lrr() into a temporary and copying it back,
+        // done in place so the active list is not reallocated on every issue
+        std::vector< shd_warp_t* >::iterator first = m_next_cycle_prioritized_warps.begin();
+        std::rotate( first, first + (prioritized_iter - first) + 1, m_next_cycle_prioritized_warps.end() );
     } else {
         fprintf( stderr,
                  "Unimplemented m_inner_level_prioritization: %d\n",
@@ -1117,12 +1292,8 @@ swl_scheduler::swl_scheduler ( shader_core_stats* stats, shader_core_ctx* shader
 void swl_scheduler::order_warps()
 {
     if ( SCHEDULER_PRIORITIZATION_GTO == m_prioritization ) {
-        order_by_priority( m_next_cycle_prioritized_warps,
-                           m_supervised_warps,
-                           m_last_supervised_issued,
-                           MIN( m_num_warps_to_limit, m_supervised_warps.size() ),
-                           ORDERING_GREEDY_THEN_PRIORITY_FUNC,
-                           scheduler_unit::sort_warps_by_oldest_dynamic_id );
+        order_greedy_then_oldest( m_next_cycle_prioritized_warps,
+                                  MIN( m_num_warps_to_limit, m_supervised_warps.size() ) );
     } else {
         fprintf(stderr, "swl_scheduler m_prioritization = %d\n", m_prioritization);
         abort();
@@ -1285,7 +1456,7 @@ void shader_core_ctx::warp_inst_complete(const warp_inst_t &inst)
 	  m_stats->m_num_sim_insn[m_sid] += inst.active_count();
 
   m_stats->m_num_sim_winsn[m_sid]++;
-  m_gpu->gpu_sim_insn += inst.active_count();
+  m_cluster->add_sim_insn(inst.active_count());
   inst.completed(gpu_tot_sim_cycle + gpu_sim_cycle);
 }
 
@@ -1321,9 +1492,9 @@ void shader_core_ctx::writeback()
         unsigned warp_id = pipe_reg->warp_id();
         m_scoreboard->releaseRegisters( pipe_reg );
         m_warp[warp_id].dec_inst_in_pipeline();
+        update_warp_ready(warp_id); // may end a memory barrier
         warp_inst_complete(*pipe_reg);
-        m_gpu->gpu_sim_insn_last_update_sid = m_sid;
-        m_gpu->gpu_sim_insn_last_update = gpu_sim_cycle;
+        m_cluster->sim_insn_last_update(m_sid);
         m_last_inst_gpu_sim_cycle = gpu_sim_cycle;
         m_last_inst_gpu_tot_sim_cycle = gpu_tot_sim_cycle;
         pipe_reg->clear();
@@ -1354,7 +1525,7 @@ mem_stage_stall_type
 ldst_unit::process_cache_access( cache_t* cache,
                                  new_addr_type address,
                                  warp_inst_t &inst,
-                                 std::list<cache_event>& events,
+                                 cache_event_list& events,
                                  mem_fetch *mf,
                                  enum cache_request_status status )
 {
@@ -1399,7 +1570,7 @@ mem_stage_stall_type ldst_unit::process_memory_access_queue( cache_t *cache, war
 
     //const mem_access_t &access = inst.accessq_back();
     mem_fetch *mf = m_mf_allocator->alloc(inst,inst.accessq_back());
-    std::list<cache_event> events;
+    cache_event_list events;
     enum cache_request_status status = cache->access(mf->get_addr(),mf,gpu_sim_cycle+gpu_tot_sim_cycle,events);
     return process_cache_access( cache, mf->get_addr(), inst, events, mf, status );
 }
@@ -1509,6 +1680,12 @@ void ldst_unit::flush(){
 	m_L1D->flush();
 }
 
+void ldst_unit::warm_L1D( new_addr_type addr, unsigned time )
+{
+    if( m_L1D ) 
+        m_L1D->warm(addr,time,false);
+}
+
 simd_function_unit::simd_function_unit( const shader_core_config *config )
 { 
     m_config=config;
@@ -1537,6 +1714,40 @@ void ldst_unit::active_lanes_in_pipeline(){
 	assert(active_count<=m_core->get_config()->warp_size);
 	m_core->incfumemactivelanes_stat(active_count);
 }
+bool ldst_unit::idle() const
+{
+    if( !m_response_fifo.empty() || !m_next_wb.empty() || m_next_global ) 
+        return false;
+    if( !m_L1T->idle() || !m_L1C->idle() || (m_L1D && !m_L1D->idle()) ) 
+        return false;
+    return pipelined_simd_unit::idle();
+}
+
+void ldst_unit::skip_idle_cycles( unsigned long long n )
+{
+    m_L1C->skip_idle_cycles(n);
+    if( m_L1D ) 
+        m_L1D->skip_idle_cycles(n);
+}
+
+void ldst_unit::checkpoint( FILE *fp ) const
+{
+    checkpoint_write_section(fp,"LDST",m_L1D != NULL);
+    m_L1T->checkpoint(fp);
+    m_L1C->checkpoint(fp);
+    if( m_L1D ) 
+        m_L1D->checkpoint(fp);
+}
+
+void ldst_unit::restore( FILE *fp )
+{
+    checkpoint_read_section(fp,"LDST",m_L1D != NULL);
+    m_L1T->restore(fp);
+    m_L1C->restore(fp);
+    if( m_L1D ) 
+        m_L1D->restore(fp);
+}
+
 void sp_unit::active_lanes_in_pipeline(){
 	unsigned active_count=pipelined_simd_unit::get_active_lanes_in_pipeline();
 	assert(active_count<=m_core->get_config()->warp_size);
@@ -1745,6 +1956,7 @@ void ldst_unit::writeback()
             if( insn_completed ) {
                 m_core->warp_inst_complete(m_next_wb);
             }
+            m_core->update_warp_ready(m_next_wb.warp_id());
             m_next_wb.clear();
             m_last_inst_gpu_sim_cycle = gpu_sim_cycle;
             m_last_inst_gpu_tot_sim_cycle = gpu_tot_sim_cycle;
@@ -1945,6 +2157,7 @@ void ldst_unit::cycle()
                if( !pending_requests ) {
                    m_core->warp_inst_complete(*m_dispatch_reg);
                    m_scoreboard->releaseRegisters(m_dispatch_reg);
+                   m_core->update_warp_ready(warp_id);
                }
                m_core->dec_inst_in_pipeline(warp_id);
                m_dispatch_reg->clear();
@@ -2629,7 +2842,7 @@ void barrier_set_t::deallocate_barrier( unsigned cta_id )
 }
 
 // individual warp hits barrier
-void barrier_set_t::warp_reaches_barrier( unsigned cta_id, unsigned warp_id )
+warp_set_t barrier_set_t::warp_reaches_barrier( unsigned cta_id, unsigned warp_id )
 {
    cta_to_warp_t::iterator w=m_cta_to_warps.find(cta_id);
 
@@ -2649,7 +2862,9 @@ void barrier_set_t::warp_reaches_barrier( unsigned cta_id, unsigned warp_id )
    if( at_barrier == active ) {
       // all warps have reached barrier, so release waiting warps...
       m_warp_at_barrier &= ~at_barrier;
+      return at_barrier;
    }
+   return warp_set_t();
 }
 
 // fetching a warp
@@ -2659,7 +2874,7 @@ bool barrier_set_t::available_for_fetch( unsigned warp_id ) const
 }
 
 // warp reaches exit 
-void barrier_set_t::warp_exit( unsigned warp_id )
+warp_set_t barrier_set_t::warp_exit( unsigned warp_id )
 {
    // caller needs to verify all threads in warp are done, e.g., by checking PDOM stack to 
    // see it has only one entry during exit_impl()
@@ -2677,7 +2892,9 @@ void barrier_set_t::warp_exit( unsigned warp_id )
    if( at_barrier == active ) {
       // all warps have reached barrier, so release waiting warps...
       m_warp_at_barrier &= ~at_barrier;
+      return at_barrier;
    }
+   return warp_set_t();
 }
 
 // assertions
@@ -2721,7 +2938,7 @@ void shader_core_ctx::warp_exit( unsigned warp_id )
 	//if (m_warp[warp_id].get_n_completed() == get_config()->warp_size)
 	//if (this->m_simt_stack[warp_id]->get_num_entries() == 0)
 	if (done)
-		m_barriers.warp_exit( warp_id );
+		update_warps_ready( m_barriers.warp_exit( warp_id ) );
 }
 
 bool shader_core_ctx::warp_waiting_at_barrier( unsigned warp_id ) const
@@ -2754,6 +2971,20 @@ void shader_core_ctx::decrement_atomic_count( unsigned wid, unsigned n )
 {
    assert( m_warp[wid].get_n_atomic() >= n );
    m_warp[wid].dec_n_atomic(n);
+   update_warp_ready(wid);
+}
+
+void shader_core_ctx::update_warp_ready( unsigned warp_id )
+{
+   shd_warp_t &w = m_warp[warp_id];
+   m_unblocked_warps[warp_id] = !w.done_exit() && !w.waiting();
+   m_warps_with_inst[warp_id] = !w.ibuffer_frag_empty();
+}
+
+void shader_core_ctx::update_warps_ready( const warp_set_t &warps )
+{
+   for( unsigned w = warps._Find_first(); w < warps.size(); w = warps._Find_next(w) ) 
+      update_warp_ready(w);
 }
 
 
@@ -2773,6 +3004,66 @@ bool shader_core_ctx::ldst_unit_response_buffer_full() const
     return m_ldst_unit->response_buffer_full();
 }
 
+// True if cycle() cannot change the state of this core until a memory reply 
+// arrives: the pipeline is empty and every warp has exited, is waiting (barrier, 
+// memory barrier, atomic, instruction cache miss) or has its next instruction 
+// blocked by the scoreboard.  Used by -gpgpu_skip_idle_cycles.
+bool shader_core_ctx::waiting_on_memory()
+{
+    if( m_inst_fetch_buffer.m_valid || !m_L1I->idle() ) 
+        return false;
+    for( unsigned i=0; i < N_PIPELINE_STAGES; i++ ) 
+        if( m_pipeline_reg[i].has_ready() ) 
+            return false;
+    for( unsigned n=0; n < m_num_function_units; n++ ) 
+        if( !m_fu[n]->idle() ) 
+            return false;
+    if( !m_operand_collector.idle() ) 
+        return false;
+    for( unsigned w=0; w < m_config->max_warps_per_shader; w++ ) {
+        shd_warp_t &warp = m_warp[w];
+        if( warp.done_exit() ) 
+            continue;
+        if( warp.hardware_done() && !m_scoreboard->pendingWrites(w) ) 
+            return false; // fetch() reclaims it
+        if( !warp.functional_done() && !warp.imiss_pending() && warp.ibuffer_empty() ) 
+            return false; // fetch() fetches for it
+        if( warp.waiting() ) 
+            continue;
+        if( warp.ibuffer_empty() ) {
+            if( !warp.ibuffer_frag_empty() ) 
+                return false;
+            continue;
+        }
+        const warp_inst_t *pI = warp.ibuffer_next_inst();
+        unsigned pc,rpc;
+        if( !pI || !warp.ibuffer_next_valid() || !m_simt_stack[w]->iter_get_pdom_stack(0,&pc,&rpc) ) 
+            return false;
+        if( pc != pI->pc || !m_scoreboard->checkCollision(w,pI) ) 
+            return false; // control hazard flush or issue
+    }
+    return true;
+}
+
+// Accounts for n cycles skipped while waiting_on_memory()
+void shader_core_ctx::skip_idle_cycles( unsigned long long n )
+{
+    m_L1I->skip_idle_cycles(n);
+    m_ldst_unit->skip_idle_cycles(n);
+}
+
+void shader_core_ctx::checkpoint( FILE *fp ) const
+{
+    m_L1I->checkpoint(fp);
+    m_ldst_unit->checkpoint(fp);
+}
+
+void shader_core_ctx::restore( FILE *fp )
+{
+    m_L1I->restore(fp);
+    m_ldst_unit->restore(fp);
+}
+
 void shader_core_ctx::accept_ldst_unit_response(mem_fetch * mf) 
 {
    m_ldst_unit->fill(mf);
@@ -3146,16 +3437,23 @@ simt_core_cluster::simt_core_cluster( class gpgpu_sim *gpu,
     m_gpu = gpu;
     m_stats = stats;
     m_memory_stats = mstats;
+    m_staged = gpu->get_config().get_sim_threads() > 1;
+    m_core_stats = m_staged ? new shader_core_stats(stats) : stats;
+    m_staged_flits = 0;
+    m_staged_sim_insn = 0;
+    m_staged_last_update_sid = -1;
     m_core = new shader_core_ctx*[ config->n_simt_cores_per_cluster ];
     for( unsigned i=0; i < config->n_simt_cores_per_cluster; i++ ) {
         unsigned sid = m_config->cid_to_sid(i,m_cluster_id);
-        m_core[i] = new shader_core_ctx(gpu,this,sid,m_cluster_id,config,mem_config,stats);
+        m_core[i] = new shader_core_ctx(gpu,this,sid,m_cluster_id,config,mem_config,m_core_stats);
         m_core_sim_order.push_back(i); 
     }
 }
 
 void simt_core_cluster::core_cycle()
 {
+    if( m_staged ) 
+        cuda_printf_set_stage(&m_staged_printf);
     for( std::list<unsigned>::iterator it = m_core_sim_order.begin(); it != m_core_sim_order.end(); ++it ) {
         m_core[*it]->cycle();
     }
@@ -3163,6 +3461,71 @@ void simt_core_cluster::core_cycle()
     if (m_config->simt_core_sim_order == 1) {
         m_core_sim_order.splice(m_core_sim_order.end(), m_core_sim_order, m_core_sim_order.begin()); 
     }
+    if( m_staged ) 
+        cuda_printf_set_stage(NULL);
+}
+
+// Applies the updates to shared state staged by core_cycle() in parallel mode, 
+// in the order the serial simulation would have made them.
+void simt_core_cluster::commit_cycle()
+{
+    if( !m_staged ) 
+        return;
+    m_staged = false;
+    for( unsigned i=0; i < m_staged_packets.size(); i++ ) 
+        icnt_inject_request_packet(m_staged_packets[i]);
+    m_staged_packets.clear();
+    m_staged_flits = 0;
+    // device printf output is interleaved with the CTA completion messages 
+    // as it was produced
+    size_t printf_pos = 0;
+    for( unsigned i=0; i < m_staged_cta_exits.size(); i++ ) {
+        const staged_cta_exit &e = m_staged_cta_exits[i];
+        fwrite(m_staged_printf.data() + printf_pos, 1, e.printf_pos - printf_pos, stdout);
+        printf_pos = e.printf_pos;
+        e.core->register_cta_thread_exit(e.cta_num);
+    }
+    m_staged_cta_exits.clear();
+    fwrite(m_staged_printf.data() + printf_pos, 1, m_staged_printf.size() - printf_pos, stdout);
+    m_staged_printf.clear();
+    m_staged = true;
+
+    m_core_stats->merge_into_parent();
+    m_gpu->gpu_sim_insn += m_staged_sim_insn;
+    m_staged_sim_insn = 0;
+    if( m_staged_last_update_sid >= 0 ) {
+        m_gpu->gpu_sim_insn_last_update_sid = m_staged_last_update_sid;
+        m_gpu->gpu_sim_insn_last_update = gpu_sim_cycle;
+        m_staged_last_update_sid = -1;
+    }
+}
+
+void simt_core_cluster::add_sim_insn( unsigned n )
+{
+    if( m_staged ) 
+        m_staged_sim_insn += n;
+    else 
+        m_gpu->gpu_sim_insn += n;
+}
+
+void simt_core_cluster::sim_insn_last_update( unsigned sid )
+{
+    if( m_staged ) {
+        m_staged_last_update_sid = sid;
+    } else {
+        m_gpu->gpu_sim_insn_last_update_sid = sid;
+        m_gpu->gpu_sim_insn_last_update = gpu_sim_cycle;
+    }
+}
+
+void simt_core_cluster::cta_thread_exit( shader_core_ctx *core, unsigned cta_num )
+{
+    if( m_staged ) {
+        staged_cta_exit e = { core, cta_num, m_staged_printf.size() };
+        m_staged_cta_exits.push_back(e);
+    } else {
+        core->register_cta_thread_exit(cta_num);
+    }
 }
 
 void simt_core_cluster::reinit()
@@ -3232,6 +3595,54 @@ unsigned simt_core_cluster::issue_block2core()
     return num_blocks_issued;
 }
 
+// True if issue_block2core() might launch a CTA in this cycle 
+bool simt_core_cluster::can_issue_block2core()
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) {
+        if( m_core[i]->get_not_completed() == 0 && m_gpu->get_more_cta_left() ) 
+            return true; // may be bound to another kernel
+        kernel_info_t *kernel = m_core[i]->get_kernel();
+        if( kernel && !kernel->no_more_ctas_to_run() && (m_core[i]->get_n_active_cta() < m_config->max_cta(*kernel)) ) 
+            return true;
+    }
+    return false;
+}
+
+bool simt_core_cluster::waiting_on_memory()
+{
+    if( !m_response_fifo.empty() ) 
+        return false;
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        if( !m_core[i]->waiting_on_memory() ) 
+            return false;
+    return true;
+}
+
+// Accounts for n core cycles skipped while waiting_on_memory()
+void simt_core_cluster::skip_idle_cycles( unsigned long long n )
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->skip_idle_cycles(n);
+    if (m_config->simt_core_sim_order == 1) {
+        for( unsigned long long r=0; r < n % m_core_sim_order.size(); r++ ) 
+            m_core_sim_order.splice(m_core_sim_order.end(), m_core_sim_order, m_core_sim_order.begin()); 
+    }
+}
+
+void simt_core_cluster::checkpoint( FILE *fp ) const
+{
+    checkpoint_write_section(fp,"CLST",m_config->n_simt_cores_per_cluster);
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->checkpoint(fp);
+}
+
+void simt_core_cluster::restore( FILE *fp )
+{
+    checkpoint_read_section(fp,"CLST",m_config->n_simt_cores_per_cluster);
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->restore(fp);
+}
+
 void simt_core_cluster::cache_flush()
 {
     for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
@@ -3243,11 +3654,21 @@ bool simt_core_cluster::icnt_injection_buffer_full(unsigned size, bool write)
     unsigned request_size = size;
     if (!write) 
         request_size = READ_PACKET_SIZE;
+    if (m_staged) // account for the packets this cluster has not pushed yet
+        request_size += m_staged_flits * ::icnt_get_flit_size();
     return ! ::icnt_has_buffer(m_cluster_id, request_size);
 }
 
 void simt_core_cluster::icnt_inject_request_packet(class mem_fetch *mf)
 {
+    if (m_staged) {
+        unsigned packet_size = (!mf->get_is_write() && !mf->isatomic())? mf->get_ctrl_size() : mf->size();
+        unsigned flit_size = ::icnt_get_flit_size();
+        m_staged_flits += (packet_size + flit_size - 1) / flit_size;
+        m_staged_packets.push_back(mf);
+        return;
+    }
+
     // stats
     if (mf->get_is_write()) m_stats->made_write_mfs++;
     else m_stats->made_read_mfs++;
@@ -3411,13 +3832,6 @@ void shader_core_ctx::checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned
 {
     if( inst.has_callback(t) ) 
            m_warp[inst.warp_id()].inc_n_atomic();
-        if (inst.space.is_local() && (inst.is_load() || inst.is_store())) {
-            new_addr_type localaddrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
-            unsigned num_addrs;
-            num_addrs = translate_local_memaddr(inst.get_addr(t), tid, m_config->n_simt_clusters*m_config->n_simt_cores_per_cluster,
-                   inst.data_size, (new_addr_type*) localaddrs );
-            inst.set_addr(t, (new_addr_type*) localaddrs, num_addrs);
-        }
         if ( ptx_thread_done(tid) ) {
             m_warp[inst.warp_id()].set_completed(t);
             m_warp[inst.warp_id()].ibuffer_flush();
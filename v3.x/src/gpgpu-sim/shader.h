@@ -41,6 +41,7 @@
 #include <utility>
 #include <algorithm>
 #include <deque>
+#include <string>
 
 //#include "../cuda-sim/ptx.tab.h"
 
@@ -100,6 +101,7 @@ public:
     {
         m_stores_outstanding=0;
         m_inst_in_pipeline=0;
+        m_n_ibuffer_valid=0;
         reset(); 
     }
     void reset()
@@ -175,22 +177,12 @@ public:
 
     //NEW, ibuffer_frag_empty
     //checks through the entire ibuffer to see if it is empty
-    bool ibuffer_frag_empty()
-    {
-        for( unsigned j=0; j < MAX_WARP_FRAGMENTS; j++) 
-        {
-            for( unsigned i=0; i < IBUFFER_SIZE; i++)
-            { 
-                if(m_ibuffer[j][i].m_valid) 
-                    return false;
-            }
-        }
-
-        return true;
-    }
+    bool ibuffer_frag_empty() const { return m_n_ibuffer_valid == 0; }
     void ibuffer_fill( unsigned slot, const warp_inst_t *pI )
     {
        assert(slot < IBUFFER_SIZE );
+       if( !m_ibuffer[m_frag_num][slot].m_valid )
+           m_n_ibuffer_valid++;
        m_ibuffer[m_frag_num][slot].m_inst=pI;
        m_ibuffer[m_frag_num][slot].m_valid=true;
        m_next=0; 
@@ -205,8 +197,10 @@ public:
     void ibuffer_flush()
     {
         for(unsigned i=0;i<IBUFFER_SIZE;i++) {
-            if( m_ibuffer[m_frag_num][i].m_valid )
+            if( m_ibuffer[m_frag_num][i].m_valid ) {
                 dec_inst_in_pipeline();
+                m_n_ibuffer_valid--;
+            }
             m_ibuffer[m_frag_num][i].m_inst=NULL; 
             m_ibuffer[m_frag_num][i].m_valid=false; 
         }
@@ -216,6 +210,8 @@ public:
     //requires new entry frag_num
     void ibuffer_free()
     {
+        if( m_ibuffer[m_frag_num][m_next].m_valid )
+            m_n_ibuffer_valid--;
         m_ibuffer[m_frag_num][m_next].m_inst = NULL;
         m_ibuffer[m_frag_num][m_next].m_valid = false;
     }
@@ -271,6 +267,7 @@ private:
     //NEW, 2D array to store fragment information
     ibuffer_entry m_ibuffer[MAX_WARP_FRAGMENTS][IBUFFER_SIZE]; 
     unsigned m_next;
+    unsigned m_n_ibuffer_valid;    // valid entries across all fragments
                                    
     unsigned m_n_atomic;           // number of outstanding atomic operations 
     bool     m_membar;             // if true, warp is waiting at memory barrier
@@ -328,12 +325,14 @@ public:
                    register_set* sfu_out,
                    register_set* mem_out,
                    int id) 
-        : m_supervised_warps(), m_stats(stats), m_shader(shader),
+        : m_supervised_warps(), m_age_ordered_warps(), m_age_ordered_stamp((unsigned)-1),
+        m_stats(stats), m_shader(shader),
         m_scoreboard(scoreboard), m_simt_stack(simt), /*m_pipeline_reg(pipe_regs),*/ m_warp(warp),
         m_sp_out(sp_out),m_sfu_out(sfu_out),m_mem_out(mem_out), m_id(id){}
     virtual ~scheduler_unit(){}
     virtual void add_supervised_warp_id(int i) {
         m_supervised_warps.push_back(&warp(i));
+        m_supervised_mask.set(i);
     }
     virtual void done_adding_supervised_warps() {
         m_last_supervised_issued = m_supervised_warps.end();
@@ -371,6 +370,18 @@ public:
                             OrderingType age_ordering,
                             bool (*priority_func)(U lhs, U rhs) );
     static bool sort_warps_by_oldest_dynamic_id(shd_warp_t* lhs, shd_warp_t* rhs);
+    static bool sort_warps_by_dynamic_id(shd_warp_t* lhs, shd_warp_t* rhs)
+    {
+        return lhs->get_dynamic_warp_id() < rhs->get_dynamic_warp_id();
+    }
+
+    // Greedy-then-oldest ordering equivalent to order_by_priority() with
+    // sort_warps_by_oldest_dynamic_id, but without the per-cycle copy and sort.
+    // Only warps that can issue this cycle are placed in the result_list; 
+    // they are taken from the core's ready warp masks rather than by 
+    // checking every supervised warp.
+    void order_greedy_then_oldest( std::vector< shd_warp_t* >& result_list,
+                                   unsigned num_warps_to_add );
 
     // Derived classes can override this function to populate
     // m_supervised_warps with their scheduling policies
@@ -394,6 +405,14 @@ protected:
     std::vector< shd_warp_t* > m_supervised_warps;
     // This is the iterator pointer to the last supervised warp you issued
     std::vector< shd_warp_t* >::const_iterator m_last_supervised_issued;
+    // m_supervised_warps sorted by dynamic warp id (oldest first).  Warps only
+    // get a new dynamic id when a CTA is launched on the core, so this is
+    // re-sorted only when the core's dynamic warp id counter has moved.
+    // m_age_rank maps a warp id to its position in that list.
+    std::vector< shd_warp_t* > m_age_ordered_warps;
+    std::vector< unsigned > m_age_rank;
+    unsigned m_age_ordered_stamp;
+    warp_set_t m_supervised_mask;
     shader_core_stats *m_stats;
     shader_core_ctx* m_shader;
     // these things should become accessors: but would need a bigger rearchitect of how shader_core_ctx interacts with its parts.
@@ -544,6 +563,15 @@ public:
         process_banks();
    }
 
+   // no instruction is collecting operands
+   bool idle() const
+   {
+      for( unsigned n=0; n < m_cu.size(); n++ ) 
+         if( !m_cu[n]->is_free() ) 
+            return false;
+      return true;
+   }
+
    void dump( FILE *fp ) const
    {
       fprintf(fp,"\n");
@@ -925,14 +953,14 @@ public:
 
    typedef std::map<unsigned, warp_set_t >  cta_to_warp_t;
 
-   // individual warp hits barrier
-   void warp_reaches_barrier( unsigned cta_id, unsigned warp_id );
+   // individual warp hits barrier, returns the warps it releases (if any)
+   warp_set_t warp_reaches_barrier( unsigned cta_id, unsigned warp_id );
 
    // fetching a warp
    bool available_for_fetch( unsigned warp_id ) const;
 
-   // warp reaches exit 
-   void warp_exit( unsigned warp_id );
+   // warp reaches exit, returns the warps it releases from a barrier (if any)
+   warp_set_t warp_exit( unsigned warp_id );
 
    // assertions
    bool warp_waiting_at_barrier( unsigned warp_id ) const;
@@ -987,6 +1015,7 @@ public:
     virtual unsigned clock_multiplier() const { return 1; }
     virtual bool can_issue( const warp_inst_t &inst ) const { return m_dispatch_reg->empty() && !occupied.test(inst.latency); }
     virtual bool stallable() const = 0;
+    virtual bool idle() const { return m_dispatch_reg->empty() && occupied.none(); }
     virtual void print( FILE *fp ) const
     {
         fprintf(fp,"%s dispatch= ", m_name.c_str() );
@@ -1046,6 +1075,13 @@ public:
     {
         return simd_function_unit::can_issue(inst);
     }
+    virtual bool idle() const
+    {
+        for( unsigned stage=0; stage<m_pipeline_depth; stage++ ) 
+            if( !m_pipeline_reg[stage]->empty() ) 
+                return false;
+        return simd_function_unit::idle();
+    }
     virtual void print(FILE *fp) const
     {
         simd_function_unit::print(fp);
@@ -1122,6 +1158,7 @@ public:
      
     void fill( mem_fetch *mf );
     void flush();
+    void warm_L1D( new_addr_type addr, unsigned time );
     void writeback();
 
     // accessors
@@ -1140,7 +1177,11 @@ public:
 
     virtual void active_lanes_in_pipeline();
     virtual bool stallable() const { return true; }
+    virtual bool idle() const;
     bool response_buffer_full() const;
+    void skip_idle_cycles( unsigned long long n );
+    void checkpoint( FILE *fp ) const;
+    void restore( FILE *fp );
     void print(FILE *fout) const;
     void print_cache_stats( FILE *fp, unsigned& dl1_accesses, unsigned& dl1_misses );
     void get_cache_stats(unsigned &read_accesses, unsigned &write_accesses, unsigned &read_misses, unsigned &write_misses, unsigned cache_type);
@@ -1182,7 +1223,7 @@ protected:
    virtual mem_stage_stall_type process_cache_access( cache_t* cache,
                                                       new_addr_type address,
                                                       warp_inst_t &inst,
-                                                      std::list<cache_event>& events,
+                                                      cache_event_list& events,
                                                       mem_fetch *mf,
                                                       enum cache_request_status status );
    mem_stage_stall_type process_memory_access_queue( cache_t *cache, warp_inst_t &inst );
@@ -1443,6 +1484,7 @@ public:
     shader_core_stats( const shader_core_config *config )
     {
         m_config = config;
+        m_parent = NULL;
         shader_core_stats_pod *pod = reinterpret_cast< shader_core_stats_pod * > ( this->shader_core_stats_pod_start );
         memset(pod,0,sizeof(shader_core_stats_pod));
         shader_cycles=(unsigned long long *) calloc(config->num_shader(),sizeof(unsigned long long ));
@@ -1497,8 +1539,18 @@ public:
         m_shader_warp_slot_issue_distro.resize( config->num_shader() );
     }
 
+    // private view of the statistics for one SIMT core cluster, used when 
+    // clusters are simulated by several host threads: per-shader arrays are 
+    // shared with parent, counters common to all shaders are private and are
+    // added to parent by merge_into_parent()
+    shader_core_stats( shader_core_stats *parent );
+
     ~shader_core_stats()
     {
+        if (m_parent) {
+            free(shader_cycle_distro);
+            return;
+        }
         delete m_outgoing_traffic_stats; 
         delete m_incoming_traffic_stats; 
         free(m_num_sim_insn); 
@@ -1513,6 +1565,7 @@ public:
     }
 
     void event_warp_issued( unsigned s_id, unsigned warp_id, unsigned num_issued, unsigned dynamic_warp_id );
+    void merge_into_parent();
 
     void visualizer_print( gzFile visualizer_file );
 
@@ -1530,6 +1583,7 @@ public:
 
 private:
     const shader_core_config *m_config;
+    shader_core_stats *m_parent; // non-NULL for a per-cluster view
 
     traffic_breakdown *m_outgoing_traffic_stats; // core to memory partitions
     traffic_breakdown *m_incoming_traffic_stats; // memory partition to core 
@@ -1556,6 +1610,12 @@ public:
         m_core_id = core_id;
         m_cluster_id = cluster_id;
         m_memory_config = config;
+        m_last_inst = NULL;
+    }
+    ~shader_core_mem_fetch_allocator()
+    {
+        if( m_last_inst ) 
+            m_last_inst->release();
     }
     mem_fetch *alloc( new_addr_type addr, mem_access_type type, unsigned size, bool wr ) const 
     {
@@ -1572,9 +1632,14 @@ public:
     
     mem_fetch *alloc( const warp_inst_t &inst, const mem_access_t &access ) const
     {
-        warp_inst_t inst_copy = inst;
+        // the accesses of an instruction share one copy of it
+        if( m_last_inst == NULL || m_last_inst->inst().get_uid() != inst.get_uid() ) {
+            if( m_last_inst ) 
+                m_last_inst->release();
+            m_last_inst = new mem_fetch_inst(inst);
+        }
         mem_fetch *mf = new mem_fetch(access, 
-                                      &inst_copy, 
+                                      m_last_inst, 
                                       access.is_write()?WRITE_PACKET_SIZE:READ_PACKET_SIZE,
                                       inst.warp_id(),
                                       m_core_id, 
@@ -1587,6 +1652,7 @@ private:
     unsigned m_core_id;
     unsigned m_cluster_id;
     const memory_config *m_memory_config;
+    mutable mem_fetch_inst *m_last_inst; // instruction of the last alloc() call
 };
 
 class shader_core_ctx : public core_t {
@@ -1606,8 +1672,14 @@ public:
     void reinit(unsigned start_thread, unsigned end_thread, bool reset_not_completed );
     void issue_block2core( class kernel_info_t &kernel );
     void cache_flush();
+    void warm_L1D( new_addr_type addr, unsigned time ) { m_ldst_unit->warm_L1D(addr,time); }
     void accept_fetch_response( mem_fetch *mf );
     void accept_ldst_unit_response( class mem_fetch * mf );
+    void register_cta_thread_exit( unsigned cta_num );
+    void skip_idle_cycles( unsigned long long n );
+    // cache contents at a kernel boundary (-gpgpu_checkpoint_kernel, -gpgpu_resume_kernel)
+    void checkpoint( FILE *fp ) const;
+    void restore( FILE *fp );
     void set_kernel( kernel_info_t *k ) 
     {
         assert(k);
@@ -1620,6 +1692,7 @@ public:
     // accessors
     bool fetch_unit_response_buffer_full() const;
     bool ldst_unit_response_buffer_full() const;
+    bool waiting_on_memory();
     unsigned get_not_completed() const { return m_not_completed; }
     unsigned get_n_active_cta() const { return m_n_active_cta; }
     unsigned isactive() const {if(m_n_active_cta>0) return 1; else return 0;}
@@ -1638,6 +1711,15 @@ public:
     // modifiers
     void mem_instruction_stats(const warp_inst_t &inst);
     void decrement_atomic_count( unsigned wid, unsigned n );
+    // Warps that are neither exited nor blocked (shd_warp_t::waiting()), and 
+    // warps with instructions in their ibuffer.  update_warp_ready() is called
+    // wherever either can change (ibuffer fill and flush, issue, exit, barrier
+    // release, scoreboard release for memory barriers, atomic completion), so
+    // the schedulers find ready warps without polling every warp.
+    void update_warp_ready( unsigned warp_id );
+    void update_warps_ready( const warp_set_t &warps );
+    const warp_set_t &unblocked_warps() const { return m_unblocked_warps; }
+    const warp_set_t &warps_with_inst() const { return m_warps_with_inst; }
     void inc_store_req( unsigned warp_id) { m_warp[warp_id].inc_store_req(); }
     void dec_inst_in_pipeline( unsigned warp_id ) { m_warp[warp_id].dec_inst_in_pipeline(); } // also used in writeback()
     void store_ack( class mem_fetch *mf );
@@ -1778,7 +1860,6 @@ private:
     virtual void checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned t, unsigned tid);
     address_type next_pc( int tid ) const;
     void fetch();
-    void register_cta_thread_exit( unsigned cta_num );
 
     void decode();
     
@@ -1788,6 +1869,7 @@ private:
     friend class LooseRoundRobbinScheduler;
     void issue_warp( register_set& warp, const warp_inst_t *pI, const active_mask_t &active_mask, unsigned warp_id );
     void func_exec_inst( warp_inst_t &inst );
+    void update_simt_stack_trace( unsigned warp_id, warp_inst_t *inst );
 
      // Returns numbers of addresses in translated_addrs
     unsigned translate_local_memaddr( address_type localaddr, unsigned tid, unsigned num_shader, unsigned datasize, new_addr_type* translated_addrs );
@@ -1834,6 +1916,8 @@ private:
     // decode/dispatch
     std::vector<shd_warp_t>   m_warp;   // per warp information array
     barrier_set_t             m_barriers;
+    warp_set_t                m_unblocked_warps;
+    warp_set_t                m_warps_with_inst;
     ifetch_buffer_t           m_inst_fetch_buffer;
     std::vector<register_set> m_pipeline_reg;
     Scoreboard               *m_scoreboard;
@@ -1860,6 +1944,11 @@ private:
     // is that the dynamic_warp_id is a running number unique to every warp
     // run on this shader, where the warp_id is the static warp slot.
     unsigned m_dynamic_warp_id;
+
+    // warp trace recording/replay (-gpgpu_warp_trace_record, -gpgpu_warp_trace_replay), 
+    // NULL if neither is enabled; one stream per running warp
+    class warp_trace *m_warp_trace;
+    std::vector<class warp_trace_stream*> m_warp_trace_stream;
 };
 
 class simt_core_cluster {
@@ -1873,10 +1962,17 @@ public:
 
     void core_cycle();
     void icnt_cycle();
+    void commit_cycle();
 
     void reinit();
     unsigned issue_block2core();
+    bool can_issue_block2core();
     void cache_flush();
+    void warm_L1D( unsigned sid, new_addr_type addr, unsigned time ) { m_core[m_config->sid_to_cid(sid)]->warm_L1D(addr,time); }
+    bool waiting_on_memory();
+    void skip_idle_cycles( unsigned long long n );
+    void checkpoint( FILE *fp ) const;
+    void restore( FILE *fp );
     bool icnt_injection_buffer_full(unsigned size, bool write);
     void icnt_inject_request_packet(class mem_fetch *mf);
 
@@ -1907,6 +2003,11 @@ public:
 
     void get_icnt_stats(long &n_simt_to_mem, long &n_mem_to_simt) const;
 
+    // used by the shader cores of this cluster for state shared with other clusters 
+    void add_sim_insn( unsigned n );
+    void sim_insn_last_update( unsigned sid );
+    void cta_thread_exit( shader_core_ctx *core, unsigned cta_num );
+
 private:
     unsigned m_cluster_id;
     gpgpu_sim *m_gpu;
@@ -1918,6 +2019,23 @@ private:
     unsigned m_cta_issue_next_core;
     std::list<unsigned> m_core_sim_order;
     std::list<mem_fetch*> m_response_fifo;
+
+    // parallel simulation (-gpgpu_sim_threads > 1): while core_cycle() runs 
+    // concurrently with other clusters, updates to shared state are staged 
+    // here and applied by commit_cycle(), which is called in cluster order 
+    bool m_staged;
+    shader_core_stats *m_core_stats; // statistics seen by the cores (m_stats or a private view)
+    std::vector<mem_fetch*> m_staged_packets;
+    unsigned m_staged_flits;
+    struct staged_cta_exit {
+        shader_core_ctx *core;
+        unsigned cta_num;
+        size_t printf_pos; // length of m_staged_printf when the thread exited
+    };
+    std::vector<staged_cta_exit> m_staged_cta_exits;
+    unsigned long long m_staged_sim_insn;
+    int m_staged_last_update_sid;
+    std::string m_staged_printf; // device printf output
 };
 
 class shader_memory_interface : public mem_fetch_interface {
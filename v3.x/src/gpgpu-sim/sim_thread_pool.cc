@@ -0,0 +1,156 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "sim_thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sched.h>
+
+// polls before a waiting thread starts yielding its cpu, and before an idle 
+// worker goes to sleep
+#define SIM_THREAD_POOL_SPIN_LIMIT 256
+#define SIM_THREAD_POOL_SLEEP_LIMIT 20000
+
+// busy-wait step; yields once spinning is unlikely to pay off (e.g. when 
+// there are more simulation threads than host cpus)
+static inline void spin_wait( unsigned &spins )
+{
+   if( spins++ < SIM_THREAD_POOL_SPIN_LIMIT ) {
+#if defined(__i386__) || defined(__x86_64__)
+      __asm__ __volatile__ ( "pause" ::: "memory" );
+#else
+      __sync_synchronize();
+#endif
+   } else {
+      sched_yield();
+   }
+}
+
+sim_thread_pool::sim_thread_pool( unsigned n_threads )
+{
+   assert( n_threads >= 1 );
+   m_n_threads = n_threads;
+   m_fn = NULL;
+   m_arg = NULL;
+   m_n_tasks = 0;
+   m_next_task = 0;
+   m_busy_workers = 0;
+   m_generation = 0;
+   m_sleeping_workers = 0;
+   m_shutdown = false;
+   pthread_mutex_init(&m_mutex,NULL);
+   pthread_cond_init(&m_wakeup,NULL);
+   m_workers = new pthread_t[m_n_threads];
+   for( unsigned t=1; t < m_n_threads; t++ ) {
+      if( pthread_create(&m_workers[t],NULL,worker_main,this) ) {
+         printf("GPGPU-Sim uArch: ERROR ** could not create simulation thread %u\n", t);
+         abort();
+      }
+   }
+}
+
+sim_thread_pool::~sim_thread_pool()
+{
+   pthread_mutex_lock(&m_mutex);
+   m_shutdown = true;
+   pthread_cond_broadcast(&m_wakeup);
+   pthread_mutex_unlock(&m_mutex);
+   for( unsigned t=1; t < m_n_threads; t++ ) 
+      pthread_join(m_workers[t],NULL);
+   delete[] m_workers;
+   pthread_cond_destroy(&m_wakeup);
+   pthread_mutex_destroy(&m_mutex);
+}
+
+void sim_thread_pool::run( task_fn_t fn, void *arg, unsigned n_tasks )
+{
+   if( m_n_threads == 1 || n_tasks <= 1 ) {
+      for( unsigned t=0; t < n_tasks; t++ ) 
+         fn(arg,t);
+      return;
+   }
+   m_fn = fn;
+   m_arg = arg;
+   m_n_tasks = n_tasks;
+   m_next_task = 0;
+   m_busy_workers = m_n_threads - 1;
+   __sync_add_and_fetch(&m_generation,1); // full barrier: publishes the batch
+   if( m_sleeping_workers ) {
+      pthread_mutex_lock(&m_mutex);
+      pthread_cond_broadcast(&m_wakeup);
+      pthread_mutex_unlock(&m_mutex);
+   }
+   work();
+   unsigned spins = 0;
+   while( m_busy_workers ) 
+      spin_wait(spins);
+   __sync_synchronize();
+}
+
+void *sim_thread_pool::worker_main( void *pool )
+{
+   ((sim_thread_pool*)pool)->worker_loop();
+   return NULL;
+}
+
+void sim_thread_pool::worker_loop()
+{
+   unsigned seen = 0;
+   while( 1 ) {
+      unsigned spins = 0;
+      while( m_generation == seen && !m_shutdown ) {
+         if( spins < SIM_THREAD_POOL_SLEEP_LIMIT ) {
+            spin_wait(spins);
+            continue;
+         }
+         pthread_mutex_lock(&m_mutex);
+         __sync_add_and_fetch(&m_sleeping_workers,1);
+         while( m_generation == seen && !m_shutdown ) 
+            pthread_cond_wait(&m_wakeup,&m_mutex);
+         __sync_sub_and_fetch(&m_sleeping_workers,1);
+         pthread_mutex_unlock(&m_mutex);
+      }
+      if( m_shutdown ) 
+         return;
+      __sync_synchronize();
+      seen = m_generation;
+      work();
+      __sync_sub_and_fetch(&m_busy_workers,1);
+   }
+}
+
+void sim_thread_pool::work()
+{
+   while( 1 ) {
+      unsigned t = __sync_fetch_and_add(&m_next_task,1);
+      if( t >= m_n_tasks ) 
+         break;
+      m_fn(m_arg,t);
+   }
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SIM_THREAD_POOL_H
+#define SIM_THREAD_POOL_H
+
+#include <pthread.h>
+
+// A small pool of host threads used to simulate independent hardware units 
+// (SIMT core clusters, L2 sub-partitions) of the same clock edge in parallel.
+// run() hands out task ids dynamically and returns once all of them have been
+// executed; the calling thread participates, so a pool of N threads creates 
+// N-1 workers. Workers spin between cycles and sleep when the GPU is idle. 
+class sim_thread_pool {
+public:
+   typedef void (*task_fn_t)( void *arg, unsigned task_id );
+
+   sim_thread_pool( unsigned n_threads );
+   ~sim_thread_pool();
+
+   void run( task_fn_t fn, void *arg, unsigned n_tasks );
+   unsigned num_threads() const { return m_n_threads; }
+
+private:
+   static void *worker_main( void *pool );
+   void worker_loop();
+   void work();
+
+   unsigned m_n_threads;
+   pthread_t *m_workers;
+
+   // current batch of tasks
+   task_fn_t m_fn;
+   void *m_arg;
+   unsigned m_n_tasks;
+   volatile unsigned m_next_task;
+   volatile unsigned m_busy_workers;
+
+   // workers start a batch when m_generation changes 
+   volatile unsigned m_generation;
+   volatile unsigned m_sleeping_workers;
+   volatile bool m_shutdown;
+   pthread_mutex_t m_mutex;
+   pthread_cond_t m_wakeup;
+};
+
+#endif
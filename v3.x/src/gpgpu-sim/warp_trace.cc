@@ -0,0 +1,374 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "warp_trace.h"
+#include "../cuda-sim/cuda-sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static const char warp_trace_magic[8] = { 'G','P','U','W','T','R','C','2' };
+
+// CTA id field of a block holding a device-to-host copy instead of a warp
+static const unsigned long long warp_trace_readback_cta = 0xFFFFFFFF;
+
+enum warp_trace_flags {
+   WARP_TRACE_ADDRS  = 0x1, // memory space, access size and per-lane addresses follow
+   WARP_TRACE_ATOMIC = 0x2
+};
+
+static inline unsigned long long zigzag( long long v ) { return ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63); }
+static inline long long unzigzag( unsigned long long v ) { return (long long)(v >> 1) ^ -(long long)(v & 1); }
+
+void warp_trace_stream::put( unsigned long long v )
+{
+   while( v >= 0x80 ) {
+      m_data.push_back( (unsigned char)(v | 0x80) );
+      v >>= 7;
+   }
+   m_data.push_back( (unsigned char)v );
+}
+
+unsigned long long warp_trace_stream::get()
+{
+   unsigned long long v = 0;
+   for( unsigned shift=0; ; shift += 7 ) {
+      if( m_pos == m_data.size() ) {
+         printf("GPGPU-Sim uArch: ERROR ** warp trace of kernel %u, CTA %u, warp %u ends before the warp exits\n",
+                m_kernel_uid, m_cta_id, m_warp_id );
+         abort();
+      }
+      unsigned char b = m_data[m_pos++];
+      v |= (unsigned long long)(b & 0x7f) << shift;
+      if( !(b & 0x80) ) 
+         return v;
+   }
+}
+
+void warp_trace_stream::record_exec( const warp_inst_t &inst )
+{
+   const active_mask_t &active = inst.get_active_mask();
+   unsigned flags = 0;
+   if( (inst.is_load() || inst.is_store()) && active.any() ) 
+      flags |= WARP_TRACE_ADDRS;
+   if( inst.isatomic() ) 
+      flags |= WARP_TRACE_ATOMIC;
+   put( inst.pc );
+   put( active.to_ulong() );
+   put( flags );
+   if( flags & WARP_TRACE_ADDRS ) {
+      put( inst.space.get_type() );
+      put( inst.space.get_bank() );
+      put( inst.data_size );
+      new_addr_type last = 0;
+      for( unsigned t=0; t < inst.warp_size(); t++ ) {
+         if( !active.test(t) ) 
+            continue;
+         put( zigzag( (long long)(inst.get_addr(t) - last) ) );
+         last = inst.get_addr(t);
+      }
+   }
+}
+
+void warp_trace_stream::replay_exec( warp_inst_t &inst )
+{
+   address_type pc = get();
+   if( pc != inst.pc ) {
+      printf("GPGPU-Sim uArch: ERROR ** warp trace of kernel %u, CTA %u, warp %u is out of sync "
+             "(issued pc=0x%04x, traced pc=0x%04llx)\n", m_kernel_uid, m_cta_id, m_warp_id, inst.pc, (unsigned long long)pc );
+      abort();
+   }
+   active_mask_t active( get() );
+   unsigned flags = get();
+   active_mask_t predicated_off = inst.get_active_mask() & ~active;
+   if( predicated_off.any() ) 
+      inst.clear_active( predicated_off );
+   if( flags & WARP_TRACE_ATOMIC ) {
+      // the atomic is timed but not performed: there is no thread to call back
+      for( unsigned t=0; t < inst.warp_size(); t++ ) 
+         if( active.test(t) ) 
+            inst.add_callback( t, NULL, NULL, NULL );
+   }
+   if( flags & WARP_TRACE_ADDRS ) {
+      memory_space_t space( (enum _memory_space_t)get() );
+      space.set_bank( get() );
+      inst.space = space;
+      inst.data_size = get();
+      new_addr_type last = 0;
+      for( unsigned t=0; t < inst.warp_size(); t++ ) {
+         if( !active.test(t) ) 
+            continue;
+         last += unzigzag( get() );
+         inst.set_addr( t, last );
+      }
+   }
+}
+
+void warp_trace_stream::record_simt( const warp_inst_t &inst, bool return_rpc, const simt_mask_t &thread_done, const addr_vector_t &next_pc )
+{
+   // lanes that do not fall through are grouped by target
+   address_type fallthrough = inst.pc + inst.isize;
+   address_type target[MAX_WARP_SIZE];
+   unsigned long mask[MAX_WARP_SIZE];
+   unsigned n_targets = 0;
+   for( unsigned t=0; t < inst.warp_size(); t++ ) {
+      if( thread_done.test(t) || next_pc[t] == fallthrough ) 
+         continue;
+      unsigned i;
+      for( i=0; i < n_targets && target[i] != next_pc[t]; i++ ) 
+         ;
+      if( i == n_targets ) {
+         target[n_targets] = next_pc[t];
+         mask[n_targets++] = 0;
+      }
+      mask[i] |= 1UL << t;
+   }
+   put( thread_done.to_ulong() );
+   put( n_targets );
+   for( unsigned i=0; i < n_targets; i++ ) {
+      put( target[i] );
+      put( mask[i] );
+   }
+   if( return_rpc ) 
+      put( inst.reconvergence_pc );
+}
+
+void warp_trace_stream::replay_simt( warp_inst_t &inst, simt_mask_t &thread_done, addr_vector_t &next_pc )
+{
+   thread_done = simt_mask_t( get() );
+   address_type fallthrough = inst.pc + inst.isize;
+   next_pc.resize( inst.warp_size() );
+   for( unsigned t=0; t < inst.warp_size(); t++ ) 
+      next_pc[t] = thread_done.test(t) ? (address_type)-1 : fallthrough;
+   unsigned n_targets = get();
+   for( unsigned i=0; i < n_targets; i++ ) {
+      address_type target = get();
+      unsigned long mask = get();
+      for( unsigned t=0; t < inst.warp_size(); t++ ) 
+         if( mask & (1UL << t) ) 
+            next_pc[t] = target;
+   }
+   if( inst.reconvergence_pc == RECONVERGE_RETURN_PC ) 
+      inst.reconvergence_pc = get();
+}
+
+warp_trace::warp_trace( const char *filename, bool replay, unsigned warp_size )
+{
+   m_filename = filename;
+   m_replay = replay;
+   pthread_mutex_init(&m_mutex,NULL);
+   m_file = gzopen( filename, replay ? "rb" : "wb" );
+   if( m_file == NULL ) {
+      printf("GPGPU-Sim uArch: ERROR ** cannot open warp trace \'%s\' for %s\n", filename, replay ? "reading" : "writing" );
+      abort();
+   }
+   if( replay ) {
+      char magic[sizeof(warp_trace_magic)];
+      unsigned long long traced_warp_size = 0;
+      if( gzread(m_file,magic,sizeof(magic)) != (int)sizeof(magic) || memcmp(magic,warp_trace_magic,sizeof(magic)) 
+          || !read_varint(traced_warp_size) ) {
+         printf("GPGPU-Sim uArch: ERROR ** \'%s\' is not a warp trace\n", filename );
+         abort();
+      }
+      if( traced_warp_size != warp_size ) {
+         printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' was recorded with warp size %llu (configured %u)\n", 
+                filename, traced_warp_size, warp_size );
+         abort();
+      }
+   } else {
+      gzwrite(m_file,warp_trace_magic,sizeof(warp_trace_magic));
+      write_varint(warp_size);
+   }
+   printf("GPGPU-Sim uArch: %s warp trace \'%s\'\n", replay ? "replaying" : "recording", filename );
+}
+
+warp_trace::~warp_trace()
+{
+   gzclose(m_file);
+   for( std::map<key_t,warp_trace_stream*>::iterator i=m_pending.begin(); i != m_pending.end(); ++i ) 
+      delete i->second;
+   pthread_mutex_destroy(&m_mutex);
+}
+
+bool warp_trace::read_varint( unsigned long long &v )
+{
+   v = 0;
+   for( unsigned shift=0; ; shift += 7 ) {
+      int b = gzgetc(m_file);
+      if( b < 0 ) {
+         if( shift == 0 ) 
+            return false;
+         printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' is truncated\n", m_filename );
+         abort();
+      }
+      v |= (unsigned long long)(b & 0x7f) << shift;
+      if( !(b & 0x80) ) 
+         return true;
+   }
+}
+
+void warp_trace::write_varint( unsigned long long v )
+{
+   unsigned char buf[10];
+   unsigned n = 0;
+   while( v >= 0x80 ) {
+      buf[n++] = (unsigned char)(v | 0x80);
+      v >>= 7;
+   }
+   buf[n++] = (unsigned char)v;
+   gzwrite(m_file,buf,n);
+}
+
+// returns the next warp block; copies found on the way are queued in m_readbacks
+warp_trace_stream *warp_trace::read_block()
+{
+   unsigned long long kernel_uid, cta_id, warp_id, size;
+   for(;;) {
+      if( !read_varint(kernel_uid) ) 
+         return NULL;
+      if( !read_varint(cta_id) || !read_varint(warp_id) || !read_varint(size) ) {
+         printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' is truncated\n", m_filename );
+         abort();
+      }
+      if( cta_id != warp_trace_readback_cta ) 
+         break;
+      // warp_id holds the device address of the copy
+      m_readbacks.push_back(readback_t());
+      readback_t &r = m_readbacks.back();
+      r.kernel_uid = kernel_uid;
+      r.addr = warp_id;
+      r.data.resize(size);
+      if( size && gzread(m_file,&r.data[0],size) != (int)size ) {
+         printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' is truncated\n", m_filename );
+         abort();
+      }
+   }
+   warp_trace_stream *stream = new warp_trace_stream(kernel_uid,cta_id,warp_id);
+   stream->m_data.resize(size);
+   if( size && gzread(m_file,&stream->m_data[0],size) != (int)size ) {
+      printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' is truncated\n", m_filename );
+      abort();
+   }
+   return stream;
+}
+
+warp_trace_stream *warp_trace::begin_warp( unsigned kernel_uid, unsigned cta_id, unsigned warp_id )
+{
+   if( !m_replay ) 
+      return new warp_trace_stream(kernel_uid,cta_id,warp_id);
+
+   pthread_mutex_lock(&m_mutex);
+   key_t key(kernel_uid,cta_id,warp_id);
+   std::map<key_t,warp_trace_stream*>::iterator i = m_pending.find(key);
+   warp_trace_stream *stream = NULL;
+   if( i != m_pending.end() ) {
+      stream = i->second;
+      m_pending.erase(i);
+   } else {
+      while( (stream = read_block()) != NULL ) {
+         key_t k(stream->m_kernel_uid,stream->m_cta_id,stream->m_warp_id);
+         if( !(k < key) && !(key < k) ) 
+            break;
+         m_pending[k] = stream;
+      }
+   }
+   pthread_mutex_unlock(&m_mutex);
+   if( stream == NULL ) {
+      printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' has no record of kernel %u, CTA %u, warp %u\n", 
+             m_filename, kernel_uid, cta_id, warp_id );
+      abort();
+   }
+   return stream;
+}
+
+void warp_trace::end_warp( warp_trace_stream *stream )
+{
+   if( m_replay ) {
+      if( !stream->replay_done() ) {
+         printf("GPGPU-Sim uArch: ERROR ** kernel %u, CTA %u, warp %u exited before the end of its warp trace\n", 
+                stream->m_kernel_uid, stream->m_cta_id, stream->m_warp_id );
+         abort();
+      }
+   } else {
+      pthread_mutex_lock(&m_mutex);
+      write_varint(stream->m_kernel_uid);
+      write_varint(stream->m_cta_id);
+      write_varint(stream->m_warp_id);
+      write_varint(stream->m_data.size());
+      if( !stream->m_data.empty() ) 
+         gzwrite(m_file,&stream->m_data[0],stream->m_data.size());
+      pthread_mutex_unlock(&m_mutex);
+   }
+   delete stream;
+}
+
+void warp_trace::record_readback( unsigned kernel_uid, const void *data, size_t addr, size_t count )
+{
+   assert( !m_replay );
+   pthread_mutex_lock(&m_mutex);
+   write_varint(kernel_uid);
+   write_varint(warp_trace_readback_cta);
+   write_varint(addr);
+   write_varint(count);
+   if( count ) 
+      gzwrite(m_file,data,count);
+   pthread_mutex_unlock(&m_mutex);
+}
+
+void warp_trace::replay_readback( unsigned kernel_uid, void *dst, size_t addr, size_t count )
+{
+   assert( m_replay );
+   pthread_mutex_lock(&m_mutex);
+   while( m_readbacks.empty() ) {
+      warp_trace_stream *stream = read_block();
+      if( stream == NULL ) 
+         break;
+      m_pending[key_t(stream->m_kernel_uid,stream->m_cta_id,stream->m_warp_id)] = stream;
+   }
+   if( m_readbacks.empty() || m_readbacks.front().kernel_uid != kernel_uid || 
+       m_readbacks.front().addr != addr || m_readbacks.front().data.size() != count ) {
+      printf("GPGPU-Sim uArch: ERROR ** warp trace \'%s\' has no record of the device-to-host copy of %zu bytes "
+             "from 0x%llx after kernel %u\n", m_filename, count, (unsigned long long)addr, kernel_uid );
+      abort();
+   }
+   if( count ) 
+      memcpy(dst,&m_readbacks.front().data[0],count);
+   m_readbacks.pop_front();
+   pthread_mutex_unlock(&m_mutex);
+}
+
+void warp_trace::flush()
+{
+   if( m_replay ) 
+      return;
+   pthread_mutex_lock(&m_mutex);
+   gzflush(m_file,Z_FINISH);
+   pthread_mutex_unlock(&m_mutex);
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef WARP_TRACE_H
+#define WARP_TRACE_H
+
+#include <pthread.h>
+#include <zlib.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "../abstract_hardware_model.h"
+
+// Dynamic instruction stream of one warp, recorded with 
+// -gpgpu_warp_trace_record and fed back to the timing model with 
+// -gpgpu_warp_trace_replay in place of functional execution. For every issued
+// instruction it holds the pc, the active mask after predication, the memory 
+// space, access size and per-lane addresses of memory instructions and the 
+// per-lane next pc and exit mask used to update the SIMT stack. Values are 
+// varint coded; local memory addresses are stored before they are mapped to 
+// the core, so a trace may be replayed on a differently sized GPU. 
+class warp_trace_stream {
+public:
+   warp_trace_stream( unsigned kernel_uid, unsigned cta_id, unsigned warp_id ) 
+   { 
+      m_kernel_uid = kernel_uid;
+      m_cta_id = cta_id;
+      m_warp_id = warp_id;
+      m_pos = 0; 
+   }
+
+   // recording, called after the instruction is functionally executed and
+   // again once the SIMT stack update has been collected 
+   void record_exec( const warp_inst_t &inst );
+   void record_simt( const warp_inst_t &inst, bool return_rpc, const simt_mask_t &thread_done, const addr_vector_t &next_pc );
+
+   // replay: restores into an issued copy of the static instruction what 
+   // the matching record_*() call saw
+   void replay_exec( warp_inst_t &inst );
+   void replay_simt( warp_inst_t &inst, simt_mask_t &thread_done, addr_vector_t &next_pc );
+   bool replay_done() const { return m_pos == m_data.size(); }
+
+private:
+   friend class warp_trace;
+
+   void put( unsigned long long v );
+   unsigned long long get();
+
+   unsigned m_kernel_uid;
+   unsigned m_cta_id;
+   unsigned m_warp_id; // warp within the CTA
+
+   std::vector<unsigned char> m_data;
+   size_t m_pos; // replay read position
+};
+
+// gzip compressed trace file: a header followed by one block per warp, 
+// appended when the warp exits (i.e., in completion order, which depends on 
+// the configuration), and one block per device-to-host copy. Replay reads 
+// ahead until the block of a newly launched warp (or the next copy) is found
+// and holds blocks it does not need yet. Warp blocks are identified by 
+// (kernel uid, linear CTA id, warp within CTA), so the replayed application 
+// must launch the same kernels in the same order. 
+class warp_trace {
+public:
+   warp_trace( const char *filename, bool replay, unsigned warp_size );
+   ~warp_trace();
+
+   bool replaying() const { return m_replay; }
+
+   // both are thread safe (cores may be simulated by several host threads)
+   warp_trace_stream *begin_warp( unsigned kernel_uid, unsigned cta_id, unsigned warp_id );
+   void end_warp( warp_trace_stream *stream );
+
+   // device-to-host copies: global stores are not performed during replay,
+   // so the data the application copied back after each kernel is recorded 
+   // in the trace and returned again in the same order
+   void record_readback( unsigned kernel_uid, const void *data, size_t addr, size_t count );
+   void replay_readback( unsigned kernel_uid, void *dst, size_t addr, size_t count );
+
+   // completes the gzip stream at kernel boundaries so the trace stays 
+   // readable if the application does not exit cleanly
+   void flush();
+
+private:
+   struct key_t {
+      key_t( unsigned k, unsigned c, unsigned w ) { kernel_uid=k; cta_id=c; warp_id=w; }
+      bool operator<( const key_t &x ) const
+      {
+         if( kernel_uid != x.kernel_uid ) return kernel_uid < x.kernel_uid;
+         if( cta_id != x.cta_id ) return cta_id < x.cta_id;
+         return warp_id < x.warp_id;
+      }
+      unsigned kernel_uid;
+      unsigned cta_id;
+      unsigned warp_id;
+   };
+
+   struct readback_t {
+      unsigned kernel_uid; // last kernel launched before the copy
+      size_t addr;
+      std::vector<unsigned char> data;
+   };
+
+   warp_trace_stream *read_block();
+   bool read_varint( unsigned long long &v );
+   void write_varint( unsigned long long v );
+
+   const char *m_filename;
+   bool m_replay;
+   gzFile m_file;
+   std::map<key_t,warp_trace_stream*> m_pending; // blocks read ahead during replay
+   std::deque<readback_t> m_readbacks; // copies read ahead during replay
+   pthread_mutex_t m_mutex;
+};
+
+#endif
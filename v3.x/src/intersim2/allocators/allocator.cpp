@@ -259,8 +259,33 @@ SparseAllocator::SparseAllocator( Module *parent, const string& name,
 				  int inputs, int outputs ) :
   Allocator( parent, name, inputs, outputs )
 {
+  _in_occ.Resize(_inputs);
+  _out_occ.Resize(_outputs);
   _in_req.resize(_inputs);
+  for ( int i = 0; i < _inputs; ++i ) {
+    _in_req[i].Resize(_outputs);
+  }
   _out_req.resize(_outputs);
+  for ( int j = 0; j < _outputs; ++j ) {
+    _out_req[j].Resize(_inputs);
+  }
+}
+
+int SparseAllocator::PortMask::Next( int port ) const
+{
+  ++port;
+  int w = port >> 6;
+  if ( w >= (int)_bits.size( ) ) {
+    return -1;
+  }
+  unsigned long long m = _bits[w] & ( ~0ULL << ( port & 63 ) );
+  while ( !m ) {
+    if ( ++w == (int)_bits.size( ) ) {
+      return -1;
+    }
+    m = _bits[w];
+  }
+  return ( w << 6 ) + __builtin_ctzll( m );
 }
 
 
@@ -300,7 +325,7 @@ bool SparseAllocator::ReadRequest( sRequest &req, int in, int out ) const
   assert( ( in >= 0 ) && ( in < _inputs ) );
   assert( ( out >= 0 ) && ( out < _outputs ) );
 
-  map<int, sRequest>::const_iterator match = _in_req[in].find(out);
+  RequestMap::const_iterator match = _in_req[in].find(out);
   if ( match != _in_req[in].end( ) ) {
     req = match->second;
     found = true;
@@ -389,7 +414,7 @@ int SparseAllocator::NumOutputRequests( int out ) const
 
 void SparseAllocator::PrintRequests( ostream * os ) const
 {
-  map<int, sRequest>::const_iterator iter;
+  RequestMap::const_iterator iter;
   
   if(!os) os = &cout;
   
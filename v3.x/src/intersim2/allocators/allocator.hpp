@@ -126,11 +126,108 @@ public:
 
 class SparseAllocator : public Allocator {
 protected:
-  set<int> _in_occ;
-  set<int> _out_occ;
+  // The occupied ports and the requests of each port are kept in arrays 
+  // sized when the allocator is built plus a bitmask of the valid entries, 
+  // so adding and removing requests does not allocate.  Both containers 
+  // iterate in ascending port order like the std::set/std::map they replace.
+  class PortMask {
+  public:
+    PortMask( ) : _size(0) {}
+    void Resize( int ports ) { _bits.assign( ( ports + 63 ) / 64, 0ULL ); _size = 0; }
+    bool Test( int port ) const { return ( _bits[port >> 6] >> ( port & 63 ) ) & 1; }
+    void Set( int port ) 
+    {
+      if ( !Test( port ) ) {
+        _bits[port >> 6] |= 1ULL << ( port & 63 );
+        ++_size;
+      }
+    }
+    void Reset( int port ) 
+    {
+      if ( Test( port ) ) {
+        _bits[port >> 6] &= ~( 1ULL << ( port & 63 ) );
+        --_size;
+      }
+    }
+    void ResetAll( ) { _bits.assign( _bits.size( ), 0ULL ); _size = 0; }
+    int Count( ) const { return _size; }
+    // lowest valid port above port (the lowest one for -1), -1 if there is none
+    int Next( int port ) const;
+  private:
+    vector<unsigned long long> _bits;
+    int _size;
+  };
+
+  class PortSet : public PortMask {
+  public:
+    class const_iterator {
+    public:
+      const_iterator( const PortMask * m = NULL, int p = -1 ) : _m(m), _p(p) {}
+      int operator*( ) const { return _p; }
+      const_iterator & operator++( ) { _p = _m->Next( _p ); return *this; }
+      bool operator==( const const_iterator & x ) const { return _p == x._p; }
+      bool operator!=( const const_iterator & x ) const { return _p != x._p; }
+    private:
+      const PortMask * _m;
+      int _p;
+    };
+    const_iterator begin( ) const { return const_iterator( this, Next( -1 ) ); }
+    const_iterator end( ) const { return const_iterator( this, -1 ); }
+    void insert( int port ) { Set( port ); }
+    void erase( int port ) { Reset( port ); }
+    int count( int port ) const { return Test( port ); }
+    void clear( ) { ResetAll( ); }
+  };
+
+  class RequestMap : public PortMask {
+  public:
+    typedef pair<int, sRequest> value_type;
+    // iterator over the valid entries; V is value_type or value_type const
+    template<class V> struct basic_iterator {
+      basic_iterator( V * e = NULL, const PortMask * m = NULL, int p = -1 ) : _e(e), _m(m), _p(p) {}
+      template<class W> basic_iterator( const basic_iterator<W> & x ) : _e(x._e), _m(x._m), _p(x._p) {}
+      V & operator*( ) const { return _e[_p]; }
+      V * operator->( ) const { return &_e[_p]; }
+      basic_iterator & operator++( ) { _p = _m->Next( _p ); return *this; }
+      basic_iterator operator++( int ) { basic_iterator i = *this; _p = _m->Next( _p ); return i; }
+      bool operator==( const basic_iterator & x ) const { return _p == x._p; }
+      bool operator!=( const basic_iterator & x ) const { return _p != x._p; }
+      V * _e;
+      const PortMask * _m;
+      int _p;
+    };
+    typedef basic_iterator<value_type> iterator;
+    typedef basic_iterator<value_type const> const_iterator;
+
+    void Resize( int ports ) 
+    {
+      PortMask::Resize( ports );
+      _entries.resize( ports );
+      for ( int p = 0; p < ports; ++p ) {
+        _entries[p].first = p;
+      }
+    }
+    iterator begin( ) { return iterator( _Data( ), this, Next( -1 ) ); }
+    iterator end( ) { return iterator( _Data( ), this, -1 ); }
+    const_iterator begin( ) const { return const_iterator( _Data( ), this, Next( -1 ) ); }
+    const_iterator end( ) const { return const_iterator( _Data( ), this, -1 ); }
+    const_iterator find( int port ) const { return const_iterator( _Data( ), this, Test( port ) ? port : -1 ); }
+    int count( int port ) const { return Test( port ); }
+    bool empty( ) const { return Count( ) == 0; }
+    sRequest & operator[]( int port ) { Set( port ); return _entries[port].second; }
+    void erase( int port ) { Reset( port ); }
+    void clear( ) { ResetAll( ); }
+  private:
+    value_type * _Data( ) { return _entries.empty( ) ? NULL : &_entries[0]; }
+    value_type const * _Data( ) const { return _entries.empty( ) ? NULL : &_entries[0]; }
+    vector<value_type> _entries;
+  };
+
+  PortSet _in_occ;
+  PortSet _out_occ;
   
-  vector<map<int, sRequest> > _in_req;
-  vector<map<int, sRequest> > _out_req;
+  vector<RequestMap> _in_req;
+  vector<RequestMap> _out_req;
 
 public:
   SparseAllocator( Module *parent, const string& name,
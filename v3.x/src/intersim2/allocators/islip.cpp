@@ -50,7 +50,7 @@ void iSLIP_Sparse::Allocate( )
   int input_offset;
   int output_offset;
 
-  map<int, sRequest>::iterator p;
+  RequestMap::iterator p;
   bool wrapped;
 
   for ( int iter = 0; iter < _iSLIP_iter; ++iter ) {
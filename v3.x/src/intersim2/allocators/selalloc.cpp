@@ -52,8 +52,8 @@ void SelAlloc::Allocate( )
   int input_offset;
   int output_offset;
 
-  map<int, sRequest>::iterator p;
-  set<int>::iterator outer_iter;
+  RequestMap::iterator p;
+  PortSet::const_iterator outer_iter;
   bool wrapped;
 
   int max_index;
@@ -222,7 +222,7 @@ void SelAlloc::MaskOutput( int out, int mask )
 
 void SelAlloc::PrintRequests( ostream * os ) const
 {
-  map<int, sRequest>::const_iterator iter;
+  RequestMap::const_iterator iter;
   
   if(!os) os = &cout;
   
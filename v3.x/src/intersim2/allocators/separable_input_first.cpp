@@ -48,14 +48,14 @@ SeparableInputFirstAllocator( Module* parent, const string& name, int inputs,
 
 void SeparableInputFirstAllocator::Allocate() {
   
-  set<int>::const_iterator port_iter = _in_occ.begin();
+  PortSet::const_iterator port_iter = _in_occ.begin();
   while(port_iter != _in_occ.end()) {
     
     const int & input = *port_iter;
 
     // add requests to the input arbiter
 
-    map<int, sRequest>::const_iterator req_iter = _in_req[input].begin();
+    RequestMap::const_iterator req_iter = _in_req[input].begin();
     while(req_iter != _in_req[input].end()) {
 
       const sRequest & req = req_iter->second;
@@ -48,14 +48,14 @@ SeparableOutputFirstAllocator( Module* parent, const string& name, int inputs,
 
 void SeparableOutputFirstAllocator::Allocate() {
   
-  set<int>::const_iterator port_iter = _out_occ.begin();
+  PortSet::const_iterator port_iter = _out_occ.begin();
   while(port_iter != _out_occ.end()) {
     
     const int & output = *port_iter;
 
     // add requests to the output arbiter
 
-    map<int, sRequest>::const_iterator req_iter = _out_req[output].begin();
+    RequestMap::const_iterator req_iter = _out_req[output].begin();
     while(req_iter != _out_req[output].end()) {
       
       const sRequest & req = req_iter->second;
@@ -267,6 +267,8 @@ BookSimConfig::BookSimConfig( )
 
   _int_map["print_activity"] = 0;
 
+  _int_map["network_threads"] = 0; // evaluate routers on this many threads (0 or 1 = serial)
+
   _int_map["print_csv_results"] = 0;
 
   _int_map["deadlock_warn_timeout"] = 256;
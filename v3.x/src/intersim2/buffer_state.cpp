@@ -540,6 +540,11 @@ BufferState::BufferState( const Configuration& config, Module *parent, const str
   Module( parent, name ), _occupancy(0)
 {
   _vcs = config.GetInt( "num_vcs" );
+  if(_vcs > Credit::max_vcs) {
+    ostringstream err;
+    err << "num_vcs is limited to " << Credit::max_vcs << " (credits carry a VC bitmask)";
+    Error(err.str());
+  }
   _size = config.GetInt("buf_size");
   if(_size < 0) {
     _size = _vcs * config.GetInt("vc_buf_size");
@@ -573,12 +578,9 @@ void BufferState::ProcessCredit( Credit const * const c )
 {
   assert( c );
 
-  set<int>::iterator iter = c->vc.begin();
-  while(iter != c->vc.end()) {
+  for(int vc = c->NextVC(); vc >= 0; vc = c->NextVC(vc)) {
 
-    int const vc = *iter;
-
-    assert( ( vc >= 0 ) && ( vc < _vcs ) );
+    assert( vc < _vcs );
 
     if ( ( _wait_for_tail_credit ) && 
 	 ( _in_use_by[vc] < 0 ) ) {
@@ -611,8 +613,6 @@ void BufferState::ProcessCredit( Credit const * const c )
 #endif
 
     _buffer_policy->FreeSlotFor(vc);
-
-    ++iter;
   }
 }
 
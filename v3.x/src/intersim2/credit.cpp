@@ -35,6 +35,7 @@
 
 stack<Credit *> Credit::_all;
 stack<Credit *> Credit::_free;
+pthread_mutex_t Credit::_pool_lock = PTHREAD_MUTEX_INITIALIZER;
 
 Credit::Credit()
 {
@@ -43,7 +44,7 @@ Credit::Credit()
 
 void Credit::Reset()
 {
-  vc.clear();
+  vc_mask = 0;
   head = false;
   tail = false;
   id   = -1;
@@ -51,6 +52,7 @@ void Credit::Reset()
 
 Credit * Credit::New() {
   Credit * c;
+  pthread_mutex_lock(&_pool_lock);
   if(_free.empty()) {
     c = new Credit();
     _all.push(c);
@@ -59,11 +61,14 @@ Credit * Credit::New() {
     c->Reset();
     _free.pop();
   }
+  pthread_mutex_unlock(&_pool_lock);
   return c;
 }
 
 void Credit::Free() {
+  pthread_mutex_lock(&_pool_lock);
   _free.push(this);
+  pthread_mutex_unlock(&_pool_lock);
 }
 
 void Credit::FreeAll() {
@@ -28,14 +28,32 @@
 #ifndef _CREDIT_HPP_
 #define _CREDIT_HPP_
 
-#include <set>
 #include <stack>
+#include <cassert>
+#include <pthread.h>
 
 class Credit {
 
 public:
 
-  set<int> vc;
+  // VCs this credit returns buffer slots for, one bit per VC (BufferState 
+  // rejects configurations with more than max_vcs VCs)
+  static int const max_vcs = 64;
+  unsigned long long vc_mask;
+
+  void AddVC( int vc ) 
+  {
+    assert( ( vc >= 0 ) && ( vc < max_vcs ) );
+    vc_mask |= 1ULL << vc;
+  }
+  bool HasVCs() const { return vc_mask != 0; }
+  int NumVCs() const { return __builtin_popcountll( vc_mask ); }
+  // lowest VC above vc (the lowest VC for -1), -1 if there is none
+  int NextVC( int vc = -1 ) const
+  {
+    unsigned long long const m = ( vc >= max_vcs - 1 ) ? 0 : ( vc_mask & ( ~0ULL << ( vc + 1 ) ) );
+    return m ? __builtin_ctzll( m ) : -1;
+  }
 
   // these are only used by the event router
   bool head, tail;
@@ -51,6 +69,8 @@ private:
 
   static stack<Credit *> _all;
   static stack<Credit *> _free;
+  // routers allocate and free credits concurrently when network_threads > 1
+  static pthread_mutex_t _pool_lock;
 
   Credit();
   ~Credit() {}
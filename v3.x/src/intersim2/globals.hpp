@@ -51,6 +51,9 @@ extern int gNodes;
 
 extern bool gTrace;
 
+// true while a network evaluates its routers on several threads
+extern volatile bool gParallelPhase;
+
 extern std::ostream * gWatchOut;
 
 #endif
@@ -332,6 +332,15 @@ void GPUTrafficManager::_GeneratePacket(int source, int stype, int cl, int time,
   }
 }
 
+void GPUTrafficManager::_IdleStep()
+{
+  ++_time;
+  assert(_time);
+  if(gTrace){
+    cout<<"TIME "<<_time<<endl;
+  }
+}
+
 void GPUTrafficManager::_Step()
 {
   bool flits_in_flight = false;
@@ -386,8 +395,7 @@ void GPUTrafficManager::_Step()
       Credit * const c = _net[subnet]->ReadCredit( n );
       if ( c ) {
 #ifdef TRACK_FLOWS
-        for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-          int const vc = *iter;
+        for(int vc = c->NextVC(); vc >= 0; vc = c->NextVC(vc)) {
           assert(!_outstanding_classes[n][subnet][vc].empty());
           int cl = _outstanding_classes[n][subnet][vc].front();
           _outstanding_classes[n][subnet][vc].pop();
@@ -458,7 +466,7 @@ void GPUTrafficManager::_Step()
           
           OutputSet route_set;
           _rf(NULL, cf, -1, &route_set, true);
-          set<OutputSet::sSetElement> const & os = route_set.GetSet();
+          vector<OutputSet::sSetElement> const & os = route_set.GetSet();
           assert(os.size() == 1);
           OutputSet::sSetElement const & se = *os.begin();
           assert(se.output_port == -1);
@@ -485,7 +493,7 @@ void GPUTrafficManager::_Step()
               << "Generating lookahead routing info for flit " << cf->id
               << " (NOQ)." << endl;
             }
-            set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
+            vector<OutputSet::sSetElement> const & sl = cf->la_route_set.GetSet();
             assert(sl.size() == 1);
             int next_output = sl.begin()->output_port;
             vc_count /= router->NumOutputs();
@@ -650,7 +658,7 @@ void GPUTrafficManager::_Step()
           << "." << endl;
         }
         Credit * const c = Credit::New();
-        c->vc.insert(f->vc);
+        c->AddVC(f->vc);
         _net[subnet]->WriteCredit(c, n);
         
 #ifdef TRACK_FLOWS
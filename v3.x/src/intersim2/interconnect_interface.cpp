@@ -42,6 +42,7 @@
 #include "booksim.hpp"
 #include "intersim_config.hpp"
 #include "network.hpp"
+#include "credit.hpp"
 
 InterconnectInterface* InterconnectInterface::New(const char* const config_file)
 {
@@ -57,6 +58,7 @@ InterconnectInterface* InterconnectInterface::New(const char* const config_file)
 }
 
 InterconnectInterface::InterconnectInterface()
+: _flits_in_flight(0), _boundary_packets(0), _skip_idle_steps(false)
 {
   
 }
@@ -130,6 +132,9 @@ void InterconnectInterface::CreateInterconnect(unsigned n_shader, unsigned n_mem
   }
   _vcs = _icnt_config->GetInt("num_vcs");
   
+  double const internal_speedup = _icnt_config->GetFloat("internal_speedup");
+  _skip_idle_steps = (internal_speedup == floor(internal_speedup));
+  
   _CreateBuffer();
   _CreateNodeMap(_n_shader, _n_mem, _traffic_manager->_nodes, _icnt_config->GetInt("use_map"));
 }
@@ -181,6 +186,7 @@ void InterconnectInterface::Push(unsigned input_deviceID, unsigned output_device
   
   //TODO: _include_queuing ?
   _traffic_manager->_GeneratePacket( input_icntID, -1, 0 /*class*/, _traffic_manager->_time, subnet, n_flits, packet_type, data, output_icntID);
+  _flits_in_flight += n_flits;
   
 #if DOUB
   cout <<"Traffic[" << subnet << "] (mapped) sending form "<< input_icntID << " to " << output_icntID << endl;
@@ -212,6 +218,7 @@ void* InterconnectInterface::Pop(unsigned deviceID)
   }
   if (data) {
     _round_robin_turn[subnet][icntID] = turn;
+    --_boundary_packets;
   }
   
   return data;
@@ -220,32 +227,20 @@ void* InterconnectInterface::Pop(unsigned deviceID)
 
 void InterconnectInterface::Advance()
 {
-  _traffic_manager->_Step();
+  // every credit is returned once the last flit has been ejected and its
+  // credits have made their way back, after which the routers, channels and
+  // buffer states are all idle
+  if (_skip_idle_steps && !_flits_in_flight && !Credit::OutStanding()) {
+    _traffic_manager->_IdleStep();
+  } else {
+    _traffic_manager->_Step();
+  }
 }
 
 bool InterconnectInterface::Busy() const
 {
-  bool busy = !_traffic_manager->_total_in_flight_flits[0].empty();
-  if (!busy) {
-    for (int s = 0; s < _subnets; ++s) {
-      for (unsigned n = 0; n < _n_shader+_n_mem; ++n) {
-        //FIXME: if this cannot make sure _partial_packets is empty
-        assert(_traffic_manager->_input_queue[s][n][0].empty());
-      }
-    }
-  }
-  else
-    return true;
-  for (int s = 0; s < _subnets; ++s) {
-    for (unsigned n=0; n < (_n_shader+_n_mem); ++n) {
-      for (int vc=0; vc<_vcs; ++vc) {
-        if (_boundary_buffer[s][n][vc].HasPacket() ) {
-          return true;
-        }
-      }
-    }
-  }
-  return false;
+  assert(_flits_in_flight || _traffic_manager->_total_in_flight_flits[0].empty());
+  return _flits_in_flight || _boundary_packets;
 }
 
 bool InterconnectInterface::HasBuffer(unsigned deviceID, unsigned int size) const
@@ -323,6 +318,9 @@ void InterconnectInterface::Transfer2BoundaryBuffer(int subnet, int output)
       
       _ejection_buffer[subnet][output][vc].pop();
       _boundary_buffer[subnet][output][vc].PushFlitData( flit->data, flit->tail);
+      if (flit->tail) {
+        ++_boundary_packets;
+      }
       
       _ejected_flit_queue[subnet][output].push(flit); //indicate this flit is already popped from ejection buffer and ready for credit return
       
@@ -356,6 +354,7 @@ Flit* InterconnectInterface::GetEjectedFlit(int subnet, int node)
   if (!_ejected_flit_queue[subnet][node].empty()) {
     flit = _ejected_flit_queue[subnet][node].front();
     _ejected_flit_queue[subnet][node].pop();
+    --_flits_in_flight;
   }
   return flit;
 }
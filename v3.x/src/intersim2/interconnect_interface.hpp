@@ -117,6 +117,14 @@ protected:
   int _vcs;
   int _subnets;
   
+  // flits pushed and not yet taken out of the ejection buffers, and complete
+  // packets waiting in the boundary buffers
+  unsigned _flits_in_flight;
+  unsigned _boundary_packets;
+  // a step of a network without flits or credits only advances time; not
+  // used with a fractional internal speedup, whose phase the routers keep
+  bool _skip_idle_steps;
+  
   //deviceID to icntID map
   //deviceID : Starts from 0 for shaders and then continues until mem nodes
   //which starts at location n_shader and then continues to n_shader+n_mem (last device)
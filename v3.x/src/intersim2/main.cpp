@@ -64,7 +64,7 @@ InterconnectInterface *g_icnt_interface;
 
 /* the current traffic manager instance */
 TrafficManager * trafficManager = NULL;
-#if 0
+#ifndef CREATE_LIBRARY
 
 int GetSimTime() {
     return trafficManager->getTime();
@@ -106,6 +106,8 @@ int gNodes;
 //generate nocviewer trace
 bool gTrace;
 
+volatile bool gParallelPhase = false;
+
 ostream * gWatchOut;
 
 
@@ -150,6 +152,10 @@ bool Simulate( BookSimConfig const & config )
     - ((double)(start_time.tv_sec) + (double)(start_time.tv_usec)/1000000.0);
     
     cout<<"Total run time "<<total_time<<endl;
+    if(total_time > 0.0) {
+        cout<<"Simulation rate "<<trafficManager->getTime() / total_time<<" (cycle/sec), "
+            <<trafficManager->getFlitsCreated() / total_time<<" (flit/sec)"<<endl;
+    }
     
     for (int i=0; i<subnets; ++i) {
         
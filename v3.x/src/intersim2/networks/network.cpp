@@ -34,6 +34,9 @@
 
 #include <cassert>
 #include <sstream>
+#include <set>
+#include <map>
+#include <sched.h>
 
 #include "booksim.hpp"
 #include "network.hpp"
@@ -56,10 +59,29 @@ Network::Network( const Configuration &config, const string & name ) :
   _nodes    = -1; 
   _channels = -1;
   _classes  = config.GetInt("classes");
+
+  _threads = config.GetInt("network_threads");
+  if ( ( _threads > 1 ) && ( config.GetStr("router") != "iq" ) ) {
+    cerr << "Warning: network_threads is only supported with the iq router; "
+	 << "evaluating " << name << " serially." << endl;
+    _threads = 1;
+  }
+  _workers_started = false;
+  _active_init = false;
+  _phase = PHASE_EXIT;
+  _phase_gen = 0;
+  _phase_pending = 0;
+  _sleeping = 0;
+  pthread_mutex_init( &_phase_lock, NULL );
+  pthread_cond_init( &_phase_cond, NULL );
 }
 
 Network::~Network( )
 {
+  _StopWorkers( );
+  pthread_mutex_destroy( &_phase_lock );
+  pthread_cond_destroy( &_phase_cond );
+
   for ( int r = 0; r < _size; ++r ) {
     if ( _routers[r] ) delete _routers[r];
   }
@@ -181,29 +203,233 @@ void Network::_Alloc( )
 
 void Network::ReadInputs( )
 {
+  _RunPhase( PHASE_READ_INPUTS );
+}
+
+void Network::Evaluate( )
+{
+  _RunPhase( PHASE_EVALUATE );
+}
+
+void Network::WriteOutputs( )
+{
+  _RunPhase( PHASE_WRITE_OUTPUTS );
+}
+
+void Network::_StepGroup( Phase phase, vector<TimedModule *> const & group )
+{
+  vector<TimedModule *>::const_iterator iter;
+  switch ( phase ) {
+  case PHASE_READ_INPUTS:
+    for ( iter = group.begin( ); iter != group.end( ); ++iter ) (*iter)->ReadInputs( );
+    break;
+  case PHASE_EVALUATE:
+    for ( iter = group.begin( ); iter != group.end( ); ++iter ) (*iter)->Evaluate( );
+    break;
+  case PHASE_WRITE_OUTPUTS:
+    for ( iter = group.begin( ); iter != group.end( ); ++iter ) (*iter)->WriteOutputs( );
+    break;
+  default:
+    assert( 0 );
+  }
+}
+
+void Network::_RunPhase( Phase phase )
+{
+  if ( ( _threads > 1 ) && !_workers_started ) {
+    _StartWorkers( );
+  }
+  if ( _threads <= 1 ) {
+    if ( phase == PHASE_READ_INPUTS ) {
+      _UpdateActive( );
+    }
+    _StepGroup( phase, _active_modules );
+    return;
+  }
+
+  // _phase and _phase_pending are published by the release store of
+  // _phase_gen; the workers' acquire loads of _phase_gen pair with it.
+  gParallelPhase = true;
+  _phase = phase;
+  _phase_pending = _threads - 1;
+  pthread_mutex_lock( &_phase_lock );
+  __atomic_store_n( &_phase_gen, _phase_gen + 1, __ATOMIC_RELEASE );
+  if ( _sleeping ) {
+    pthread_cond_broadcast( &_phase_cond );
+  }
+  pthread_mutex_unlock( &_phase_lock );
+
+  _StepGroup( phase, _groups[0] );
+
+  // the acquire load pairs with the workers' release decrements, so their
+  // writes during the phase are visible once this reaches zero
+  for ( int spin = 0; __atomic_load_n( &_phase_pending, __ATOMIC_ACQUIRE ) > 0; ++spin ) {
+    if ( spin > 1000 ) {
+      sched_yield( );
+    }
+  }
+  gParallelPhase = false;
+}
+
+void Network::_InitActive( )
+{
+  _active_init = true;
+
+  set<TimedModule *> routers( _routers.begin( ), _routers.end( ) );
+  map<TimedModule *, int> router_index;
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
-    (*iter)->ReadInputs( );
+    if ( routers.count( *iter ) ) {
+      router_index[*iter] = _router_modules.size( );
+      _router_modules.push_back( *iter );
+    }
   }
-}
 
-void Network::Evaluate( )
-{
+  // a router reads flits from its input channels and credits from the
+  // backchannels of its outputs
+  map<TimedModule *, int> sink;
+  for ( size_t r = 0; r < _router_modules.size( ); ++r ) {
+    Router const * const router = static_cast<Router const *>( _router_modules[r] );
+    for ( int i = 0; i < router->NumInputs( ); ++i ) {
+      sink[router->GetInputChannel( i )] = r;
+    }
+    for ( int o = 0; o < router->NumOutputs( ); ++o ) {
+      sink[router->GetOutputCredit( o )] = r;
+    }
+  }
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
-    (*iter)->Evaluate( );
+    if ( !routers.count( *iter ) ) {
+      map<TimedModule *, int>::const_iterator s = sink.find( *iter );
+      _channel_modules.push_back( *iter );
+      _channel_sink.push_back( ( s == sink.end( ) ) ? -1 : s->second );
+    }
   }
+  _router_woken.resize( _router_modules.size( ), 0 );
+  _active_modules.reserve( _timed_modules.size( ) );
 }
 
-void Network::WriteOutputs( )
+void Network::_UpdateActive( )
+{
+  if ( !_active_init ) {
+    _InitActive( );
+  }
+  _active_modules.clear( );
+  for ( size_t c = 0; c < _channel_modules.size( ); ++c ) {
+    if ( !_channel_modules[c]->Idle( ) ) {
+      _active_modules.push_back( _channel_modules[c] );
+      if ( _channel_sink[c] >= 0 ) {
+	_router_woken[_channel_sink[c]] = 1;
+      }
+    }
+  }
+  for ( size_t r = 0; r < _router_modules.size( ); ++r ) {
+    if ( _router_woken[r] || !_router_modules[r]->Idle( ) ) {
+      _active_modules.push_back( _router_modules[r] );
+      _router_woken[r] = 0;
+    }
+  }
+}
+
+void * Network::_WorkerMain( void * arg )
+{
+  WorkerArg const * const wa = (WorkerArg const *)arg;
+  Network * const net = wa->net;
+  unsigned gen = 0;
+  while ( true ) {
+    // spin briefly, as phases follow each other closely, then sleep
+    for ( int spin = 0; ( __atomic_load_n( &net->_phase_gen, __ATOMIC_ACQUIRE ) == gen ) && ( spin < 4000 ); ++spin )
+      ;
+    if ( __atomic_load_n( &net->_phase_gen, __ATOMIC_ACQUIRE ) == gen ) {
+      pthread_mutex_lock( &net->_phase_lock );
+      while ( __atomic_load_n( &net->_phase_gen, __ATOMIC_ACQUIRE ) == gen ) {
+	++net->_sleeping;
+	pthread_cond_wait( &net->_phase_cond, &net->_phase_lock );
+	--net->_sleeping;
+      }
+      pthread_mutex_unlock( &net->_phase_lock );
+    }
+    gen = __atomic_load_n( &net->_phase_gen, __ATOMIC_ACQUIRE );
+    Phase const phase = (Phase)net->_phase;
+    if ( phase == PHASE_EXIT ) {
+      break;
+    }
+    _StepGroup( phase, net->_groups[wa->group] );
+    __atomic_fetch_sub( &net->_phase_pending, 1, __ATOMIC_RELEASE );
+  }
+  return NULL;
+}
+
+void Network::_StartWorkers( )
 {
+  _workers_started = true;
+
+  // per flit watch output and activity printing would interleave
+  if ( gWatchOut || gPrintActivity || gTrace ) {
+    cerr << "Warning: network_threads is ignored while watching flits or "
+	 << "printing activity; evaluating " << Name() << " serially." << endl;
+    _threads = 1;
+    return;
+  }
+  if ( _threads > _size ) {
+    _threads = _size;
+  }
+  if ( _threads <= 1 ) {
+    return;
+  }
+
+  // routers carry nearly all of the work, so routers and channels are
+  // divided up separately; each group is contiguous for locality
+  set<TimedModule *> routers( _routers.begin( ), _routers.end( ) );
+  vector<TimedModule *> chans;
+  vector<TimedModule *> rtrs;
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
-    (*iter)->WriteOutputs( );
+    if ( routers.count( *iter ) ) {
+      rtrs.push_back( *iter );
+    } else {
+      chans.push_back( *iter );
+    }
+  }
+  _groups.resize( _threads );
+  for ( int t = 0; t < _threads; ++t ) {
+    _groups[t].insert( _groups[t].end( ),
+		       chans.begin( ) + chans.size( ) * t / _threads,
+		       chans.begin( ) + chans.size( ) * ( t + 1 ) / _threads );
+    _groups[t].insert( _groups[t].end( ),
+		       rtrs.begin( ) + rtrs.size( ) * t / _threads,
+		       rtrs.begin( ) + rtrs.size( ) * ( t + 1 ) / _threads );
+  }
+
+  // group 0 is evaluated by the calling thread
+  _workers.resize( _threads - 1 );
+  _worker_args.resize( _threads - 1 );
+  for ( int t = 1; t < _threads; ++t ) {
+    _worker_args[t-1].net = this;
+    _worker_args[t-1].group = t;
+    if ( pthread_create( &_workers[t-1], NULL, _WorkerMain, &_worker_args[t-1] ) ) {
+      Error( "Unable to create network evaluation thread." );
+    }
+  }
+}
+
+void Network::_StopWorkers( )
+{
+  if ( _workers.empty( ) ) {
+    return;
+  }
+  _phase = PHASE_EXIT;
+  pthread_mutex_lock( &_phase_lock );
+  __atomic_store_n( &_phase_gen, _phase_gen + 1, __ATOMIC_RELEASE );
+  pthread_cond_broadcast( &_phase_cond );
+  pthread_mutex_unlock( &_phase_lock );
+  for ( size_t t = 0; t < _workers.size( ); ++t ) {
+    pthread_join( _workers[t], NULL );
   }
+  _workers.clear( );
 }
 
 void Network::WriteFlit( Flit *f, int source )
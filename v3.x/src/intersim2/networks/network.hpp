@@ -30,6 +30,7 @@
 
 #include <vector>
 #include <deque>
+#include <pthread.h>
 
 #include "module.hpp"
 #include "flit.hpp"
@@ -66,11 +67,52 @@ protected:
 
   deque<TimedModule *> _timed_modules;
 
+  // Parallel evaluation (network_threads > 1): the timed modules are split
+  // into one group per thread and each of ReadInputs, Evaluate and
+  // WriteOutputs runs the groups concurrently.  Routers only see each other
+  // through channels, which are latched between these phases, so the result
+  // does not depend on the evaluation order.
+  enum Phase { PHASE_EXIT = -1, PHASE_READ_INPUTS, PHASE_EVALUATE, PHASE_WRITE_OUTPUTS };
+  struct WorkerArg {
+    Network *net;
+    int group;
+  };
+
+  int _threads;
+  bool _workers_started;
+  vector<vector<TimedModule *> > _groups;
+  vector<pthread_t> _workers;
+  vector<WorkerArg> _worker_args;
+  pthread_mutex_t _phase_lock;
+  pthread_cond_t _phase_cond;
+  int _phase;
+  unsigned _phase_gen;          // bumped (release) to start a phase
+  int _phase_pending;           // workers still in the current phase
+  int _sleeping;                // workers blocked on _phase_cond
+
+  // Serial evaluation only steps the modules that can have work this cycle:
+  // channels holding data, routers that are not idle and routers fed by a
+  // channel holding data.  The set is rebuilt before every ReadInputs.
+  bool _active_init;
+  vector<TimedModule *> _channel_modules;
+  vector<int> _channel_sink; // index into _router_modules, -1 for the nodes
+  vector<TimedModule *> _router_modules;
+  vector<char> _router_woken;
+  vector<TimedModule *> _active_modules;
+
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
   void _Alloc( );
 
+  void _StartWorkers( );
+  void _StopWorkers( );
+  void _RunPhase( Phase phase );
+  void _InitActive( );
+  void _UpdateActive( );
+  static void _StepGroup( Phase phase, vector<TimedModule *> const & group );
+  static void * _WorkerMain( void * arg );
+
 public:
   Network( const Configuration &config, const string & name );
   virtual ~Network( );
@@ -57,14 +57,22 @@ void OutputSet::AddRange( int output_port, int vc_start, int vc_end, int pri )
   s.vc_end   = vc_end;
   s.pri      = pri;
   s.output_port = output_port;
-  _outputs.insert( s );
+
+  vector<sSetElement>::iterator i = _outputs.begin( );
+  while ( ( i != _outputs.end( ) ) && ( *i < s ) ) {
+    ++i;
+  }
+  if ( ( i != _outputs.end( ) ) && !( s < *i ) ) {
+    return; // an element with this priority is already present
+  }
+  _outputs.insert( i, s );
 }
 
 //legacy support, for performance, just use GetSet()
 int OutputSet::NumVCs( int output_port ) const
 {
   int total = 0;
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  vector<sSetElement>::const_iterator i = _outputs.begin( );
   while(i!=_outputs.end( )){
     if(i->output_port == output_port){
       total += (i->vc_end - i->vc_start + 1);
@@ -76,7 +84,7 @@ int OutputSet::NumVCs( int output_port ) const
 
 bool OutputSet::OutputEmpty( int output_port ) const
 {
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  vector<sSetElement>::const_iterator i = _outputs.begin( );
   while(i!=_outputs.end( )){
     if(i->output_port == output_port){
       return false;
@@ -87,7 +95,7 @@ bool OutputSet::OutputEmpty( int output_port ) const
 }
 
 
-const set<OutputSet::sSetElement> & OutputSet::GetSet() const{
+const vector<OutputSet::sSetElement> & OutputSet::GetSet() const{
   return _outputs;
 }
 
@@ -101,7 +109,7 @@ int OutputSet::GetVC( int output_port, int vc_index, int *pri ) const
   
   if ( pri ) { *pri = -1; }
 
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  vector<sSetElement>::const_iterator i = _outputs.begin( );
   while(i!=_outputs.end( )){
     if(i->output_port == output_port){
       range = i->vc_end - i->vc_start + 1;
@@ -128,7 +136,7 @@ bool OutputSet::GetPortVC( int *out_port, int *out_vc ) const
   bool single_output = false;
   int  used_outputs  = 0;
 
-  set<sSetElement>::const_iterator i = _outputs.begin( );
+  vector<sSetElement>::const_iterator i = _outputs.begin( );
   if(i!=_outputs.end( )){
     used_outputs = i->output_port;
   }
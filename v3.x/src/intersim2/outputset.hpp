@@ -28,7 +28,7 @@
 #ifndef _OUTPUTSET_HPP_
 #define _OUTPUTSET_HPP_
 
-#include <set>
+#include <vector>
 
 class OutputSet {
 
@@ -48,12 +48,16 @@ public:
   bool OutputEmpty( int output_port ) const;
   int NumVCs( int output_port ) const;
   
-  const set<sSetElement> & GetSet() const;
+  // ordered by decreasing priority
+  const vector<sSetElement> & GetSet() const;
 
   int  GetVC( int output_port,  int vc_index, int *pri = 0 ) const;
   bool GetPortVC( int *out_port, int *out_vc ) const;
 private:
-  set<sSetElement> _outputs;
+  // Kept sorted, with at most one element per priority, to match the
+  // std::set (ordered by priority only) that it replaces.  Clear() keeps
+  // the capacity, so reused sets stop allocating.
+  vector<sSetElement> _outputs;
 };
 
 inline bool operator<(const OutputSet::sSetElement & se1, 
@@ -34,6 +34,27 @@ long   ran_next( );
 void   ranf_start(long seed);
 double ranf_next( );
 
+// A random number stream owned by one router.  With network_threads set,
+// each router draws from its own stream while it is evaluated (gRandomStream
+// points at it), so its draws depend only on its own history and not on
+// which thread evaluates it or on the order of the other routers.
+struct RandomStream {
+  unsigned long long state;
+};
+extern __thread RandomStream * gRandomStream;
+
+inline void RandomStreamSeed( RandomStream * s, long seed, unsigned long long key ) {
+  s->state = ( (unsigned long long)seed << 32 ) ^ key;
+}
+
+// splitmix64
+inline unsigned long long RandomStreamNext( RandomStream * s ) {
+  unsigned long long z = ( s->state += 0x9E3779B97F4A7C15ULL );
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  return z ^ ( z >> 31 );
+}
+
 inline void RandomSeed( long seed ) {
   ran_start( seed );
   ranf_start( seed );
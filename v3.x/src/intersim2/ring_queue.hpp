@@ -0,0 +1,122 @@
+// Copyright (c) 2009-2013, Tor M. Aamodt, Dongdong Li, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/*ring_queue.hpp
+ *
+ *FIFO queue on a power-of-two ring buffer.  Storage is only allocated when
+ *the queue grows past its capacity, so steady-state push/pop never touches
+ *the heap (unlike std::deque, which allocates and frees blocks as it moves).
+ *
+ */
+
+#ifndef _RING_QUEUE_HPP_
+#define _RING_QUEUE_HPP_
+
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+template<class T> class RingQueue {
+  vector<T> _data;
+  size_t _head;
+  size_t _size;
+  size_t _mask;
+
+  void _Grow( );
+
+public:
+  class iterator {
+    RingQueue<T> * _q;
+    size_t _i;
+  public:
+    iterator( RingQueue<T> * q, size_t i ) : _q(q), _i(i) {}
+    T & operator*( ) const { return (*_q)[_i]; }
+    T * operator->( ) const { return &(*_q)[_i]; }
+    iterator & operator++( ) { ++_i; return *this; }
+    bool operator==( iterator const & o ) const { return _i == o._i; }
+    bool operator!=( iterator const & o ) const { return _i != o._i; }
+  };
+
+  explicit RingQueue( size_t capacity = 16 );
+
+  void Reserve( size_t capacity );
+
+  bool empty( ) const { return _size == 0; }
+  size_t size( ) const { return _size; }
+
+  T & operator[]( size_t i ) { return _data[(_head + i) & _mask]; }
+  T const & operator[]( size_t i ) const { return _data[(_head + i) & _mask]; }
+
+  T & front( ) { assert(_size); return _data[_head]; }
+  T const & front( ) const { assert(_size); return _data[_head]; }
+
+  void push_back( T const & item )
+  {
+    if ( _size == _data.size( ) ) {
+      _Grow( );
+    }
+    _data[(_head + _size) & _mask] = item;
+    ++_size;
+  }
+  void pop_front( )
+  {
+    assert(_size);
+    _head = (_head + 1) & _mask;
+    --_size;
+  }
+
+  iterator begin( ) { return iterator(this, 0); }
+  iterator end( ) { return iterator(this, _size); }
+};
+
+template<class T> RingQueue<T>::RingQueue( size_t capacity ) :
+  _head(0), _size(0), _mask(0)
+{
+  _data.resize(1);
+  Reserve(capacity);
+}
+
+template<class T> void RingQueue<T>::Reserve( size_t capacity )
+{
+  while ( _data.size( ) < capacity ) {
+    _Grow( );
+  }
+}
+
+template<class T> void RingQueue<T>::_Grow( )
+{
+  vector<T> data(_data.size( ) * 2);
+  for ( size_t i = 0; i < _size; ++i ) {
+    data[i] = (*this)[i];
+  }
+  _data.swap(data);
+  _head = 0;
+  _mask = _data.size( ) - 1;
+}
+
+#endif
@@ -25,10 +25,26 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstdlib>
+#include <iostream>
+
+#include "globals.hpp"
+#include "random_utils.hpp"
+
 #define main rng_double_main
 #include "rng-double.c"
 
 double ranf_next( )
 {
+  if ( gRandomStream ) {
+    // [0,1) with 53 bits
+    return ( RandomStreamNext( gRandomStream ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+  }
+  // the draw order would depend on thread scheduling
+  if ( gParallelPhase ) {
+    std::cerr << "Error: random number drawn outside a router during parallel "
+              << "network evaluation; this configuration requires network_threads <= 1." << std::endl;
+    exit(-1);
+  }
   return ranf_arr_next( );
 }
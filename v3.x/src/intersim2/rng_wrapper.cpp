@@ -25,10 +25,28 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstdlib>
+#include <iostream>
+
+#include "globals.hpp"
+#include "random_utils.hpp"
+
 #define main rng_main
 #include "rng.c"
 
+__thread RandomStream * gRandomStream = NULL;
+
 long ran_next( )
 {
+  if ( gRandomStream ) {
+    // same range as ran_arr_next, [0,2^30)
+    return (long)( RandomStreamNext( gRandomStream ) >> 34 );
+  }
+  // the draw order would depend on thread scheduling
+  if ( gParallelPhase ) {
+    std::cerr << "Error: random number drawn outside a router during parallel "
+              << "network evaluation; this configuration requires network_threads <= 1." << std::endl;
+    exit(-1);
+  }
   return ran_arr_next( );
 }
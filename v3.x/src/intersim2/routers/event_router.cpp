@@ -470,8 +470,8 @@ void EventRouter::_ArrivalArb( int output )
     c = _out_cred_buffer[output].front( );
     _out_cred_buffer[output].pop( );
     
-    assert( c->vc.size() == 1 );
-    int vc = *c->vc.begin();
+    assert( c->NumVCs() == 1 );
+    int vc = c->NextVC();
 
     EventNextVCState::eNextVCState state = 
       _output_state[output]->GetState( vc );
@@ -671,7 +671,7 @@ void EventRouter::_TransportArb( int input )
     }
 
     c = Credit::New( );
-    c->vc.insert(f->vc);
+    c->AddVC(f->vc);
     c->head          = f->head;
     c->tail          = f->tail;
     c->id            = f->id;
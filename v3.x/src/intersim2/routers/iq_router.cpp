@@ -33,7 +33,9 @@
 #include <iomanip>
 #include <cstdlib>
 #include <cassert>
+#include <cmath>
 #include <limits>
+#include <algorithm>
 
 #include "globals.hpp"
 #include "random_utils.hpp"
@@ -49,8 +51,12 @@
 
 IQRouter::IQRouter( Configuration const & config, Module *parent, 
 		    string const & name, int id, int inputs, int outputs )
-: Router( config, parent, name, id, inputs, outputs ), _active(false)
+: Router( config, parent, name, id, inputs, outputs ), _active(false),
+  _buffered_outputs(0)
 {
+  // skipping an idle cycle would shift the phase of _partial_internal_cycles
+  _fractional_speedup = (_internal_speedup != floor(_internal_speedup));
+
   _vcs         = config.GetInt( "num_vcs" );
 
   _vc_busy_when_full = (config.GetInt("vc_busy_when_full") > 0);
@@ -162,6 +168,17 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
   _output_buffer.resize(_outputs); 
   _credit_buffer.resize(_inputs); 
 
+  // Pipeline queues; sized so that they normally never have to grow
+  _in_queue_flits.reserve(_inputs);
+  _proc_credits.Reserve(_outputs * (_credit_delay + 1));
+  _route_vcs.Reserve(_inputs * _vcs);
+  _vc_alloc_vcs.Reserve(_inputs * _vcs);
+  _sw_hold_vcs.Reserve(_inputs * _vcs);
+  _sw_alloc_vcs.Reserve(_inputs * _vcs);
+  _crossbar_flits.Reserve(_outputs * _output_speedup * (_crossbar_delay + 1));
+  _out_queue_credits.resize(_inputs, NULL);
+  _out_queue_inputs.reserve(_inputs);
+
   // Switch configuration (when held for multiple cycles)
   _hold_switch_for_packet = (config.GetInt("hold_switch_for_packet") > 0);
   _switch_hold_in.resize(_inputs*_input_speedup, -1);
@@ -223,6 +240,11 @@ void IQRouter::ReadInputs( )
   _active = _active || have_flits || have_credits;
 }
 
+bool IQRouter::Idle( ) const
+{
+  return !_active && !_buffered_outputs && !_fractional_speedup;
+}
+
 void IQRouter::_InternalStep( )
 {
   if(!_active) {
@@ -284,6 +306,9 @@ void IQRouter::_InternalStep( )
 
 void IQRouter::WriteOutputs( )
 {
+  if(!_buffered_outputs) {
+    return;
+  }
   _SendFlits( );
   _SendCredits( );
 }
@@ -310,7 +335,7 @@ bool IQRouter::_ReceiveFlits( )
 		   << " from channel at input " << input
 		   << "." << endl;
       }
-      _in_queue_flits.insert(make_pair(input, f));
+      _in_queue_flits.push_back(make_pair(input, f));
       activity = true;
     }
   }
@@ -338,7 +363,7 @@ bool IQRouter::_ReceiveCredits( )
 
 void IQRouter::_InputQueuing( )
 {
-  for(map<int, Flit *>::const_iterator iter = _in_queue_flits.begin();
+  for(vector<pair<int, Flit *> >::const_iterator iter = _in_queue_flits.begin();
       iter != _in_queue_flits.end();
       ++iter) {
 
@@ -437,8 +462,7 @@ void IQRouter::_InputQueuing( )
     BufferState * const dest_buf = _next_buf[output];
     
 #ifdef TRACK_FLOWS
-    for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-      int const vc = *iter;
+    for(int vc = c->NextVC(); vc >= 0; vc = c->NextVC(vc)) {
       assert(!_outstanding_classes[output][vc].empty());
       int cl = _outstanding_classes[output][vc].front();
       _outstanding_classes[output][vc].pop();
@@ -462,7 +486,7 @@ void IQRouter::_RouteEvaluate( )
 {
   assert(_routing_delay);
 
-  for(deque<pair<int, pair<int, int> > >::iterator iter = _route_vcs.begin();
+  for(RingQueue<pair<int, pair<int, int> > >::iterator iter = _route_vcs.begin();
       iter != _route_vcs.end();
       ++iter) {
     
@@ -556,7 +580,7 @@ void IQRouter::_VCAllocEvaluate( )
 
   bool watched = false;
 
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _vc_alloc_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _vc_alloc_vcs.begin();
       iter != _vc_alloc_vcs.end();
       ++iter) {
 
@@ -593,7 +617,7 @@ void IQRouter::_VCAllocEvaluate( )
     assert(route_set);
 
     int const out_priority = cur_buf->GetPriority(vc);
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    vector<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 
     bool elig = false;
     bool cred = false;
@@ -601,7 +625,7 @@ void IQRouter::_VCAllocEvaluate( )
 
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(vector<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
 
@@ -705,7 +729,7 @@ void IQRouter::_VCAllocEvaluate( )
     _vc_allocator->PrintGrants( gWatchOut );
   }
 
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _vc_alloc_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _vc_alloc_vcs.begin();
       iter != _vc_alloc_vcs.end();
       ++iter) {
 
@@ -775,7 +799,7 @@ void IQRouter::_VCAllocEvaluate( )
     return;
   }
 
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _vc_alloc_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _vc_alloc_vcs.begin();
       iter != _vc_alloc_vcs.end();
       ++iter) {
     
@@ -932,7 +956,7 @@ void IQRouter::_SWHoldEvaluate( )
 {
   assert(_hold_switch_for_packet);
 
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_hold_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_hold_vcs.begin();
       iter != _sw_hold_vcs.end();
       ++iter) {
     
@@ -1123,10 +1147,7 @@ void IQRouter::_SWHoldUpdate( )
 
       _crossbar_flits.push_back(make_pair(-1, make_pair(f, make_pair(expanded_input, expanded_output))));
       
-      if(_out_queue_credits.count(input) == 0) {
-	_out_queue_credits.insert(make_pair(input, Credit::New()));
-      }
-      _out_queue_credits.find(input)->second->vc.insert(vc);
+      _AddOutQueueCredit(input, vc);
       
       if(cur_buf->Empty(vc)) {
 	if(f->watch) {
@@ -1328,7 +1349,7 @@ void IQRouter::_SWAllocEvaluate( )
 {
   bool watched = false;
 
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
       iter != _sw_alloc_vcs.end();
       ++iter) {
 
@@ -1397,11 +1418,11 @@ void IQRouter::_SWAllocEvaluate( )
     OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
     assert(route_set);
     
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    vector<OutputSet::sSetElement> const & setlist = route_set->GetSet();
     
     assert(!_noq || (setlist.size() == 1));
 
-    for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+    for(vector<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
 	iset != setlist.end();
 	++iset) {
       
@@ -1492,7 +1513,7 @@ void IQRouter::_SWAllocEvaluate( )
     }
   }
   
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
       iter != _sw_alloc_vcs.end();
       ++iter) {
 
@@ -1633,7 +1654,7 @@ void IQRouter::_SWAllocEvaluate( )
     return;
   }
 
-  for(deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
+  for(RingQueue<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
       iter != _sw_alloc_vcs.end();
       ++iter) {
 
@@ -1741,7 +1762,7 @@ void IQRouter::_SWAllocEvaluate( )
 	  OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
 	  assert(route_set);
 
-	  set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	  vector<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 
 	  bool busy = true;
 	  bool full = true;
@@ -1749,7 +1770,7 @@ void IQRouter::_SWAllocEvaluate( )
 
 	  assert(!_noq || (setlist.size() == 1));
 
-	  for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	  for(vector<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
 	      iset != setlist.end();
 	      ++iset) {
 	    if(iset->output_port == output) {
@@ -1896,11 +1917,11 @@ void IQRouter::_SWAllocUpdate( )
 	int match_prio = numeric_limits<int>::min();
 
 	const OutputSet * route_set = cur_buf->GetRouteSet(vc);
-	set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+	vector<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 	
 	assert(!_noq || (setlist.size() == 1));
 	
-	for(set<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
+	for(vector<OutputSet::sSetElement>::const_iterator iset = setlist.begin();
 	    iset != setlist.end();
 	    ++iset) {
 	  if(iset->output_port == output) {
@@ -2033,10 +2054,7 @@ void IQRouter::_SWAllocUpdate( )
 
       _crossbar_flits.push_back(make_pair(-1, make_pair(f, make_pair(expanded_input, expanded_output))));
 
-      if(_out_queue_credits.count(input) == 0) {
-	_out_queue_credits.insert(make_pair(input, Credit::New()));
-      }
-      _out_queue_credits.find(input)->second->vc.insert(vc);
+      _AddOutQueueCredit(input, vc);
 
       if(cur_buf->Empty(vc)) {
 	if(f->tail) {
@@ -2134,7 +2152,7 @@ void IQRouter::_SWAllocUpdate( )
 
 void IQRouter::_SwitchEvaluate( )
 {
-  for(deque<pair<int, pair<Flit *, pair<int, int> > > >::iterator iter = _crossbar_flits.begin();
+  for(RingQueue<pair<int, pair<Flit *, pair<int, int> > > >::iterator iter = _crossbar_flits.begin();
       iter != _crossbar_flits.end();
       ++iter) {
     
@@ -2201,7 +2219,8 @@ void IQRouter::_SwitchUpdate( )
 		 << " at output " << output
 		 << "." << endl;
     }
-    _output_buffer[output].push(f);
+    _output_buffer[output].push_back(f);
+    ++_buffered_outputs;
     //the output buffer size isn't precise due to flits in flight
     //but there is a maximum bound based on output speed up and ST traversal
     assert(_output_buffer[output].size()<=(size_t)_output_buffer_size+ _crossbar_delay* _output_speedup+( _output_speedup-1) ||_output_buffer_size==-1);
@@ -2214,22 +2233,34 @@ void IQRouter::_SwitchUpdate( )
 // output queuing
 //------------------------------------------------------------------------------
 
+void IQRouter::_AddOutQueueCredit(int input, int vc)
+{
+  if(!_out_queue_credits[input]) {
+    _out_queue_credits[input] = Credit::New();
+    _out_queue_inputs.push_back(input);
+  }
+  _out_queue_credits[input]->AddVC(vc);
+}
+
 void IQRouter::_OutputQueuing( )
 {
-  for(map<int, Credit *>::const_iterator iter = _out_queue_credits.begin();
-      iter != _out_queue_credits.end();
+  sort(_out_queue_inputs.begin(), _out_queue_inputs.end());
+  for(vector<int>::const_iterator iter = _out_queue_inputs.begin();
+      iter != _out_queue_inputs.end();
       ++iter) {
 
-    int const input = iter->first;
+    int const input = *iter;
     assert((input >= 0) && (input < _inputs));
 
-    Credit * const c = iter->second;
+    Credit * const c = _out_queue_credits[input];
     assert(c);
-    assert(!c->vc.empty());
+    assert(c->HasVCs());
 
-    _credit_buffer[input].push(c);
+    _credit_buffer[input].push_back(c);
+    ++_buffered_outputs;
+    _out_queue_credits[input] = NULL;
   }
-  _out_queue_credits.clear();
+  _out_queue_inputs.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -2242,7 +2273,8 @@ void IQRouter::_SendFlits( )
     if ( !_output_buffer[output].empty( ) ) {
       Flit * const f = _output_buffer[output].front( );
       assert(f);
-      _output_buffer[output].pop( );
+      _output_buffer[output].pop_front( );
+      --_buffered_outputs;
 
 #ifdef TRACK_FLOWS
       ++_sent_flits[f->cl][output];
@@ -2267,7 +2299,8 @@ void IQRouter::_SendCredits( )
     if ( !_credit_buffer[input].empty( ) ) {
       Credit * const c = _credit_buffer[input].front( );
       assert(c);
-      _credit_buffer[input].pop( );
+      _credit_buffer[input].pop_front( );
+      --_buffered_outputs;
       _input_credits[input]->Send( c );
     }
   }
@@ -2350,18 +2383,18 @@ void IQRouter::_UpdateNOQ(int input, int vc, Flit const * f) {
   assert(f);
   assert(f->vc == vc);
   assert(f->head);
-  set<OutputSet::sSetElement> sl = f->la_route_set.GetSet();
+  vector<OutputSet::sSetElement> const & sl = f->la_route_set.GetSet();
   assert(sl.size() == 1);
   int out_port = sl.begin()->output_port;
   const FlitChannel * channel = _output_channels[out_port];
   const Router * router = channel->GetSink();
   if(router) {
     int in_channel = channel->GetSinkPort();
-    OutputSet nos;
-    _rf(router, f, in_channel, &nos, false);
-    sl = nos.GetSet();
-    assert(sl.size() == 1);
-    OutputSet::sSetElement const & se = *sl.begin();
+    _noq_route_set.Clear();
+    _rf(router, f, in_channel, &_noq_route_set, false);
+    vector<OutputSet::sSetElement> const & nsl = _noq_route_set.GetSet();
+    assert(nsl.size() == 1);
+    OutputSet::sSetElement const & se = *nsl.begin();
     int next_output_port = se.output_port;
     assert(next_output_port >= 0);
     assert(_noq_next_output_port[input][vc] < 0);
@@ -36,6 +36,8 @@
 
 #include "router.hpp"
 #include "routefunc.hpp"
+#include "outputset.hpp"
+#include "ring_queue.hpp"
 
 using namespace std;
 
@@ -62,23 +64,29 @@ class IQRouter : public Router {
   bool _spec_mask_by_reqs;
   
   bool _active;
+  int _buffered_outputs; // flits and credits in _output_buffer and _credit_buffer
+  bool _fractional_speedup;
 
   int _routing_delay;
   int _vc_alloc_delay;
   int _sw_alloc_delay;
   
-  map<int, Flit *> _in_queue_flits;
+  // in ascending input order, as received
+  vector<pair<int, Flit *> > _in_queue_flits;
 
-  deque<pair<int, pair<Credit *, int> > > _proc_credits;
+  RingQueue<pair<int, pair<Credit *, int> > > _proc_credits;
 
-  deque<pair<int, pair<int, int> > > _route_vcs;
-  deque<pair<int, pair<pair<int, int>, int> > > _vc_alloc_vcs;  
-  deque<pair<int, pair<pair<int, int>, int> > > _sw_hold_vcs;
-  deque<pair<int, pair<pair<int, int>, int> > > _sw_alloc_vcs;
+  RingQueue<pair<int, pair<int, int> > > _route_vcs;
+  RingQueue<pair<int, pair<pair<int, int>, int> > > _vc_alloc_vcs;  
+  RingQueue<pair<int, pair<pair<int, int>, int> > > _sw_hold_vcs;
+  RingQueue<pair<int, pair<pair<int, int>, int> > > _sw_alloc_vcs;
 
-  deque<pair<int, pair<Flit *, pair<int, int> > > > _crossbar_flits;
+  RingQueue<pair<int, pair<Flit *, pair<int, int> > > > _crossbar_flits;
 
-  map<int, Credit *> _out_queue_credits;
+  // credit being assembled for each input this cycle (NULL if none), and
+  // the inputs that have one
+  vector<Credit *> _out_queue_credits;
+  vector<int> _out_queue_inputs;
 
   vector<Buffer *> _buf;
   vector<BufferState *> _next_buf;
@@ -93,9 +101,9 @@ class IQRouter : public Router {
   tRoutingFunction   _rf;
 
   int _output_buffer_size;
-  vector<queue<Flit *> > _output_buffer;
+  vector<RingQueue<Flit *> > _output_buffer;
 
-  vector<queue<Credit *> > _credit_buffer;
+  vector<RingQueue<Credit *> > _credit_buffer;
 
   bool _hold_switch_for_packet;
   vector<int> _switch_hold_in;
@@ -106,6 +114,7 @@ class IQRouter : public Router {
   vector<vector<int> > _noq_next_output_port;
   vector<vector<int> > _noq_next_vc_start;
   vector<vector<int> > _noq_next_vc_end;
+  OutputSet _noq_route_set; // scratch for lookahead routing at the next hop
 
 #ifdef TRACK_FLOWS
   vector<vector<queue<int> > > _outstanding_classes;
@@ -117,6 +126,7 @@ class IQRouter : public Router {
   virtual void _InternalStep( );
 
   bool _SWAllocAddReq(int input, int vc, int output);
+  void _AddOutQueueCredit(int input, int vc);
 
   void _InputQueuing( );
 
@@ -160,6 +170,7 @@ public:
 
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
+  virtual bool Idle( ) const;
   
   void Display( ostream & os = cout ) const;
 
@@ -69,6 +69,15 @@ TimedModule( parent, name ), _id( id ), _inputs( inputs ), _outputs( outputs ),
   _internal_speedup = config.GetFloat( "internal_speedup" );
   _classes          = config.GetInt( "classes" );
 
+  // seeded from the simulation seed and the router's full name, so routers
+  // of different networks get different streams
+  _use_random_stream = ( config.GetInt( "network_threads" ) > 0 );
+  unsigned long long key = 14695981039346656037ULL; // FNV-1a
+  for ( size_t i = 0; i < FullName( ).size( ); ++i ) {
+    key = ( key ^ (unsigned char)FullName( )[i] ) * 1099511628211ULL;
+  }
+  RandomStreamSeed( &_random_stream, config.GetInt( "seed" ), key );
+
 #ifdef TRACK_FLOWS
   _received_flits.resize(_classes, vector<int>(_inputs, 0));
   _stored_flits.resize(_classes);
@@ -104,11 +113,15 @@ void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel
 
 void Router::Evaluate( )
 {
+  if ( _use_random_stream ) {
+    gRandomStream = &_random_stream;
+  }
   _partial_internal_cycles += _internal_speedup;
   while( _partial_internal_cycles >= 1.0 ) {
     _InternalStep( );
     _partial_internal_cycles -= 1.0;
   }
+  gRandomStream = NULL;
 }
 
 void Router::OutChannelFault( int c, bool fault )
@@ -37,6 +37,7 @@
 #include "flitchannel.hpp"
 #include "channel.hpp"
 #include "config_utils.hpp"
+#include "random_utils.hpp"
 
 typedef Channel<Credit> CreditChannel;
 
@@ -65,6 +66,10 @@ protected:
 
   int _crossbar_delay;
   int _credit_delay;
+
+  // own random number stream, used during Evaluate when network_threads is set
+  bool _use_random_stream;
+  RandomStream _random_stream;
   
   vector<FlitChannel *>   _input_channels;
   vector<CreditChannel *> _input_credits;
@@ -110,6 +115,10 @@ public:
     assert((output >= 0) && (output < _outputs));
     return _output_channels[output];
   }
+  inline CreditChannel * GetOutputCredit( int output ) const {
+    assert((output >= 0) && (output < _outputs));
+    return _output_credits[output];
+  }
 
   virtual void ReadInputs( ) = 0;
   virtual void Evaluate( );
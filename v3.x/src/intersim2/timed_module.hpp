@@ -39,6 +39,11 @@ public:
   virtual void ReadInputs() = 0;
   virtual void Evaluate() = 0;
   virtual void WriteOutputs() = 0;
+
+  // true if the next ReadInputs, Evaluate and WriteOutputs have no effect;
+  // routers only look at their own state, not at what their input channels
+  // are about to deliver
+  virtual bool Idle() const { return false; }
 };
 
 #endif
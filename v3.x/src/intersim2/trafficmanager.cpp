@@ -35,7 +35,9 @@
 #include "booksim_config.hpp"
 #include "trafficmanager.hpp"
 #include "batchtrafficmanager.hpp"
+#ifdef CREATE_LIBRARY
 #include "gputrafficmanager.hpp"
+#endif
 #include "random_utils.hpp" 
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
@@ -49,9 +51,12 @@ TrafficManager * TrafficManager::New(Configuration const & config,
     result = new TrafficManager(config, net);
   } else if(sim_type == "batch") {
     result = new BatchTrafficManager(config, net);
-  } else if(sim_type == "gpgpusim") {
+  }
+#ifdef CREATE_LIBRARY
+  else if(sim_type == "gpgpusim") {
     result = new GPUTrafficManager(config, net);
   }
+#endif
   else {
     cerr << "Unknown simulation type: " << sim_type << endl;
   } 
@@ -984,8 +989,7 @@ void TrafficManager::_Step( )
       Credit * const c = _net[subnet]->ReadCredit( n );
       if ( c ) {
 #ifdef TRACK_FLOWS
-        for(set<int>::const_iterator iter = c->vc.begin(); iter != c->vc.end(); ++iter) {
-          int const vc = *iter;
+        for(int vc = c->NextVC(); vc >= 0; vc = c->NextVC(vc)) {
           assert(!_outstanding_classes[n][subnet][vc].empty());
           int cl = _outstanding_classes[n][subnet][vc].front();
           _outstanding_classes[n][subnet][vc].pop();
@@ -1055,7 +1059,7 @@ void TrafficManager::_Step( )
           
           OutputSet route_set;
           _rf(NULL, cf, -1, &route_set, true);
-          set<OutputSet::sSetElement> const & os = route_set.GetSet();
+          vector<OutputSet::sSetElement> const & os = route_set.GetSet();
           assert(os.size() == 1);
           OutputSet::sSetElement const & se = *os.begin();
           assert(se.output_port == -1);
@@ -1082,7 +1086,7 @@ void TrafficManager::_Step( )
               << "Generating lookahead routing info for flit " << cf->id
               << " (NOQ)." << endl;
             }
-            set<OutputSet::sSetElement> const sl = cf->la_route_set.GetSet();
+            vector<OutputSet::sSetElement> const & sl = cf->la_route_set.GetSet();
             assert(sl.size() == 1);
             int next_output = sl.begin()->output_port;
             vc_count /= router->NumOutputs();
@@ -1247,7 +1251,7 @@ void TrafficManager::_Step( )
           << "." << endl;
         }
         Credit * const c = Credit::New();
-        c->vc.insert(f->vc);
+        c->AddVC(f->vc);
         _net[subnet]->WriteCredit(c, n);
         
 #ifdef TRACK_FLOWS
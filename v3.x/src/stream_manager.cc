@@ -152,6 +152,14 @@ void stream_operation::do_operation( gpgpu_sim *gpu )
         break;
     case stream_kernel_launch:
         if( gpu->can_start_kernel() ) {
+            if( gpu->skip_kernel(*m_kernel) ) {
+                // its effects are restored from the checkpoint (-gpgpu_resume_kernel)
+                extern stream_manager *g_stream_manager;
+                printf("kernel \'%s\' skipped\n", m_kernel->name().c_str() );
+                g_stream_manager->register_finished_kernel(m_kernel->get_uid());
+                break;
+            }
+            gpu->kernel_boundary(*m_kernel);
         	gpu->set_cache_config(m_kernel->name());
         	printf("kernel \'%s\' transfer to GPU hardware scheduler\n", m_kernel->name().c_str() );
             if( m_sim_mode )